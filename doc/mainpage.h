@@ -6,6 +6,7 @@
  * \defgroup fileio File input\/output
  * \defgroup operator BDD operators
  * \defgroup reorder Variable reordering
+ * \defgroup image Image computation
  *
  * \mainpage BuDDy: A BDD package
  * \section section0 Programming with BuDDy 
@@ -0,0 +1,264 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "bdd.h"
+#include "image.h"
+
+int N;                 // Number of circuit bits and of cyclers
+int steps;             // Number of image steps for the circuit
+int threshold;         // Cluster size threshold
+
+
+static double now(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+   // Current state variable i is 2i and next state variable i is 2i+1
+static void make_vars(int num, int *cur, int *next, bdd &curset,
+		      bddPair *&tocur)
+{
+   for (int i=0 ; i<num ; i++)
+   {
+      cur[i] = 2*i;
+      next[i] = 2*i+1;
+   }
+   curset = bdd_makeset(cur, num);
+   tocur = bdd_newpair();
+   bdd_setpairs(tocur, next, cur, num);
+}
+
+
+/*************************************************************************
+  A synchronous circuit with y[i] = x[i+1] ^ (x[i] & x[i+N/2]). The
+  transition relation is the conjunction of one partition per bit.
+*************************************************************************/
+
+static void circuit(void)
+{
+   int *cur = new int[N], *next = new int[N];
+   bdd *part = new bdd[N];
+   bdd curset;
+   bddPair *tocur;
+   double start;
+   int i;
+
+   make_vars(N, cur, next, curset, tocur);
+   for (i=0 ; i<N ; i++)
+      part[i] = bdd_biimp(bdd_ithvar(next[i]),
+			  bdd_ithvar(cur[(i+1)%N]) ^
+			  (bdd_ithvar(cur[i]) & bdd_ithvar(cur[(i+N/2)%N])));
+
+   bdd init = bdd_ithvar(cur[0]);
+   for (i=1 ; i<N ; i++)
+      init &= bdd_nithvar(cur[i]);
+
+      // Monolithic relation
+   start = now();
+   bdd T = bdd_and_n(part, N);
+   bdd R = init, S = init;
+   for (i=0 ; i<steps ; i++)
+   {
+      S = bdd_replace(bdd_appex(S, T, bddop_and, curset), tocur);
+      R |= S;
+   }
+   printf("circuit monolithic:  %7.3fs  %ld nodes in T, %.0f states\n",
+	  now()-start, (long)bdd_nodecount(T), bdd_satcountset(R, curset));
+   T = bddfalse;
+   
+      // Partitioned relation
+   start = now();
+   bddImage *img = bdd_newimage(part, N, BDD_IMAGE_CONJ, cur, next, N,
+				threshold);
+   bdd R2 = init;
+   S = init;
+   for (i=0 ; i<steps ; i++)
+   {
+      S = bdd_image(img, S);
+      R2 |= S;
+   }
+   printf("circuit partitioned: %7.3fs  %d clusters, %.0f states\n",
+	  now()-start, bdd_imageclusters(img, 0), bdd_satcountset(R2, curset));
+   if (R != R2)
+      printf("ERROR: the partitioned image differs\n");
+   bdd_freeimage(img);
+
+      // The set and four chunks of the relation in one bdd_appex_n
+   start = now();
+   bdd op[5];
+   for (i=0 ; i<4 ; i++)
+      op[i+1] = bdd_and_n(part + i*N/4, (i+1)*N/4 - i*N/4);
+   bdd R3 = init;
+   S = init;
+   for (i=0 ; i<steps ; i++)
+   {
+      op[0] = S;
+      S = bdd_replace(bdd_appex_n(op, 5, curset), tocur);
+      R3 |= S;
+   }
+   printf("circuit fused:       %7.3fs  5 operands, %.0f states\n",
+	  now()-start, bdd_satcountset(R3, curset));
+   if (R != R3)
+      printf("ERROR: the fused image differs\n");
+   
+   bdd_freepair(tocur);
+   delete[] part;
+   delete[] cur;
+   delete[] next;
+}
+
+
+/*************************************************************************
+  Milner's scheduler with N cyclers (see examples/milner). The
+  transition relation is the disjunction of one partition per cycler.
+*************************************************************************/
+
+static bdd unchanged(bdd *x, bdd *y, int z)
+{
+   bdd res = bddtrue;
+   for (int i=0 ; i<N ; i++)
+      if (i != z)
+	 res &= bdd_biimp(x[i], y[i]);
+   return res;
+}
+
+
+   // Largest sizes seen by bdd_reachable
+static int reachiterations;
+static BDD reachpeak, reachsetpeak;
+
+static void reachstat(bddReachStat *stat)
+{
+   reachiterations = stat->iteration;
+   if (stat->peaksize > reachpeak)
+      reachpeak = stat->peaksize;
+   if (stat->setsize > reachsetpeak)
+      reachsetpeak = stat->setsize;
+}
+
+
+static void milner(void)
+{
+   int *cur = new int[3*N], *next = new int[3*N];
+   bdd *c = new bdd[N], *cp = new bdd[N], *t = new bdd[N], *tp = new bdd[N];
+   bdd *h = new bdd[N], *hp = new bdd[N];
+   bdd *part = new bdd[N];
+   bdd curset;
+   bddPair *tocur;
+   double start;
+   int i;
+
+   make_vars(3*N, cur, next, curset, tocur);
+   for (i=0 ; i<N ; i++)
+   {
+      c[i] = bdd_ithvar(cur[3*i]);    cp[i] = bdd_ithvar(next[3*i]);
+      t[i] = bdd_ithvar(cur[3*i+1]);  tp[i] = bdd_ithvar(next[3*i+1]);
+      h[i] = bdd_ithvar(cur[3*i+2]);  hp[i] = bdd_ithvar(next[3*i+2]);
+   }
+
+   for (i=0 ; i<N ; i++)
+   {
+      bdd P = ((c[i] > cp[i]) & (tp[i] > t[i]) & hp[i] & unchanged(c,cp,i)
+	       & unchanged(t,tp,i) & unchanged(h,hp,i))
+	 | ((h[i] > hp[i]) & cp[(i+1)%N] & unchanged(c,cp,(i+1)%N)
+	    & unchanged(h,hp,i) & unchanged(t,tp,N));
+      bdd E = t[i] & !tp[i] & unchanged(t,tp,i) & unchanged(h,hp,N)
+	 & unchanged(c,cp,N);
+      part[i] = P | E;
+   }
+
+   bdd init = c[0] & !h[0] & !t[0];
+   for (i=1 ; i<N ; i++)
+      init &= !c[i] & !h[i] & !t[i];
+
+      // Monolithic relation
+   start = now();
+   bdd T = bdd_or_n(part, N);
+   bdd R = init, prev;
+   do
+   {
+      prev = R;
+      R |= bdd_replace(bdd_appex(R, T, bddop_and, curset), tocur);
+   }
+   while (prev != R);
+   printf("milner monolithic:   %7.3fs  %ld nodes in T, %.0f states\n",
+	  now()-start, (long)bdd_nodecount(T), bdd_satcountset(R, curset));
+   T = bddfalse;
+
+      // Partitioned relation
+   start = now();
+   bddImage *img = bdd_newimage(part, N, BDD_IMAGE_DISJ, cur, next, 3*N,
+				threshold);
+   bdd R2 = init;
+   do
+   {
+      prev = R2;
+      R2 |= bdd_image(img, R2);
+   }
+   while (prev != R2);
+   printf("milner partitioned:  %7.3fs  %d clusters, %.0f states\n",
+	  now()-start, bdd_imageclusters(img, 0), bdd_satcountset(R2, curset));
+   if (R != R2)
+      printf("ERROR: the partitioned image differs\n");
+
+   bdd_freeimage(img);
+
+      // Local events without frame conditions: cycler i takes the token,
+      // passes it on to cycler i+1 or ends its task
+   bdd *event = new bdd[3*N];
+   for (i=0 ; i<N ; i++)
+   {
+      event[3*i] = (c[i] > cp[i]) & (tp[i] > t[i]) & hp[i];
+      event[3*i+1] = (h[i] > hp[i]) & cp[(i+1)%N];
+      event[3*i+2] = t[i] & !tp[i];
+   }
+   img = bdd_newimage(event, 3*N, BDD_IMAGE_EVENT, cur, next, 3*N, 0);
+
+   static const char *method[] = { "bfs:", "chaining:", "saturation:" };
+   for (int m=BDD_REACH_BFS ; m<=BDD_REACH_SAT ; m++)
+   {
+      reachiterations = reachpeak = reachsetpeak = 0;
+      start = now();
+      bdd R3 = bdd_reachable(img, init, m, reachstat);
+      printf("milner %-14s%7.3fs  %d iterations, %ld/%ld peak image/set"
+	     " nodes, %.0f states\n", method[m], now()-start,
+	     reachiterations, (long)reachpeak, (long)reachsetpeak,
+	     bdd_satcountset(R3, curset));
+      if (R != R3)
+	 printf("ERROR: the reachable states differ\n");
+   }
+
+   bdd_freeimage(img);
+   bdd_freepair(tocur);
+   delete[] event;
+   delete[] part;
+   delete[] c; delete[] cp; delete[] t; delete[] tp; delete[] h; delete[] hp;
+   delete[] cur;
+   delete[] next;
+}
+
+
+int main(int argc, char **argv)
+{
+   N = (argc > 1 ? atoi(argv[1]) : 20);
+   steps = (argc > 2 ? atoi(argv[2]) : 16);
+   threshold = (argc > 3 ? atoi(argv[3]) : 1000);
+   if (N < 2  ||  steps < 0  ||  threshold < 0)
+   {
+      fprintf(stderr, "usage: imagebench [N] [steps] [threshold]\n");
+      exit(1);
+   }
+
+   bdd_init(1000000, 100000);
+   bdd_setvarnum(6*N);
+   bdd_gbc_hook(NULL);
+
+   circuit();
+   milner();
+
+   bdd_done();
+   return 0;
+}
@@ -37,18 +37,19 @@ bdd queen;            /* N-queen problem express as a BDD */
    that (i,j) has a queen */
 void build(int i, int j)
 {
-   bdd a=bddtrue, b=bddtrue, c=bddtrue, d=bddtrue;
+   bdd *c = new bdd[4*N];
+   int num = 0;
    int k,l;
    
       /* No one in the same column */
    for (l=0 ; l<N ; l++)
       if (l != j)
-	 a &= X[i][j] >> !X[i][l];
+	 c[num++] = X[i][j] >> !X[i][l];
 
       /* No one in the same row */
    for (k=0 ; k<N ; k++)
       if (k != i)
-	 b &= X[i][j] >> !X[k][j];
+	 c[num++] = X[i][j] >> !X[k][j];
 
       /* No one in the same up-right diagonal */
    for (k=0 ; k<N ; k++)
@@ -56,7 +57,7 @@ void build(int i, int j)
       int ll = k-i+j;
       if (ll>=0 && ll<N)
 	 if (k != i)
-	    c &= X[i][j] >> !X[k][ll];
+	    c[num++] = X[i][j] >> !X[k][ll];
    }
 
       /* No one in the same down-right diagonal */
@@ -65,10 +66,11 @@ void build(int i, int j)
       int ll = i+j-k;
       if (ll>=0 && ll<N)
 	 if (k != i)
-	    d &= X[i][j] >> !X[k][ll];
+	    c[num++] = X[i][j] >> !X[k][ll];
    }
 
-   queen &= a & b & c & d;
+   queen &= bdd_and_n(c, num);
+   delete[] c;
 }
 
 
@@ -107,12 +109,7 @@ int main(int ac, char **av)
 
       /* Place a queen in each row */
    for (i=0 ; i<N ; i++)
-   {
-      bdd e = bddfalse;
-      for (j=0 ; j<N ; j++)
-	 e |= X[i][j];
-      queen &= e;
-   }
+      queen &= bdd_or_n(X[i], N);
    
       /* Build requirements for each variable(field) */
    for (i=0 ; i<N ; i++)
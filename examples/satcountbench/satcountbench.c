@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "bdd.h"
+
+int N;          /* Number of variables */
+int R;          /* Number of rounds */
+
+
+static double now(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+   /* A state space over N variables: every set variable must be followed
+      by a set variable within the next k positions */
+static BDD statespace(int k)
+{
+   BDD r = bddtrue;
+   int i, j;
+
+   for (i=N-1 ; i>=0 ; i--)
+   {
+      BDD next = bddfalse, tmp, imp;
+
+      for (j=i+1 ; j<=i+k  &&  j<N ; j++)
+      {
+	 tmp = bdd_addref(bdd_or(next, bdd_ithvar(j)));
+	 bdd_delref(next);
+	 next = tmp;
+      }
+      
+      imp = bdd_addref(bdd_imp(bdd_ithvar(i), i+1 < N ? next : bddtrue));
+      bdd_delref(next);
+      tmp = bdd_addref(bdd_and(r, imp));
+      bdd_delref(r);
+      bdd_delref(imp);
+      r = tmp;
+   }
+
+   return r;
+}
+
+
+   /* Count all the state spaces R times. The garbage collection before
+      each round empties the operator caches. */
+static void run(const char *name, BDD *space, int num, int which)
+{
+   double start, time = 0.0, sum = 0.0;
+   int round, n, size;
+
+   for (round=0 ; round<R ; round++)
+   {
+      bdd_gbc();
+      start = now();
+      for (n=0 ; n<num ; n++)
+      {
+	 if (which == 0)
+	    sum += bdd_satcountln(space[n]);
+	 else
+	 {
+	    unsigned int *words = bdd_satcountexact(space[n], &size);
+	    sum += size;
+	    free(words);
+	 }
+      }
+      time += now() - start;
+   }
+
+   printf("%-24s %8.3fs (%g)\n", name, time, sum);
+   fflush(stdout);
+}
+
+
+int main(int argc, char** argv)
+{
+   BDD space[4];
+   char *str;
+   int threads, n;
+   
+   N = argc > 1 ? atoi(argv[1]) : 5000;
+   R = argc > 2 ? atoi(argv[2]) : 10;
+   threads = argc > 3 ? atoi(argv[3]) : 4;
+
+   if (N < 2  ||  R < 1  ||  threads < 1)
+   {
+      fprintf(stderr, "usage: satcountbench [vars] [rounds] [threads]\n");
+      exit(1);
+   }
+
+   bdd_init(1000000, 100000);
+   bdd_setvarnum(N);
+   bdd_gbc_hook(NULL);
+
+   for (n=0 ; n<4 ; n++)
+      space[n] = statespace(n+2);
+
+   printf("%d variables, %ld nodes\n", N, (long)bdd_anodecount(space, 4));
+   for (n=0 ; n<4 ; n++)
+   {
+      str = bdd_satcountstr(space[n]);
+      printf("space %d: satcount %g, log2 %.3f, %d digits\n", n,
+	     bdd_satcount(space[n]), bdd_satcountln(space[n]),
+	     (int)strlen(str));
+      free(str);
+   }
+   
+   run("satcountln", space, 4, 0);
+   run("satcountexact", space, 4, 1);
+
+   bdd_setcountmemo(1);
+   run("satcountln memo", space, 4, 0);
+   run("satcountexact memo", space, 4, 1);
+   bdd_setcountmemo(0);
+
+      /* Without thread support bdd_setthreads has no effect */
+   bdd_setthreads(threads);
+   if (bdd_setthreads(threads) == threads  &&  threads > 1)
+   {
+      char name[32];
+      sprintf(name, "satcountexact %d threads", threads);
+      run(name, space, 4, 1);
+   }
+   
+   bdd_done();
+   return 0;
+}
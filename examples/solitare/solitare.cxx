@@ -90,15 +90,16 @@ void make_initial_state(void)
 // there's a move from 'src' to 'dst' over 'tmp'
 bdd all_other_idle(int src, int tmp, int dst)
 {
-   bdd idle = bddtrue;
+   bdd idle[SIZE];
+   int num = 0;
    
    for (int n=0 ; n<SIZE ; n++)
    {
       if (n != src  &&  n != tmp  &&  n != dst)
-	 idle &= bdd_biimp(boardC[n], boardN[n]);
+	 idle[num++] = bdd_biimp(boardC[n], boardN[n]);
    }
 
-   return idle;
+   return bdd_and_n(idle, num);
 }
 
 
@@ -117,10 +118,12 @@ bdd make_move(int src, int tmp, int dst)
 void make_transition_relation(void)
 {
    using namespace std ;
-   T = bddfalse;
+   bdd move[sizeof(moves)/sizeof(moves[0])];
+   int num = 0;
    
    for (int n=0 ; moves[n][0]!=moves[n][1] ; n++)
-      T |= make_move(moves[n][0]-1, moves[n][1]-1, moves[n][2]-1);
+      move[num++] = make_move(moves[n][0]-1, moves[n][1]-1, moves[n][2]-1);
+   T = bdd_or_n(move, num);
 
    cout << "Transition relation: " << bdd_nodecount(T) << " nodes, "
 	<< bdd_satcount(T)/dummyStateNum << " states\n";
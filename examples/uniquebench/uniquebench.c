@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "bdd.h"
+
+int N;          /* Number of x (and y) variables */
+
+
+static double now(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+   /* Build x0=y0 & ... & xN-1=yN-1 and report the insertion rate */
+static void run(int threads, int kind)
+{
+   bddStat stat;
+   BDD r = bddtrue;
+   long int produced;
+   double start, time;
+   int i;
+   
+   bdd_init(1 << (N+2), 100000);
+   bdd_setvarnum(2*N);
+   bdd_gbc_hook(NULL);
+   bdd_setcacheratio(4);
+   bdd_setthreads(threads);
+   bdd_setuniquetable(kind);
+
+   bdd_stats(&stat);
+   produced = stat.produced;
+   start = now();
+   
+   for (i=0 ; i<N ; i++)
+   {
+      BDD eq = bdd_addref(bdd_biimp(bdd_ithvar(i), bdd_ithvar(N+i)));
+      BDD tmp = bdd_addref(bdd_and(r, eq));
+      bdd_delref(r);
+      bdd_delref(eq);
+      r = tmp;
+   }
+
+   time = now() - start;
+   bdd_stats(&stat);
+   produced = stat.produced - produced;
+   
+   printf("%-8s %3d threads: %9ld nodes in %6.2fs = %10.0f nodes/s\n",
+	  kind == BDD_UNIQUE_OPEN ? "open" : "chained", threads,
+	  produced, time, time > 0.0 ? produced / time : 0.0);
+   fflush(stdout);
+   
+   bdd_delref(r);
+   bdd_done();
+}
+
+
+int main(int argc, char** argv)
+{
+   int maxthreads, threads;
+   
+   N = argc > 1 ? atoi(argv[1]) : 18;
+   maxthreads = argc > 2 ? atoi(argv[2]) : 8;
+
+   if (N < 1  ||  N > 24  ||  maxthreads < 1)
+   {
+      fprintf(stderr, "usage: uniquebench [N] [max. threads]\n");
+      exit(1);
+   }
+   
+      /* Without thread support bdd_setthreads has no effect */
+   bdd_setthreads(2);
+   if (bdd_setthreads(1) != 2)
+      maxthreads = 1;
+   
+   for (threads=1 ; threads<=maxthreads ; threads*=2)
+   {
+      run(threads, BDD_UNIQUE_CHAINED);
+      run(threads, BDD_UNIQUE_OPEN);
+   }
+   
+   return 0;
+}
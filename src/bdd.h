@@ -46,6 +46,7 @@
 #endif
 
 #include <stdio.h>
+#include "bddconfig.h"
 
 /*=== Defined operators for apply calls ================================*/
 
@@ -69,8 +70,22 @@
 
 /**
  * Data type for representing BDDs.  
- */
+ *
+ * A BDD is an index into the node table. When the package is configured
+ * with `--enable-64bit-nodes` the macro BDD_INDEX64 is defined and a BDD
+ * is a 64 bit integer, which allows node tables beyond 2^31 nodes.
+ * The setting is recorded in the installed header bddconfig.h, which
+ * this file includes, so applications always use the BDD type of the
+ * library. Defining BDD_INDEX64 for a 32 bit library is an error.
+ * Node counts that may exceed 2^31 (like ::bdd_getallocnum,
+ * ::bdd_nodecount, ::bdd_anodecount, ::bdd_anodeprofile and the fields of
+ * ::bddRootProfile) use the same type.
+ */
+#ifdef BDD_INDEX64
+typedef long long BDD;
+#else
 typedef int BDD;
+#endif
 
 #ifndef CPLUSPLUS
 
@@ -91,6 +106,12 @@ typedef struct s_bddPair
    struct s_bddPair *next;
 } bddPair;
 
+/**
+ * Data type for a BDD manager. A manager holds a complete and independent BDD universe
+ * (see ::bdd_newmanager).
+ */
+typedef struct s_BddManager bddManager;
+
 
 /*=== Status information ===============================================*/
 
@@ -104,13 +125,14 @@ typedef struct s_bddPair
 typedef struct s_bddStat
 {
    long int produced;		/**< Total number of new nodes ever produced.*/	
-   int nodenum;				/**< Currently allocated number of bdd nodes. */
-   int maxnodenum;			/**< User defined maximum number of bdd nodes. */
-   int freenodes;			/**< Number of currently free nodes. */
+   BDD nodenum;				/**< Currently allocated number of bdd nodes. */
+   BDD maxnodenum;			/**< User defined maximum number of bdd nodes. */
+   BDD freenodes;			/**< Number of currently free nodes. */
    int minfreenodes;		/**< Minimum number of nodes that should be left after a garbage collection. */
    int varnum;				/**< Number of defined bdd variables. */
    int cachesize;			/**< Number of entries in the internal caches. */
    int gbcnum;				/**< Number of garbage collections done until now. */   
+   int opdepth;				/**< Largest depth of the stack of the iterative operators (see ::bdd_setengine). */
 } bddStat;
 
 
@@ -123,8 +145,8 @@ typedef struct s_bddStat
  */
 typedef struct s_bddGbcStat
 {
-   int nodes;		/**< Total number of allocated nodes in the nodetable. */
-   int freenodes;	/**< Number of free nodes in the nodetable. */
+   BDD nodes;		/**< Total number of allocated nodes in the nodetable. */
+   BDD freenodes;	/**< Number of free nodes in the nodetable. */
    long time;		/**< Time used for garbage collection this time. */
    long sumtime;	/**< Total time used for garbage collection. */
    int num;			/**< Number of garbage collections done until now. */
@@ -149,6 +171,97 @@ typedef struct s_bddCacheStat
    long unsigned int swapCount;		/**< Number of variable swaps in reordering. */
 } bddCacheStat;
 
+
+/**
+ * \ingroup kernel
+ * 
+ * Usage of one operator cache and the size chosen for it by the adaptive cache sizing.
+ * 
+ * \see bdd_setcachebudget, bdd_cache_hook
+ */
+typedef struct s_bddCacheAdapt
+{
+   const char *name;			/**< Name of the cache: "apply", "ite", "quant", "appex", "replace", "misc" or "test". */
+   int oldsize;				/**< Number of entries before the decision. */
+   int newsize;				/**< Number of entries after the decision. */
+   long unsigned int hits;		/**< Lookups that found their entry since the last decision. */
+   long unsigned int misses;		/**< Lookups that did not find their entry since the last decision. */
+   long unsigned int overwrites;	/**< Misses that replaced another entry since the last decision. */
+} bddCacheAdapt;
+
+
+/**
+ * Number of operator caches reported in ::bddStatSnapshot.
+ */
+#define BDD_CACHENUM   7
+
+/**
+ * Number of operators reported in ::bddStatSnapshot.
+ */
+#define BDD_OPSTATNUM  24
+
+/**
+ * \ingroup kernel
+ *
+ * Total usage of one operator cache since ::bdd_init.
+ *
+ * \see bddStatSnapshot
+ */
+typedef struct s_bddCacheUsage
+{
+   const char *name;			/**< Name of the cache: "apply", "ite", "quant", "appex", "replace", "misc" or "test". */
+   int size;				/**< Current number of entries. */
+   long unsigned int lookups;		/**< Number of lookups. */
+   long unsigned int hits;		/**< Number of lookups that found their entry. */
+   long unsigned int overwrites;	/**< Number of misses that replaced another entry. */
+   long unsigned int resizes;		/**< Number of times the cache was resized. */
+} bddCacheUsage;
+
+
+/**
+ * \ingroup kernel
+ *
+ * Calls of one top level operator since ::bdd_init.
+ *
+ * \see bddStatSnapshot
+ */
+typedef struct s_bddOpStat
+{
+   const char *name;			/**< Name of the operator, like "apply" for ::bdd_apply. */
+   long unsigned int calls;		/**< Number of calls. */
+   long time;				/**< Clock ticks used, when enabled by ::bdd_setstattime. */
+} bddOpStat;
+
+
+/**
+ * \ingroup kernel
+ *
+ * All statistics of the package at one point in time.
+ *
+ * \see bdd_statsnapshot, bdd_fdumpstat
+ */
+typedef struct s_bddStatSnapshot
+{
+   bddStat kernel;			/**< Status of the node table, as from ::bdd_stats. */
+   bddCacheStat cache;			/**< Cache statistics, as from ::bdd_cachestats. */
+   long gbctime;			/**< Clock ticks used for garbage collection. */
+   bddCacheUsage opcache[BDD_CACHENUM];	/**< Usage of the operator caches. */
+   bddOpStat op[BDD_OPSTATNUM];		/**< Calls of the operators. */
+} bddStatSnapshot;
+
+
+/**
+ * \ingroup info
+ *
+ * Node counts of one of the BDDs given to ::bdd_anodeprofile.
+ */
+typedef struct s_bddRootProfile
+{
+   BDD total;				/**< Number of nodes in the BDD, as from ::bdd_nodecount. */
+   BDD exclusive;			/**< Nodes that are not used by any of the other BDDs. */
+   BDD shared;				/**< Nodes that are also used by other BDDs. */
+} bddRootProfile;
+
 /*=== BDD interface prototypes =========================================*/
 
 /**
@@ -185,11 +298,15 @@ typedef void (*bdd2inthandler)(int,int);
 /**
  * Data type for BDD minimization handlers for use with ::bdd_resize_hook.
  */
-typedef int  (*bddsizehandler)(void);
+typedef BDD  (*bddsizehandler)(void);
 /**
  * Data type for printing handlers for use with ::bdd_file_hook.
  */
 typedef void (*bddfilehandler)(FILE *, int);
+/**
+ * Data type for cache sizing handlers for use with ::bdd_cache_hook.
+ */
+typedef void (*bddcachehandler)(bddCacheAdapt*);
 /**
  * Data type for satisfying assignment handlers for use with ::bdd_allsat.
  */
@@ -327,7 +444,11 @@ extern bddfilehandler bdd_file_hook(bddfilehandler handler);
  * examples. The number of cache entries can also be set to depend on the size of the nodetable
  * using a call to ::bdd_setcacheratio. The initial number of nodes is not critical for any bdd
  * operation as the table will be resized whenever there are to few nodes left after a garbage
- * collection. But it does have some impact on the efficency of the operations.
+ * collection. But it does have some impact on the efficency of the operations. Cache sizes
+ * are rounded up to a prime, or to a power of two when the package is configured with
+ * \c --enable-packed-cache. When configured with \c --enable-assoc-cache the caches are two-way
+ * set associative, so that two results hashing to the same place can both be kept, with the
+ * same total number of entries.
  * 
  * \return If no errors occur then 0 is returned, otherwise a negative error code.
  * \see bdd_done, bdd_resize_hook
@@ -346,6 +467,70 @@ extern int      bdd_init(int nodesize, int cachesize);
  */
 extern void     bdd_done(void);
 
+  /* In manager.c */
+
+/**
+ * \ingroup kernel
+ * \brief Creates a new BDD manager.
+ *
+ * A manager holds all the state of the bdd package: the node table, operator caches,
+ * variable order, replacement pairs, finite domains and so on. All functions in the package
+ * work on the current manager of the calling thread, which is selected with
+ * ::bdd_setmanager. Each thread starts out with the same main manager, so programs that do not
+ * use managers are not affected.
+ *
+ * The new manager is not initialized - make it the current manager and call ::bdd_init before
+ * using it. Different threads may work on different managers at the same time, but a manager
+ * must only be used by one thread at a time. BDDs from one manager cannot be used in another.
+ * 
+ * \return The new manager or \c NULL if out of memory.
+ * \see bdd_setmanager, bdd_deletemanager
+ */
+extern bddManager *bdd_newmanager(void);
+
+
+/**
+ * \ingroup kernel
+ * \brief Deletes a BDD manager.
+ *
+ * Calls ::bdd_done on the manager \a m if it is initialized and frees it. If \a m is the
+ * current manager of the calling thread then the main manager becomes the current one. The
+ * main manager cannot be deleted.
+ * 
+ * \return Zero on success, otherwise a negative error code.
+ * \see bdd_newmanager
+ */
+extern int      bdd_deletemanager(bddManager *m);
+
+
+/**
+ * \ingroup kernel
+ * \brief Selects the current BDD manager.
+ *
+ * Makes \a m the manager used by all following calls to the package from the calling thread.
+ * Passing \c NULL selects the main manager.
+ *
+ * A BDD number does not record which manager it belongs to, so the C functions must be
+ * called with the manager of their arguments current. The C++ classes ::bdd and ::bvec
+ * record the manager that was current when they got their nodes, and copying, assigning
+ * and destroying them changes the reference counts in that manager whatever manager is
+ * current. Operations on them still work in the current manager. The objects must be
+ * destroyed before their manager is deleted.
+ * 
+ * \return The previous manager of the calling thread.
+ * \see bdd_getmanager, bdd_newmanager
+ */
+extern bddManager *bdd_setmanager(bddManager *m);
+
+
+/**
+ * \ingroup kernel
+ * \brief Returns the current BDD manager of the calling thread.
+ *
+ * \see bdd_setmanager
+ */
+extern bddManager *bdd_getmanager(void);
+
 
 /**
  * \ingroup kernel
@@ -399,7 +584,7 @@ extern int      bdd_isrunning(void);
  * \return The old threshold on success, otherwise a negative error code.
  * \see bdd_setmaxincrease, bdd_setminfreenodes
  */
-extern int      bdd_setmaxnodenum(int size);
+extern BDD      bdd_setmaxnodenum(BDD size);
 
 
 /**
@@ -413,7 +598,7 @@ extern int      bdd_setmaxnodenum(int size);
  * \return The old threshold on succes, otherwise a negative error code.
  * \see bdd_setmaxnodenum, bdd_setminfreenodes
  */
-extern int      bdd_setmaxincrease(int size);
+extern BDD      bdd_setmaxincrease(BDD size);
 
 
 /**
@@ -443,7 +628,7 @@ extern int      bdd_setminfreenodes(int mf);
  * \return The number of nodes.
  * \see bdd_getallocnum, bdd_setmaxnodenum
  */
-extern int      bdd_getnodenum(void);
+extern BDD      bdd_getnodenum(void);
 
 
 /**
@@ -455,7 +640,7 @@ extern int      bdd_getnodenum(void);
  * \return The number of nodes.
  * \see bdd_getnodenum, bdd_setmaxnodenum
  */
-extern int      bdd_getallocnum(void);
+extern BDD      bdd_getallocnum(void);
 
 
 /**
@@ -498,8 +683,8 @@ extern void     bdd_stats(bddStat *stat);
  * \brief Fetch cache access usage.
  *
  * Fetches cache usage information and stores it in \a s. The fields of \a s can be found in the
- * documentation for ::bddCacheStat. This function may or may not be compiled into the BuDDy
- * package - depending on the setup at compile time of BuDDy.
+ * documentation for ::bddCacheStat. The operator cache counts are always available, while
+ * the unique table counts are only collected when BuDDy is compiled with \c CACHESTATS.
  * 
  * \see bddCacheStat, bdd_printstat
  */
@@ -513,9 +698,10 @@ extern void     bdd_cachestats(bddCacheStat *s);
  * Prints information about the cache performance to the supplied file \a f.
  * The information contains the number of accesses to the unique node table, the number of
  * times a node was (not) found there and how many times a hash chain had to traversed. Hit and
- * miss count is also given for the operator caches.
+ * miss count is also given for the operator caches, in total and for each cache, followed by
+ * the calls of the operators.
  * 
- * \see bddCacheStat, bdd_cachestats, bdd_printstat
+ * \see bddCacheStat, bdd_cachestats, bdd_printstat, bdd_fdumpstat
  */
 extern void     bdd_fprintstat(FILE *f);
 
@@ -534,6 +720,32 @@ extern void     bdd_fprintstat(FILE *f);
 extern void     bdd_printstat(void);
 
 
+/**
+ * \ingroup kernel
+ * \brief Take a snapshot of all statistics.
+ *
+ * Stores the status of the node table, the cache statistics, the total usage of each operator
+ * cache and the number of calls (and optionally the time used) of each top level operator in
+ * \a s. The counts are kept since ::bdd_init, so the work done by a part of a program is the
+ * difference of two snapshots.
+ *
+ * \see bddStatSnapshot, bdd_fdumpstat, bdd_setstattime
+ */
+extern void     bdd_statsnapshot(bddStatSnapshot *s);
+
+
+/**
+ * \ingroup kernel
+ * \brief Dump all statistics to a file in a machine readable form.
+ *
+ * Writes the contents of a ::bdd_statsnapshot to \a f as one JSON object, with the caches and
+ * operators as arrays of objects. Times are given in seconds.
+ *
+ * \see bdd_statsnapshot, bdd_fprintstat
+ */
+extern void     bdd_fdumpstat(FILE *f);
+
+
 /**
  * \ingroup kernel
  * \brief Default garbage collection handler.
@@ -711,7 +923,8 @@ extern int      bdd_varlevel(int);
  *
  * Reference counting is done on externaly referenced nodes only and the count for a specific
  * node \a r can and must be increased using this function to avoid loosing the node in the next
- * garbage collection.
+ * garbage collection. The count is exact no matter how many references a node gets, so the
+ * node can be reclaimed once all of them are removed again.
  * 
  * \see bdd_delref
  * \return The BDD node \a r.
@@ -743,6 +956,24 @@ extern BDD      bdd_delref(BDD r);
  */
 extern void     bdd_gbc(void);
 
+/**
+ * \ingroup kernel
+ * \brief Compacts the node table.
+ *
+ * Garbage collects and renumbers the live nodes so that they are stored densely at the start
+ * of the node table in depth first order, which gives better cache locality when traversing
+ * them, and then shrinks the node table so its memory is returned. The \a num node
+ * references in \a roots are updated to the new numbers. A node that has references not
+ * given in \a roots keeps its number, since these references cannot be updated, and so do
+ * the variable nodes. All other BDDs held by the user are invalid after the call. The operator
+ * caches are cleared. Must not be called from the handlers of the package. In C++ the roots
+ * are an array of \c bdd objects.
+ * 
+ * \return Zero on success, otherwise a negative error code.
+ * \see bdd_gbc
+ */
+extern int      bdd_compact(BDD *roots, int num);
+
 
 /**
  * \ingroup kernel
@@ -887,6 +1118,175 @@ extern void     bdd_freepair(bddPair *p);
 extern int      bdd_setcacheratio(int r);
 
 
+/**
+ * \ingroup kernel
+ * \brief Selects how the operators recurse over the BDDs.
+ *
+ * With \c BDD_ENGINE_RECURSIVE (the default) ::bdd_apply, ::bdd_ite, ::bdd_exist,
+ * ::bdd_forall, ::bdd_unique, ::bdd_appex, ::bdd_appall and ::bdd_appuni recurse on the C
+ * stack once for each level of the BDDs. With \c BDD_ENGINE_ITERATIVE they keep their
+ * pending work in an explicit stack on the heap instead, so the depth of the C stack no longer
+ * grows with the number of variables. Both give the same results. The largest depth of the
+ * explicit stack is reported by ::bdd_stats. The setting is reset by ::bdd_done.
+ * 
+ * \return The previous setting or a negative number on error.
+ * \see bdd_stats
+ */
+extern int      bdd_setengine(int kind);
+
+
+/**
+ * \ingroup kernel
+ * \brief Selects how ::bdd_apply_n combines its operands.
+ *
+ * With \c BDD_NARY_SIZE (the default) the operands are merged two at a time with
+ * ::bdd_apply, always taking the two with the fewest nodes from a priority queue.
+ * With \c BDD_NARY_SUPPORT the smallest operand is merged with the one sharing most
+ * variables with it. With \c BDD_NARY_RECURSIVE all operands are combined in a single
+ * recursion over their levels, which uses a cache of its own. All give the same results.
+ * The setting is reset by ::bdd_done.
+ * 
+ * \return The previous setting or a negative number on error.
+ * \see bdd_apply_n
+ */
+extern int      bdd_setnaryschedule(int mode);
+
+
+/**
+ * \ingroup kernel
+ * \brief Selects what happens to the operator caches at garbage collections.
+ *
+ * With \c BDD_CACHE_RESET (the default) every garbage collection empties all the operator
+ * caches. With \c BDD_CACHE_SELECTIVE only the entries that refer to a node freed by the
+ * garbage collection are removed, so results computed before the collection can still be
+ * found afterwards. This pays off when garbage collections are frequent compared to the work
+ * done between them, as in fixed point iterations. The caches are still emptied completely
+ * when the node table is resized or the variables are reordered. The setting is reset by
+ * ::bdd_done.
+ * 
+ * \return The previous setting or a negative number on error.
+ * \see bdd_gbc, bdd_setcacheratio
+ */
+extern int      bdd_setcachemode(int mode);
+
+
+/**
+ * \ingroup kernel
+ * \brief Sizes the operator caches adaptively within a budget.
+ *
+ * With a positive \a budget the seven operator caches are sized individually from how they are
+ * used, and together they never hold more than \a budget entries (of 16 to 32 bytes each). The
+ * caches count their hits, misses and misses that overwrite another entry. Once they have been
+ * looked up about as many times as they have entries, a cache that had at least half its
+ * entries overwritten is doubled if the budget allows, taking the space from the least used
+ * cache if needed, and a cache looked up less than once per sixteen entries is halved. A cache
+ * that changes size is emptied. The decisions are reported to the handler set by
+ * ::bdd_cache_hook. A budget of zero (the default) gives all caches the fixed size set by
+ * ::bdd_init or ::bdd_setcacheratio, which is ignored while a budget is set. A positive
+ * budget must allow each cache at least 1024 entries, that is 7*1024 in all, or ::BDD_RANGE
+ * is returned. The budget is reset by ::bdd_done.
+ * 
+ * \return The previous budget or a negative number on error.
+ * \see bdd_cache_hook, bdd_setcacheratio
+ */
+extern int      bdd_setcachebudget(int budget);
+
+
+/**
+ * \ingroup kernel
+ * \brief Set a handler for the adaptive cache sizing.
+ *
+ * Each time the adaptive cache sizing set up by ::bdd_setcachebudget revises the cache sizes,
+ * the handler is called once for each cache with its usage since the last revision and its old
+ * and new size. If a \c NULL argument is supplied then no calls are made. No default handler
+ * is supplied. Any handler should be defined like this: 
+ * \code
+ * void my_cache_handler(bddCacheAdapt *stat) { ... } 
+ * \endcode
+ * 
+ * \return The previous handler.
+ * \see bdd_setcachebudget
+ */
+extern bddcachehandler bdd_cache_hook(bddcachehandler handler);
+
+
+/**
+ * \ingroup kernel
+ * \brief Enable timing of the operators.
+ *
+ * The calls of the top level operators are always counted. If \a enable is non-zero the
+ * clock is also read at the start and end of each call and the time used is added to the
+ * statistics of ::bdd_statsnapshot. This is off by default since reading the clock may cost
+ * more than a small operation. The setting is reset by ::bdd_done.
+ *
+ * \return The previous setting.
+ * \see bdd_statsnapshot
+ */
+extern int      bdd_setstattime(int enable);
+
+
+/**
+ * \ingroup kernel
+ * \brief Keep the counts of ::bdd_satcount and friends per node.
+ *
+ * By default ::bdd_satcount, ::bdd_satcountln and ::bdd_pathcount (and the functions built on
+ * them) keep intermediate results in an operator cache, which is emptied by each garbage
+ * collection and shared with other operators. If \a enable is non-zero the counts are kept
+ * in a memo with an entry for each node of the node table instead (32 bytes per node). The
+ * entries stay valid until their node is freed by a garbage collection, the variables are
+ * reordered or variables are added, so counting many BDDs that share nodes, also across
+ * garbage collections, only counts each node once. The memo also keeps the counts of
+ * ::bdd_satcountexact (8 more bytes per node), which otherwise only last for a single call.
+ * Disabling the memo frees it. The setting is reset by ::bdd_done.
+ *
+ * \return The previous setting.
+ * \see bdd_satcount, bdd_pathcount
+ */
+extern int      bdd_setcountmemo(int enable);
+
+  /* In parallel.c */
+
+/**
+ * \ingroup kernel
+ * \brief Sets the number of threads used by the operators.
+ *
+ * With more than one thread the operators ::bdd_apply, ::bdd_ite, ::bdd_exist,
+ * ::bdd_forall, ::bdd_unique, ::bdd_appex, ::bdd_appall and ::bdd_appuni split their
+ * recursion over a pool of \a num threads (including the calling thread). So do the
+ * traversals of ::bdd_satcount, ::bdd_satcountexact, ::bdd_nodecount, ::bdd_anodecount and
+ * ::bdd_varprofile. The latter three mark the visited nodes in a bitmap per thread (one bit
+ * per node of the node table) instead of in the nodes themselves. The other
+ * operators and all user code still run sequentially, so the package must only be called
+ * from one thread at a time. The node table is neither garbage collected nor resized while
+ * a parallel operation runs, and automatic reordering is never triggered by it. If the free
+ * nodes run out, the table is cleaned up and the operation is restarted, possibly in the
+ * sequential version. The default is one thread, which is also restored by ::bdd_done.
+ * The threads are only available if the library was configured with
+ * <tt>--enable-threads</tt> - otherwise this function has no effect.
+ * 
+ * \return The previous number of threads or a negative number on error.
+ * \see bdd_setcacheratio
+ */
+extern int      bdd_setthreads(int num);
+
+
+/**
+ * \ingroup kernel
+ * \brief Selects how parallel operations insert new nodes.
+ *
+ * With \c BDD_UNIQUE_CHAINED (the default) new nodes are inserted directly into the
+ * hash chains of the node table, protected by a set of striped locks. With
+ * \c BDD_UNIQUE_OPEN they are inserted into a separate open addressing table using
+ * compare-and-swap, and are moved into the hash chains when the operation is done. The
+ * open addressing table needs two to four extra words per node. The setting only affects
+ * parallel operations (see ::bdd_setthreads) and is reset by ::bdd_done.
+ * 
+ * \return The previous setting or a negative number on error.
+ * \see bdd_setthreads
+ */
+extern int      bdd_setuniquetable(int kind);
+
+
 /**
  * \ingroup operator
  * \brief Build a cube from an array of variables specified by a BDD array.
@@ -1027,6 +1427,89 @@ extern BDD      bdd_imp(BDD l, BDD r);
 extern BDD      bdd_biimp(BDD l, BDD r);
 
 
+/**
+ * \ingroup operator
+ * \brief Tests whether one bdd implies another.
+ *
+ * Gives the same answer as \code bdd_imp(f,g) == bddtrue \endcode but without
+ * building any nodes. The recursion stops at the first assignment that satisfies
+ * \a f and not \a g, and its results are kept in a cache of their own.
+ * 
+ * \return One if \f$f \Rightarrow g\f$ holds for all assignments, zero if not and
+ * a negative error code on errors.
+ * \see bdd_disjoint, bdd_equal_under, bdd_imp
+ */
+extern int      bdd_leq(BDD f, BDD g);
+
+
+/**
+ * \ingroup operator
+ * \brief Tests whether two bdds have no satisfying assignment in common.
+ *
+ * Gives the same answer as \code bdd_and(f,g) == bddfalse \endcode but without
+ * building any nodes, like ::bdd_leq.
+ * 
+ * \return One if \f$f \land g\f$ is false, zero if not and a negative error
+ * code on errors.
+ * \see bdd_leq, bdd_equal_under
+ */
+extern int      bdd_disjoint(BDD f, BDD g);
+
+
+/**
+ * \ingroup operator
+ * \brief Tests whether two bdds are equal on a care set.
+ *
+ * Gives the same answer as \code bdd_leq(care, bdd_biimp(f,g)) \endcode but
+ * without building any nodes, like ::bdd_leq.
+ * 
+ * \return One if \a f and \a g agree on all assignments in \a care, zero if not
+ * and a negative error code on errors.
+ * \see bdd_leq, bdd_disjoint
+ */
+extern int      bdd_equal_under(BDD f, BDD g, BDD care);
+
+
+/**
+ * \ingroup operator
+ * \brief The logical 'and', 'or' or 'xor' of many bdds.
+ *
+ * Combines the \a num bdds in \a r with the operator \a op, which must be one of
+ * \c bddop_and, \c bddop_or or \c bddop_xor. The order in which the operands are
+ * combined is selected with ::bdd_setnaryschedule. It stops as soon as the result is
+ * known to be constant false (for 'and') or true (for 'or'). With no operands the
+ * result is true for 'and' and false otherwise.
+ * 
+ * \return The combination of the bdds in \a r.
+ * \see bdd_and_n, bdd_or_n, bdd_apply
+ */
+extern BDD      bdd_apply_n(BDD *r, int num, int op);
+
+
+/**
+ * \ingroup operator
+ * \brief The logical 'and' of many bdds.
+ *
+ * This a wrapper that calls \code bdd_apply_n(r,num,bddop_and) \endcode
+ * 
+ * \return The logical 'and' of the bdds in \a r.
+ * \see bdd_apply_n, bdd_or_n
+ */
+extern BDD      bdd_and_n(BDD *r, int num);
+
+
+/**
+ * \ingroup operator
+ * \brief The logical 'or' of many bdds.
+ *
+ * This a wrapper that calls \code bdd_apply_n(r,num,bddop_or) \endcode
+ * 
+ * \return The logical 'or' of the bdds in \a r.
+ * \see bdd_apply_n, bdd_and_n
+ */
+extern BDD      bdd_or_n(BDD *r, int num);
+
+
 /**
  * \ingroup operator
  * \brief If-then-else operator.
@@ -1101,7 +1584,7 @@ extern BDD      bdd_replace(BDD r, bddPair *pair);
  * \return The composed BDD.
  * \see bdd_veccompose, bdd_replace, bdd_restrict
  */
-extern BDD      bdd_compose(BDD f, BDD g, BDD v);
+extern BDD      bdd_compose(BDD f, BDD g, int var);
 
 
 /**
@@ -1192,6 +1675,23 @@ extern BDD      bdd_unique(BDD, BDD);
 extern BDD      bdd_appex(BDD l, BDD r, int opr, BDD var);
 
 
+/**
+ * \ingroup operator
+ * \brief Conjunction of many BDDs and existential quantification.
+ *
+ * Calculates the conjunction of the \a num BDDs in \a r with the variables in the
+ * variable set \a var existentially quantified, in a single recursion over all the
+ * operands at once. Unlike a chain of ::bdd_appex calls no conjunction of some of
+ * the operands is built only to be quantified later. Variables that only one operand
+ * depends on are quantified from that operand first. Results are kept in a cache
+ * keyed on the list of operands.
+ * 
+ * \see bdd_appex, bdd_apply_n, bdd_makeset
+ * \return The result of the operation.
+ */
+extern BDD      bdd_appex_n(BDD *r, int num, BDD var);
+
+
 /**
  * \ingroup operator
  * \brief Apply operation and universal quantification.
@@ -1364,6 +1864,36 @@ extern double   bdd_satcountln(BDD r);
 extern double   bdd_satcountlnset(BDD r, BDD varset);
 
 
+/**
+ * \ingroup info
+ * \brief Calculates the exact number of satisfying variable assignments.
+ *
+ * Calculates the same number as ::bdd_satcount, but without rounding or overflow, no matter
+ * how many variables are defined. The number is returned as an array of \a *size 32 bit words
+ * with the least significant word first. It is the users responsibility to free the array
+ * again using a call to \c free. The count of each node is calculated once (and kept if
+ * ::bdd_setcountmemo is enabled) and independent parts of the BDD are counted in parallel
+ * when more than one thread is used (see ::bdd_setthreads).
+ *
+ * \return A pointer to the words of the number or \c NULL if an error occured.
+ * \see bdd_satcountstr, bdd_satcount, bdd_satcountln
+ */
+extern unsigned int* bdd_satcountexact(BDD r, int *size);
+
+
+/**
+ * \ingroup info
+ * \brief Calculates the exact number of satisfying variable assignments as a decimal string.
+ *
+ * Same as ::bdd_satcountexact but the number is returned as a string of decimal digits. It
+ * is the users responsibility to free the string again using a call to \c free.
+ *
+ * \return A pointer to the string or \c NULL if an error occured.
+ * \see bdd_satcountexact, bdd_satcount
+ */
+extern char*    bdd_satcountstr(BDD r);
+
+
 /**
  * \ingroup info
  * \brief Counts the number of nodes used for a bdd.
@@ -1373,7 +1903,7 @@ extern double   bdd_satcountlnset(BDD r, BDD varset);
  * \return The number of nodes.
  * \see bdd_pathcount, bdd_satcount, bdd_anodecount
  */
-extern int      bdd_nodecount(BDD r);
+extern BDD      bdd_nodecount(BDD r);
 
 
 /**
@@ -1387,7 +1917,32 @@ extern int      bdd_nodecount(BDD r);
  * \return The number of nodes.
  * \see bdd_nodecount
  */
-extern int      bdd_anodecount(BDD *r, int num);
+extern BDD      bdd_anodecount(BDD *r, int num);
+
+
+/**
+ * \ingroup info
+ * \brief Counts the nodes of each BDD in an array and the nodes they share.
+ *
+ * Does the work of ::bdd_nodecount for each of the \a num BDDs in \a r and of ::bdd_anodecount
+ * for all of them at once. For each BDD \a r[i] the number of nodes, the number of nodes used
+ * by no other BDD in the array and the number of nodes also used by another BDD are stored
+ * in \a prof[i]. This tells how many nodes would be freed by dropping a BDD. If \a levels is
+ * not \c NULL it must have room for ::bdd_varnum counts of type ::BDD and gets the number of distinct
+ * nodes at each level, and likewise \a shared gets the number of nodes at each level that
+ * are used by more than one BDD. Neither is indexed by variable, as ::bdd_varprofile is, but
+ * by level. The same BDD may occur more than once in \a r, in which case all of its nodes
+ * are shared.
+ *
+ * Instead of marking and unmarking the nodes this uses an integer and a bit per node of the
+ * node table, so each BDD is traversed once and the counts are collected in a single pass
+ * over the node table.
+ *
+ * \return The number of distinct nodes, or a negative number on error.
+ * \see bdd_anodecount, bdd_nodecount
+ */
+extern BDD      bdd_anodeprofile(BDD *r, int num, bddRootProfile *prof, BDD *levels,
+				 BDD *shared);
 
 
 /**
@@ -2052,6 +2607,23 @@ extern const BDD bddtrue;
 #define BDD_REORDER_FREE     0
 #define BDD_REORDER_FIXED    1
 
+   /* Operator engines */
+#define BDD_ENGINE_RECURSIVE 0
+#define BDD_ENGINE_ITERATIVE 1
+
+   /* Schedules of bdd_apply_n */
+#define BDD_NARY_SIZE      0
+#define BDD_NARY_SUPPORT   1
+#define BDD_NARY_RECURSIVE 2
+
+   /* Cache invalidation modes */
+#define BDD_CACHE_RESET     0
+#define BDD_CACHE_SELECTIVE 1
+
+   /* Unique tables for parallel operations */
+#define BDD_UNIQUE_CHAINED   0
+#define BDD_UNIQUE_OPEN      1
+
 
 /*=== Error codes ======================================================*/
 
@@ -2092,16 +2664,18 @@ extern const BDD bddtrue;
 /*=== User BDD class ===================================================*/
 
 class bvec;
+struct s_bddImage;
+struct s_bddReachStat;
 
 class bdd
 {
  public:
 
-   bdd(void)         { root=0; }
-   bdd(const bdd &r) { bdd_addref(root=r.root); }
-   ~bdd(void)        { bdd_delref(root); }
+   bdd(void)         { root=0; mgr=NULL; }
+   bdd(const bdd &r) { root=r.root; mgr=r.mgr; addref(); }
+   ~bdd(void)        { delref(); }
 
-   int id(void) const;
+   BDD id(void) const;
    
    bdd operator=(const bdd &r);
    
@@ -2125,10 +2699,18 @@ class bdd
    
 private:
    BDD root;
+   bddManager *mgr;  /* Manager of root, NULL for the constants */
 
-   bdd(BDD r) { bdd_addref(root=r); }
+   bdd(BDD r)                { root=r; mgr=managerof(r); addref(); }
+   bdd(BDD r, bddManager *m) { root=r; mgr=(r < 2 ? NULL : m); addref(); }
    bdd operator=(BDD r);
 
+   static bddManager *managerof(BDD r)
+   { return r < 2 ? NULL : bdd_getmanager(); }
+   void addref(void) const;
+   void delref(void) const;
+   void otherref(int) const;
+
    friend int      bdd_init(int, int);
    friend int      bdd_setvarnum(int);
    friend bdd      bdd_true(void);
@@ -2152,6 +2734,10 @@ private:
    friend bdd      bdd_xor(const bdd &, const bdd &);
    friend bdd      bdd_imp(const bdd &, const bdd &);
    friend bdd      bdd_biimp(const bdd &, const bdd &);
+   friend int      bdd_leq(const bdd &, const bdd &);
+   friend int      bdd_disjoint(const bdd &, const bdd &);
+   friend int      bdd_equal_under(const bdd &, const bdd &, const bdd &);
+   friend bdd      bdd_apply_npp(const bdd *, int, int);
    friend bdd      bdd_ite(const bdd &, const bdd &, const bdd &);
    friend bdd      bdd_restrict(const bdd &, const bdd &);
    friend bdd      bdd_constrain(const bdd &, const bdd &);
@@ -2159,6 +2745,7 @@ private:
    friend bdd      bdd_forall(const bdd &, const bdd &);
    friend bdd      bdd_unique(const bdd &, const bdd &);
    friend bdd      bdd_appex(const bdd &, const bdd &, int, const bdd &);
+   friend bdd      bdd_appex_npp(const bdd *, int, const bdd &);
    friend bdd      bdd_appall(const bdd &, const bdd &, int, const bdd &);
    friend bdd      bdd_appuni(const bdd &, const bdd &, int, const bdd &);
    friend bdd      bdd_replace(const bdd &, bddPair*);
@@ -2173,8 +2760,12 @@ private:
    friend double   bdd_satcountset(const bdd &, const bdd &);
    friend double   bdd_satcountln(const bdd &);
    friend double   bdd_satcountlnset(const bdd &, const bdd &);
-   friend int      bdd_nodecount(const bdd &);
-   friend int      bdd_anodecountpp(const bdd *, int);
+   friend unsigned int* bdd_satcountexact(const bdd &, int *);
+   friend char*    bdd_satcountstr(const bdd &);
+   friend BDD      bdd_nodecount(const bdd &);
+   friend BDD      bdd_anodecountpp(const bdd *, int);
+   friend BDD      bdd_anodeprofilepp(const bdd *, int, bddRootProfile *, BDD *, BDD *);
+   friend int      bdd_compactpp(bdd *, int);
    friend int*     bdd_varprofile(const bdd &);
    friend double   bdd_pathcount(const bdd &);
    
@@ -2202,6 +2793,13 @@ private:
    friend bdd    fdd_makesetpp(int*, int);
    friend int    fdd_scanset(const bdd &, int *&, int &);
 
+   friend bdd    bdd_image(struct s_bddImage *, const bdd &);
+   friend bdd    bdd_preimage(struct s_bddImage *, const bdd &);
+   friend bdd    bdd_reachable(struct s_bddImage *, const bdd &, int,
+				void (*)(struct s_bddReachStat *));
+   friend struct s_bddImage *bdd_newimagepp(const bdd *, int, int, int *, int *,
+					    int, int);
+
    friend int    bdd_addvarblock(const bdd &, int);
 
    friend class bvec;
@@ -2218,6 +2816,24 @@ private:
    friend bdd  bvec_neq(const bvec &left, const bvec &right);
 };
 
+   /* The reference counts are changed in the manager of the object,
+      which need not be the current one */
+inline void bdd::addref(void) const
+{
+   if (mgr == bdd_getmanager())
+      bdd_addref(root);
+   else if (mgr != NULL)
+      otherref(1);
+}
+
+inline void bdd::delref(void) const
+{
+   if (mgr == bdd_getmanager())
+      bdd_delref(root);
+   else if (mgr != NULL)
+      otherref(-1);
+}
+
 
 /*=== BDD constants ====================================================*/
 
@@ -2302,6 +2918,49 @@ inline bdd bdd_imp(const bdd &l, const bdd &r)
 inline bdd bdd_biimp(const bdd &l, const bdd &r)
 { return bdd_apply(l.root, r.root, bddop_biimp); }
 
+inline int bdd_leq(const bdd &f, const bdd &g)
+{ return bdd_leq(f.root, g.root); }
+
+inline int bdd_disjoint(const bdd &f, const bdd &g)
+{ return bdd_disjoint(f.root, g.root); }
+
+inline int bdd_equal_under(const bdd &f, const bdd &g, const bdd &care)
+{ return bdd_equal_under(f.root, g.root, care.root); }
+
+inline bdd bdd_apply_n(const bdd *r, int num, int op)
+{ return bdd_apply_npp(r, num, op); }
+
+inline bdd bdd_and_n(const bdd *r, int num)
+{ return bdd_apply_npp(r, num, bddop_and); }
+
+inline bdd bdd_or_n(const bdd *r, int num)
+{ return bdd_apply_npp(r, num, bddop_or); }
+
+template <class Iter>
+inline bdd bdd_apply_n(Iter first, Iter last, int op)
+{
+   int num = 0;
+   for (Iter i=first ; i!=last ; ++i)
+      num++;
+   
+   bdd *tmp = new bdd[num];
+   num = 0;
+   for (Iter i=first ; i!=last ; ++i)
+      tmp[num++] = *i;
+
+   bdd res = bdd_apply_npp(tmp, num, op);
+   delete[] tmp;
+   return res;
+}
+
+template <class Iter>
+inline bdd bdd_and_n(Iter first, Iter last)
+{ return bdd_apply_n(first, last, bddop_and); }
+
+template <class Iter>
+inline bdd bdd_or_n(Iter first, Iter last)
+{ return bdd_apply_n(first, last, bddop_or); }
+
 inline bdd bdd_ite(const bdd &f, const bdd &g, const bdd &h)
 { return bdd_ite(f.root, g.root, h.root); }
 
@@ -2317,6 +2976,9 @@ inline bdd bdd_unique(const bdd &r, const bdd &var)
 inline bdd bdd_appex(const bdd &l, const bdd &r, int op, const bdd &var)
 { return bdd_appex(l.root, r.root, op, var.root); }
 
+inline bdd bdd_appex_n(const bdd *r, int num, const bdd &var)
+{ return bdd_appex_npp(r, num, var); }
+
 inline bdd bdd_appall(const bdd &l, const bdd &r, int op, const bdd &var)
 { return bdd_appall(l.root, r.root, op, var.root); }
 
@@ -2350,7 +3012,13 @@ inline double bdd_satcountln(const bdd &r)
 inline double bdd_satcountlnset(const bdd &r, const bdd &varset)
 { return bdd_satcountlnset(r.root, varset.root); }
 
-inline int bdd_nodecount(const bdd &r)
+inline unsigned int* bdd_satcountexact(const bdd &r, int *size)
+{ return bdd_satcountexact(r.root, size); }
+
+inline char* bdd_satcountstr(const bdd &r)
+{ return bdd_satcountstr(r.root); }
+
+inline BDD bdd_nodecount(const bdd &r)
 { return bdd_nodecount(r.root); }
 
 inline int* bdd_varprofile(const bdd &r)
@@ -2390,14 +3058,20 @@ inline int bdd_save(FILE *ofile, const bdd &r)
 { return bdd_save(ofile, r.root); }
 
 inline int bdd_fnload(char *fname, bdd &r)
-{ int lr,e; e=bdd_fnload(fname, &lr); r=bdd(lr); return e; }
+{ BDD lr; int e; e=bdd_fnload(fname, &lr); r=bdd(lr); return e; }
 
 inline int bdd_load(FILE *ifile, bdd &r)
-{ int lr,e; e=bdd_load(ifile, &lr); r=bdd(lr); return e; }
+{ BDD lr; int e; e=bdd_load(ifile, &lr); r=bdd(lr); return e; }
 
 inline int bdd_addvarblock(const bdd &v, int f)
 { return bdd_addvarblock(v.root, f); }
 
+extern int bdd_compactpp(bdd *roots, int num);
+extern BDD bdd_anodeprofilepp(const bdd *roots, int num, bddRootProfile *prof,
+			      BDD *levels, BDD *shared);
+extern bdd bdd_apply_npp(const bdd *roots, int num, int op);
+extern bdd bdd_appex_npp(const bdd *roots, int num, const bdd &var);
+
    /* Hack to allow for overloading */
 #define bdd_init bdd_cpp_init
 #define bdd_ithvar bdd_ithvarpp
@@ -2405,10 +3079,12 @@ inline int bdd_addvarblock(const bdd &v, int f)
 #define bdd_makeset bdd_makesetpp
 #define bdd_ibuildcube bdd_ibuildcubepp
 #define bdd_anodecount bdd_anodecountpp
+#define bdd_anodeprofile bdd_anodeprofilepp
+#define bdd_compact bdd_compactpp
 
 /*=== Inline C++ functions =============================================*/
 
-inline int bdd::id(void) const
+inline BDD bdd::id(void) const
 { return root; }
 
 inline bdd bdd::operator&(const bdd &r) const
@@ -2469,6 +3145,38 @@ inline bdd bdd_false(void)
 { return 0; }
 
 
+/*=== Managers =========================================================*/
+
+   /* A BDD manager that is deleted together with the object. The bdd
+      objects belong to the manager that was current when they were
+      created and must be destroyed while it is still current. */
+class bdd_manager
+{
+ public:
+   bdd_manager(void)  { m=bdd_newmanager(); }
+   ~bdd_manager(void) { bdd_deletemanager(m); }
+
+   bddManager *handle(void) const { return m; }
+   bddManager *use(void)          { return bdd_setmanager(m); }
+
+      /* Makes a manager current for the lifetime of the scope object */
+   class scope
+   {
+    public:
+      scope(bdd_manager &m) { old=m.use(); }
+      ~scope(void)          { bdd_setmanager(old); }
+    private:
+      bddManager *old;
+   };
+   
+ private:
+   bddManager *m;
+
+   bdd_manager(const bdd_manager &);
+   bdd_manager &operator=(const bdd_manager &);
+};
+
+
 /*=== Iostream printing ================================================*/
 
 class bdd_ioformat
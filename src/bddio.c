@@ -41,29 +41,33 @@
 #include <fcntl.h>
 #include <assert.h>
 #include <sys/stat.h>
+#include "config.h"
 #include "kernel.h"
 
-static void bdd_printset_rec(FILE *, int, int *);
+static void bdd_printset_rec(FILE *, BDD, int *);
 static void bdd_fprintdot_rec(FILE*, BDD);
-static int  bdd_save_rec(FILE*, int);
-static int  bdd_loaddata(FILE *);
-static int  loadhash_get(int);
-static void loadhash_add(int, int);
+static int  bdd_save_rec(FILE*, BDD);
+#ifdef COMPLEMENT_EDGES
+static void bdd_savecount_rec(BDD, BDD*);
+#endif
+static BDD  bdd_loaddata(FILE *);
+static BDD  loadhash_get(BDD);
+static void loadhash_add(BDD, BDD);
 
-static bddfilehandler filehandler;
+#define filehandler (bddmanager->filehandler)
 
 typedef struct s_LoadHash
 {
-   int key;
-   int data;
+   BDD key;
+   BDD data;
    int first;
    int next;
 } LoadHash;
 
-static LoadHash *lh_table;
-static int       lh_freepos;
-static int       lh_nodenum;
-static int      *loadvar2level;
+#define lh_table      (bddmanager->lh_table)
+#define lh_freepos    (bddmanager->lh_freepos)
+#define lh_nodenum    (bddmanager->lh_nodenum)
+#define loadvar2level (bddmanager->loadvar2level)
 
 /*=== PRINTING ========================================================*/
 
@@ -84,20 +88,23 @@ void bdd_printall(void)
 
 void bdd_fprintall(FILE *ofile)
 {
-   int n;
+   BddNode *node;
+   BDD n;
    
    for (n=0 ; n<bddnodesize ; n++)
    {
-      if (LOW(n) != -1)
+      node = &bddnodes[n];
+      
+      if (LOWp(node) != -1)
       {
-	 fprintf(ofile, "[%5d - %2d] ", n, bddnodes[n].refcou);
+	 fprintf(ofile, "[%5" PRIbdd " - %2d] ", n, node->refcou);
 	 if (filehandler)
-	    filehandler(ofile, bddlevel2var[LEVEL(n)]);
+	    filehandler(ofile, bddlevel2var[LEVELp(node)]);
 	 else
-	    fprintf(ofile, "%3d", bddlevel2var[LEVEL(n)]);
+	    fprintf(ofile, "%3d", bddlevel2var[LEVELp(node)]);
 
-	 fprintf(ofile, ": %3d", LOW(n));
-	 fprintf(ofile, " %3d", HIGH(n));
+	 fprintf(ofile, ": %3" PRIbdd, LOWp(node));
+	 fprintf(ofile, " %3" PRIbdd, HIGHp(node));
 	 fprintf(ofile, "\n");
       }
    }
@@ -113,9 +120,9 @@ void bdd_printtable(BDD r)
 void bdd_fprinttable(FILE *ofile, BDD r)
 {
    BddNode *node;
-   int n;
+   BDD n;
    
-   fprintf(ofile, "ROOT: %d\n", r);
+   fprintf(ofile, "ROOT: %" PRIbdd "\n", r);
    if (r < 2)
       return;
 
@@ -123,20 +130,20 @@ void bdd_fprinttable(FILE *ofile, BDD r)
    
    for (n=0 ; n<bddnodesize ; n++)
    {
-      if (LEVEL(n) & MARKON)
+      node = &bddnodes[n];
+      
+      if (LEVELp(node) & MARKON)
       {
-	 node = &bddnodes[n];
-	 
 	 LEVELp(node) &= MARKOFF;
 
-	 fprintf(ofile, "[%5d] ", n);
+	 fprintf(ofile, "[%5" PRIbdd "] ", n);
 	 if (filehandler)
 	    filehandler(ofile, bddlevel2var[LEVELp(node)]);
 	 else
 	    fprintf(ofile, "%3d", bddlevel2var[LEVELp(node)]);
 
-	 fprintf(ofile, ": %3d", LOWp(node));
-	 fprintf(ofile, " %3d", HIGHp(node));
+	 fprintf(ofile, ": %3" PRIbdd, LOWp(node));
+	 fprintf(ofile, " %3" PRIbdd, HIGHp(node));
 	 fprintf(ofile, "\n");
       }
    }
@@ -171,7 +178,7 @@ void bdd_fprintset(FILE *ofile, BDD r)
 }
 
 
-static void bdd_printset_rec(FILE *ofile, int r, int *set)
+static void bdd_printset_rec(FILE *ofile, BDD r, int *set)
 {
    int n;
    int first;
@@ -237,6 +244,15 @@ void bdd_fprintdot(FILE* ofile, BDD r)
    fprintf(ofile, "0 [shape=box, label=\"0\", style=filled, shape=box, height=0.3, width=0.3];\n");
    fprintf(ofile, "1 [shape=box, label=\"1\", style=filled, shape=box, height=0.3, width=0.3];\n");
 
+#ifdef COMPLEMENT_EDGES
+   if (!ISCONST(r)  &&  ISCOMPL(r))
+   {
+      fprintf(ofile, "root [shape=plaintext, label=\"\"];\n");
+      fprintf(ofile, "root -> %" PRIbdd " [arrowhead=odot];\n", REGULAR(r));
+      r = REGULAR(r);
+   }
+#endif
+   
    bdd_fprintdot_rec(ofile, r);
 
    fprintf(ofile, "}\n");
@@ -250,25 +266,48 @@ static void bdd_fprintdot_rec(FILE* ofile, BDD r)
    if (ISCONST(r) || MARKED(r))
       return;
 
-   fprintf(ofile, "%d [label=\"", r);
+   fprintf(ofile, "%" PRIbdd " [label=\"", r);
    if (filehandler)
       filehandler(ofile, bddlevel2var[LEVEL(r)]);
    else
       fprintf(ofile, "%d", bddlevel2var[LEVEL(r)]);
    fprintf(ofile, "\"];\n");
 
-   fprintf(ofile, "%d -> %d [style=dotted];\n", r, LOW(r));
-   fprintf(ofile, "%d -> %d [style=filled];\n", r, HIGH(r));
+#ifdef COMPLEMENT_EDGES
+      /* Only the high edge can be complemented - draw it with a circle */
+   fprintf(ofile, "%" PRIbdd " -> %" PRIbdd " [style=dotted];\n", r, LOW(r));
+   if (ISCONST(HIGH(r))  ||  !ISCOMPL(HIGH(r)))
+      fprintf(ofile, "%" PRIbdd " -> %" PRIbdd " [style=filled];\n",
+	      r, HIGH(r));
+   else
+      fprintf(ofile, "%" PRIbdd " -> %" PRIbdd " [style=filled, arrowhead=odot];\n",
+	      r, REGULAR(HIGH(r)));
+
+   SETMARK(r);
+   
+   bdd_fprintdot_rec(ofile, LOW(r));
+   bdd_fprintdot_rec(ofile, REGULAR(HIGH(r)));
+#else
+   fprintf(ofile, "%" PRIbdd " -> %" PRIbdd " [style=dotted];\n", r, LOW(r));
+   fprintf(ofile, "%" PRIbdd " -> %" PRIbdd " [style=filled];\n", r, HIGH(r));
 
    SETMARK(r);
    
    bdd_fprintdot_rec(ofile, LOW(r));
    bdd_fprintdot_rec(ofile, HIGH(r));
+#endif
 }
 
 
 /*=== SAVE =============================================================*/
 
+#ifdef COMPLEMENT_EDGES
+   /* With complement edges a node may be used both in its regular and its
+      complemented form. Each form is saved as a separate node so the file
+      format stays the same. This table marks the edges already saved. */
+#define savemark (bddmanager->savemark)
+#endif
+
 int bdd_fnsave(char *fname, BDD r)
 {
    FILE *ofile;
@@ -285,49 +324,80 @@ int bdd_fnsave(char *fname, BDD r)
 
 int bdd_save(FILE *ofile, BDD r)
 {
-   int err, n=0;
+   BDD nodes=0;
+   int err, n;
 
    if (r < 2)
    {
-      fprintf(ofile, "0 0 %d\n", r);
+      fprintf(ofile, "0 0 %" PRIbdd "\n", r);
       return 0;
    }
    
-   bdd_markcount(r, &n);
+#ifdef COMPLEMENT_EDGES
+   if ((savemark=(char*)calloc(2*bddnodesize, sizeof(char))) == NULL)
+      return bdd_error(BDD_MEMORY);
+   bdd_savecount_rec(r, &nodes);
+   memset(savemark, 0, 2*bddnodesize*sizeof(char));
+#else
+   bdd_markcount(r, &nodes);
    bdd_unmark(r);
-   fprintf(ofile, "%d %d\n", n, bddvarnum);
+#endif
+   fprintf(ofile, "%" PRIbdd " %d\n", nodes, bddvarnum);
 
    for (n=0 ; n<bddvarnum ; n++)
       fprintf(ofile, "%d ", bddvar2level[n]);
    fprintf(ofile, "\n");
    
    err = bdd_save_rec(ofile, r);
+#ifdef COMPLEMENT_EDGES
+   free(savemark);
+#else
    bdd_unmark(r);
+#endif
 
    return err;
 }
 
 
-static int bdd_save_rec(FILE *ofile, int root)
+#ifdef COMPLEMENT_EDGES
+static void bdd_savecount_rec(BDD root, BDD *num)
+{
+   if (root < 2  ||  savemark[root])
+      return;
+   savemark[root] = 1;
+   (*num)++;
+   
+   bdd_savecount_rec(LOW(root), num);
+   bdd_savecount_rec(HIGH(root), num);
+}
+#endif
+
+
+static int bdd_save_rec(FILE *ofile, BDD root)
 {
-   BddNode *node = &bddnodes[root];
    int err;
    
    if (root < 2)
       return 0;
 
-   if (LEVELp(node) & MARKON)
+#ifdef COMPLEMENT_EDGES
+   if (savemark[root])
+      return 0;
+   savemark[root] = 1;
+#else
+   if (MARKED(root))
       return 0;
-   LEVELp(node) |= MARKON;
+   SETMARK(root);
+#endif
    
-   if ((err=bdd_save_rec(ofile, LOWp(node))) < 0)
+   if ((err=bdd_save_rec(ofile, LOW(root))) < 0)
       return err;
-   if ((err=bdd_save_rec(ofile, HIGHp(node))) < 0)
+   if ((err=bdd_save_rec(ofile, HIGH(root))) < 0)
       return err;
 
-   fprintf(ofile, "%d %d %d %d\n",
-	   root, bddlevel2var[LEVELp(node) & MARKHIDE],
-	   LOWp(node), HIGHp(node));
+   fprintf(ofile, "%" PRIbdd " %d %" PRIbdd " %" PRIbdd "\n",
+	   root, bddlevel2var[LEVEL(root) & MARKHIDE],
+	   LOW(root), HIGH(root));
 
    return 0;
 }
@@ -351,7 +421,8 @@ int bdd_fnload(char *fname, BDD *root)
 
 int bdd_load(FILE *ifile, BDD *root)
 {
-   int n, vnum, tmproot;
+   int n, vnum;
+   BDD tmproot;
 
    if (fscanf(ifile, "%d %d", &lh_nodenum, &vnum) != 2)
       return bdd_error(BDD_FORMAT);
@@ -359,7 +430,7 @@ int bdd_load(FILE *ifile, BDD *root)
       /* Check for constant true / false */
    if (lh_nodenum==0  &&  vnum==0)
    {
-      fscanf(ifile, "%d", root);
+      fscanf(ifile, "%" PRIbdd, root);
       return 0;
    }
 
@@ -392,7 +463,7 @@ int bdd_load(FILE *ifile, BDD *root)
    
    *root = 0;
    if (tmproot < 0)
-      return tmproot;
+      return (int)tmproot;
    else
       *root = tmproot;
    
@@ -400,13 +471,15 @@ int bdd_load(FILE *ifile, BDD *root)
 }
 
 
-static int bdd_loaddata(FILE *ifile)
+static BDD bdd_loaddata(FILE *ifile)
 {
-   int key,var,low,high,root=0,n;
+   BDD key,low,high,root=0;
+   int var,n;
    
    for (n=0 ; n<lh_nodenum ; n++)
    {
-      if (fscanf(ifile,"%d %d %d %d", &key, &var, &low, &high) != 4)
+      if (fscanf(ifile,"%" PRIbdd " %d %" PRIbdd " %" PRIbdd,
+		 &key, &var, &low, &high) != 4)
 	 return bdd_error(BDD_FORMAT);
 
       if (low >= 2)
@@ -426,9 +499,9 @@ static int bdd_loaddata(FILE *ifile)
 }
 
 
-static void loadhash_add(int key, int data)
+static void loadhash_add(BDD key, BDD data)
 {
-   int hash = key % lh_nodenum;
+   int hash = (int)(key % lh_nodenum);
    int pos = lh_freepos;
 
    lh_freepos = lh_table[pos].next;
@@ -440,7 +513,7 @@ static void loadhash_add(int key, int data)
 }
 
 
-static int loadhash_get(int key)
+static BDD loadhash_get(BDD key)
 {
    int hash = lh_table[key % lh_nodenum].first;
 
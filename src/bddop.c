@@ -43,6 +43,45 @@
 #include "config.h"
 #include "kernel.h"
 #include "cache.h"
+#include "parallel.h"
+#include "bigint.h"
+
+   /* Counting of cache hits and misses */
+#define CACHEHIT(cache)         BddCache_hit(&cache)
+#define CACHEMISS(cache,entry)  BddCache_miss(&cache,entry)
+
+   /* Operators with call statistics - index of opstatname */
+#define OPSTAT_NOT         0
+#define OPSTAT_APPLY       1
+#define OPSTAT_ITE         2
+#define OPSTAT_RESTRICT    3
+#define OPSTAT_CONSTRAIN   4
+#define OPSTAT_REPLACE     5
+#define OPSTAT_COMPOSE     6
+#define OPSTAT_VECCOMPOSE  7
+#define OPSTAT_SIMPLIFY    8
+#define OPSTAT_EXIST       9
+#define OPSTAT_FORALL      10
+#define OPSTAT_UNIQUE      11
+#define OPSTAT_APPEX       12
+#define OPSTAT_APPALL      13
+#define OPSTAT_APPUNI      14
+#define OPSTAT_SATCOUNT    15
+#define OPSTAT_SATCOUNTLN  16
+#define OPSTAT_PATHCOUNT   17
+#define OPSTAT_SATEXACT    18
+#define OPSTAT_APPLYN      19
+#define OPSTAT_APPEXN      20
+#define OPSTAT_LEQ         21
+#define OPSTAT_DISJOINT    22
+#define OPSTAT_EQUALUNDER  23
+
+   /* Counts a call of a top level operator and reads the clock if timing
+      is enabled. OPEND adds the time used and gives the result, which
+      must already have been computed. */
+#define OPBEGIN(op) (opcalls[op]++, optiming ? clock() : (clock_t)0)
+#define OPEND(op,start,res) \
+   (optiming ? (optime[op] += (long)(clock()-(start))) : 0L, (res))
 
    /* Hash value modifiers to distinguish between entries in misccache */
 #define CACHEID_CONSTRAIN   0x0
@@ -64,6 +103,13 @@
 #define CACHEID_APPAL        0x4
 #define CACHEID_APPUN        0x5
 
+   /* Hash value modifiers for testcache. Entries of bdd_equal_under keep
+      the care set in the result field and the answer in the id, shifted
+      by two bits. */
+#define TESTID_LEQ           0x0
+#define TESTID_DISJOINT      0x1
+#define TESTID_EQUAL         0x2
+
 
    /* Number of boolean operators */
 #define OPERATOR_NUM    11
@@ -83,66 +129,201 @@ static int oprres[OPERATOR_NUM][4] =
   {1,1,0,0}   /* not                       ( ! )         */
 };
 
+#ifdef COMPLEMENT_EDGES
+   /* With complement edges all operators are rewritten as either AND or
+      XOR. Entry = { operator, negate left, negate right, negate result } */
+static int oprce[OPERATOR_NUM-1][4] =
+{ {bddop_and, 0,0,0},  /* and                  */
+  {bddop_xor, 0,0,0},  /* xor                  */
+  {bddop_and, 1,1,1},  /* or     = !(!l & !r)  */
+  {bddop_and, 0,0,1},  /* nand   = !(l & r)    */
+  {bddop_and, 1,1,0},  /* nor    = !l & !r     */
+  {bddop_and, 0,1,1},  /* imp    = !(l & !r)   */
+  {bddop_xor, 0,0,1},  /* biimp  = !(l ^ r)    */
+  {bddop_and, 0,1,0},  /* diff   = l & !r      */
+  {bddop_and, 1,0,0},  /* less   = !l & r      */
+  {bddop_and, 1,0,1}   /* invimp = !(!l & r)   */
+};
+#endif
+
+   /* Operators that give the same result with the operands swapped. The
+      caching operators order the operands of these by index, so that
+      op(a,b) and op(b,a) share one cache entry. */
+#define COMMUTATIVE(op) (oprres[op][1] == oprres[op][2])
+
+
+   /* Variables needed for the operators - fields of the current manager */
+#define applyop       (bddmanager->applyop)
+#define appexop       (bddmanager->appexop)
+#define appexid       (bddmanager->appexid)
+#define quantid       (bddmanager->quantid)
+#define quantvarset   (bddmanager->quantvarset)
+#define quantvarsetID (bddmanager->quantvarsetID)
+#define quantlast     (bddmanager->quantlast)
+#define replaceid     (bddmanager->replaceid)
+#define replacepair   (bddmanager->replacepair)
+#define replacelast   (bddmanager->replacelast)
+#define composelevel  (bddmanager->composelevel)
+#define miscid        (bddmanager->miscid)
+#define varprofile    (bddmanager->varprofile)
+#define supportID     (bddmanager->supportID)
+#define supportMin    (bddmanager->supportMin)
+#define supportMax    (bddmanager->supportMax)
+#define supportSet    (bddmanager->supportSet)
+#define supportSize   (bddmanager->supportSize)
+#define applycache    (bddmanager->applycache)
+#define itecache      (bddmanager->itecache)
+#define quantcache    (bddmanager->quantcache)
+#define appexcache    (bddmanager->appexcache)
+#define replacecache  (bddmanager->replacecache)
+#define misccache     (bddmanager->misccache)
+#define testcache     (bddmanager->testcache)
+#define cacheratio    (bddmanager->cacheratio)
+#define cachemode     (bddmanager->cachemode)
+#define cachebudget   (bddmanager->cachebudget)
+#define bddcachesize  (bddmanager->bddcachesize)
+#define cache_handler (bddmanager->cache_handler)
+#define opcalls       (bddmanager->opcalls)
+#define optime        (bddmanager->optime)
+#define optiming      (bddmanager->optiming)
+#define satPolarity   (bddmanager->satPolarity)
+#define firstReorder  (bddmanager->firstReorder)
+#define allsatProfile (bddmanager->allsatProfile)
+#define allsatHandler (bddmanager->allsatHandler)
+#define opengine      (bddmanager->opengine)
+#define iterstack     (bddmanager->iterstack)
+#define iterstacktop  (bddmanager->iterstacktop)
+#define itermaxdepth  (bddmanager->itermaxdepth)
+#define countmemo     (bddmanager->countmemo)
+#define countmemosize (bddmanager->countmemosize)
+#define countmemoon   (bddmanager->countmemoon)
+#define countexact    (bddmanager->countexact)
+#define countexactsize (bddmanager->countexactsize)
+#define narystack     (bddmanager->narystack)
+#define narystacksize (bddmanager->narystacksize)
+#define narycache     (bddmanager->narycache)
+#define narycachesize (bddmanager->narycachesize)
+#define naryschedule  (bddmanager->naryschedule)
+
+
+   /* Frames of the iterative operators */
+#define ITER_NOT      0
+#define ITER_APPLY    1
+#define ITER_ITE      2
+#define ITER_QUANT    3
+#define ITER_APPQUANT 4
+
+typedef struct s_BddFrame
+{
+   int kind;              /* ITER_xxx */
+   int state;             /* Next step */
+   int op;                /* Operator for ITER_APPLY */
+   int level;             /* Level of the result node */
+   BDD a, b, c;           /* Operands */
+   BDD mask;              /* Xor'ed onto the result (complement edges) */
+   BddCacheData *entry;   /* Cache entry for the result */
+} BddFrame;
+
+
+   /* Counts of a node kept by the count memo (see bdd_setcountmemo). The
+      counts are those of the regular node. With complement edges the
+      counts of the negated node are derived from them. */
+#define COUNT_SAT    0x1
+#define COUNT_SATLN  0x2
+#define COUNT_PATH   0x4
+
+typedef struct s_BddCount
+{
+   double sat;            /* satcount_rec */
+   double satln;          /* satcountln_rec */
+   double path;           /* Number of paths to one */
+#ifdef COMPLEMENT_EDGES
+   double path0;          /* Number of paths to zero */
+#endif
+   int valid;             /* COUNT_xxx bits of the counts that are known */
+} BddCount;
+
+
+   /* Pending operand of the pairwise schedules of bdd_apply_n */
+typedef struct s_BddNaryItem
+{
+   BDD r;
+   BDD size;              /* Node count of r */
+   unsigned int *sup;     /* Support of r as a bitmap over the variables */
+} BddNaryItem;
+
+   /* Entry of the cache of the n-ary recursion (BDD_NARY_RECURSIVE) */
+typedef struct s_BddNaryEntry
+{
+   BDD *key;              /* The sorted operands */
+   int keysize;           /* Allocated size of key */
+   int num;               /* Number of operands, zero if unused */
+   int op;                /* The operator */
+   BDD var;               /* Quantified variable set, zero if none */
+   BDD res;
+} BddNaryEntry;
 
-   /* Variables needed for the operators */
-static int applyop;                 /* Current operator for apply */
-static int appexop;                 /* Current operator for appex */
-static int appexid;                 /* Current cache id for appex */
-static int quantid;                 /* Current cache id for quantifications */
-static int *quantvarset;            /* Current variable set for quant. */
-static int quantvarsetID;           /* Current id used in quantvarset */
-static int quantlast;               /* Current last variable to be quant. */
-static int replaceid;               /* Current cache id for replace */
-static int *replacepair;            /* Current replace pair */
-static int replacelast;             /* Current last var. level to replace */
-static int composelevel;            /* Current variable used for compose */
-static int miscid;                  /* Current cache id for other results */
-static int *varprofile;             /* Current variable profile */
-static int supportID;               /* Current ID (true value) for support */
-static int supportMin;              /* Min. used level in support calc. */
-static int supportMax;              /* Max. used level in support calc. */
-static int* supportSet;             /* The found support set */
-static BddCache applycache;         /* Cache for apply results */
-static BddCache itecache;           /* Cache for ITE results */
-static BddCache quantcache;         /* Cache for exist/forall results */
-static BddCache appexcache;         /* Cache for appex/appall results */
-static BddCache replacecache;       /* Cache for replace results */
-static BddCache misccache;          /* Cache for other results */
-static int cacheratio;
-static BDD satPolarity;
-static int firstReorder;            /* Used instead of local variable in order
-				       to avoid compiler warning about 'first'
-				       being clobbered by setjmp */
-
-static char*            allsatProfile; /* Variable profile for bdd_allsat() */
-static bddallsathandler allsatHandler; /* Callback handler for bdd_allsat() */
-
-extern bddCacheStat bddcachestats;
 
    /* Internal prototypes */
 static BDD    not_rec(BDD);
+static BDD    apply_run(BDD, BDD, int);
 static BDD    apply_rec(BDD, BDD);
 static BDD    ite_rec(BDD, BDD, BDD);
-static int    simplify_rec(BDD, BDD);
-static int    quant_rec(int);
-static int    appquant_rec(int, int);
-static int    restrict_rec(int);
+static BDD    simplify_rec(BDD, BDD);
+static BDD    quant_rec(BDD);
+static BDD    appquant_run(BDD, BDD, int, BDD, int, int, int);
+static BDD    appquant_rec(BDD, BDD);
+static BDD    apply_iter(BDD, BDD);
+static BDD    ite_iter(BDD, BDD, BDD);
+static BDD    quant_iter(BDD);
+static BDD    appquant_iter(BDD, BDD);
+static BDD    restrict_rec(BDD);
 static BDD    constrain_rec(BDD, BDD);
 static BDD    replace_rec(BDD);
 static BDD    bdd_correctify(int, BDD, BDD);
 static BDD    compose_rec(BDD, BDD);
 static BDD    veccompose_rec(BDD);
-static void   support_rec(int, int*);
+static void   support_rec(BDD, int*);
 static BDD    satone_rec(BDD);
 static BDD    satoneset_rec(BDD, BDD);
-static int    fullsatone_rec(int);
+static BDD    fullsatone_rec(BDD);
 static void   allsat_rec(BDD r);
-static double satcount_rec(int);
-static double satcountln_rec(int);
-static void   varprofile_rec(int);
+static double satcount_rec(BDD);
+static double satcountln_rec(BDD);
+static void   varprofile_rec(BDD);
+static BDD    anodeprofile_rec(BDD, int, int*, unsigned int*);
 static double bdd_pathcount_rec(BDD);
+static double satcount_memo(BDD);
+static double satcountln_memo(BDD);
+static double pathcount_memo(BDD);
+static int    countmemo_fit(void);
+static void   countmemo_clear(void);
+static void   countmemo_free(void);
+static int    countexact_fit(void);
+static void   countexact_free(BDD);
+static const BddBigInt *satexact_rec(BDD);
+static const BddBigInt *satexact_get(BDD);
+static BddBigInt *satexact_node(BDD);
+static BDD    nary_pairwise(BDD*, int, int);
+static BDD    nary_recursive(BDD*, int, int);
+static void   nary_reset(void);
+static void   nary_free(void);
+static BDD    appexn(BDD*, int, BDD);
+static BDD    appexn_rec(int, int, BDD);
 static int    varset2vartable(BDD);
 static int    varset2svartable(BDD);
+#ifdef BDD_THREADS
+static BDD    par_apply_task(BddWorker*, BddTask*);
+static BDD    par_ite_task(BddWorker*, BddTask*);
+static BDD    par_quant_task(BddWorker*, BddTask*);
+static BDD    par_appquant_task(BddWorker*, BddTask*);
+static BDD    par_satexact_task(BddWorker*, BddTask*);
+static BDD    par_satcount_task(BddWorker*, BddTask*);
+static BDD    par_visit_task(BddWorker*, BddTask*);
+static BDD    par_nodecount(BDD*, int);
+static int    par_varprofile(BDD);
+static BDD    par_visitprobe(BDD*, int);
+#endif
 
 
    /* Hashvalues */
@@ -158,6 +339,7 @@ static int    varset2svartable(BDD);
 #define SATCOUHASH(r)        (r)
 #define PATHCOUHASH(r)       (r)
 #define APPEXHASH(l,r,op)    (PAIR(l,r))
+#define TESTHASH(f,g,id)     (TRIPLE(f,g,id))
 
 #ifndef M_LN2
 #define M_LN2 0.69314718055994530942
@@ -165,6 +347,14 @@ static int    varset2svartable(BDD);
 
 #define log1p(a) (log(1.0+a))
 
+   /* Cofactors of r with respect to the variable at level lvl */
+#define LOWCOF(r,lvl)  (LEVEL(r) == (lvl) ? LOW(r) : (r))
+#define HIGHCOF(r,lvl) (LEVEL(r) == (lvl) ? HIGH(r) : (r))
+
+   /* Runs the recursive or iterative version of an operator */
+#define RUNOP(op,args) \
+   (opengine == BDD_ENGINE_ITERATIVE ? op##_iter args : op##_rec args)
+
 #define INVARSET(a) (quantvarset[a] == quantvarsetID) /* unsigned check */
 #define INSVARSET(a) (abs(quantvarset[a]) == quantvarsetID) /* signed check */
 
@@ -192,10 +382,30 @@ int bdd_operator_init(int cachesize)
    if (BddCache_init(&misccache,cachesize) < 0)
       return bdd_error(BDD_MEMORY);
 
+   if (BddCache_init(&testcache,cachesize) < 0)
+      return bdd_error(BDD_MEMORY);
+
    quantvarsetID = 0;
    quantvarset = NULL;
    cacheratio = 0;
+   cachemode = BDD_CACHE_RESET;
+   cachebudget = 0;
+   cache_handler = NULL;
+   memset(opcalls, 0, sizeof(opcalls));
+   memset(optime, 0, sizeof(optime));
+   optiming = 0;
+   countmemo = NULL;
+   countmemosize = 0;
+   countmemoon = 0;
+   countexact = NULL;
+   countexactsize = 0;
+   narystack = NULL;
+   narystacksize = 0;
+   narycache = NULL;
+   narycachesize = 0;
+   naryschedule = BDD_NARY_SIZE;
    supportSet = NULL;
+   supportSize = 0;
    
    return 0;
 }
@@ -213,14 +423,34 @@ void bdd_operator_done(void)
    BddCache_done(&appexcache);
    BddCache_done(&replacecache);
    BddCache_done(&misccache);
+   BddCache_done(&testcache);
 
    if (supportSet != NULL)
      free(supportSet);
    supportSet = NULL;
+
+   free(iterstack);
+   iterstack = NULL;
+   itermaxdepth = 0;
+   opengine = BDD_ENGINE_RECURSIVE;
+   cachemode = BDD_CACHE_RESET;
+   cachebudget = 0;
+   cache_handler = NULL;
+   optiming = 0;
+   supportSize = 0;
+
+   countmemo_free();
+   countmemoon = 0;
+
+   nary_free();
+   free(narystack);
+   narystack = NULL;
+   narystacksize = 0;
+   naryschedule = BDD_NARY_SIZE;
 }
 
 
-void bdd_operator_reset(void)
+static void cache_reset(void)
 {
    BddCache_reset(&applycache);
    BddCache_reset(&itecache);
@@ -228,6 +458,129 @@ void bdd_operator_reset(void)
    BddCache_reset(&appexcache);
    BddCache_reset(&replacecache);
    BddCache_reset(&misccache);
+   BddCache_reset(&testcache);
+}
+
+
+void bdd_operator_reset(void)
+{
+   cache_reset();
+   nary_reset();
+   countmemo_clear();
+}
+
+
+   /* Cache ids store the variable set shifted by up to eight bits. If the
+      node numbers can get bigger than this allows, the ids cannot be
+      decoded safely and entries keyed by a variable set are dropped */
+#ifdef BDD_INDEX64
+#define CACHEID_MAXVAR (LLONG_MAX >> 8)
+#else
+#define CACHEID_MAXVAR (INT_MAX >> 8)
+#endif
+
+   /* Tells whether the edge n refers to a node that survived the gbc.
+      Unused fields may hold anything, so n is checked for range too. */
+static int cache_live(BDD n)
+{
+   if (ISCONST(n))
+      return n >= 0;
+   return NODE(n) < bddnodesize  &&  !ISFREE(n);
+}
+
+static int cache_livevar(BDD id, int shift)
+{
+   if (EDGE(bddnodesize) > CACHEID_MAXVAR)
+      return 0;
+   return cache_live(id >> shift);
+}
+
+static int keep_apply(BddCacheData *e)
+{
+   if (e->c == bddop_not)
+      return cache_live(e->a)  &&  cache_live(e->r.res);
+   return cache_live(e->a)  &&  cache_live(e->b)  &&  cache_live(e->r.res);
+}
+
+static int keep_ite(BddCacheData *e)
+{
+   return cache_live(e->a)  &&  cache_live(e->b)  &&  cache_live(e->c)
+      &&  cache_live(e->r.res);
+}
+
+static int keep_quant(BddCacheData *e)
+{
+   int shift = (e->c & 0x7) <= CACHEID_UNIQUE ? 3 : 8;
+   return cache_live(e->a)  &&  cache_live(e->r.res)
+      &&  cache_livevar(e->c, shift);
+}
+
+static int keep_appex(BddCacheData *e)
+{
+   return cache_live(e->a)  &&  cache_live(e->b)  &&  cache_live(e->r.res)
+      &&  cache_livevar(e->c, 5);
+}
+
+static int keep_replace(BddCacheData *e)
+{
+   if ((e->c & 0x3) == CACHEID_COMPOSE  &&  !cache_live(e->b))
+      return 0;
+   return cache_live(e->a)  &&  cache_live(e->r.res);
+}
+
+static int keep_test(BddCacheData *e)
+{
+   return cache_live(e->a)  &&  cache_live(e->b)  &&  cache_live(e->r.res);
+}
+
+static int keep_misc(BddCacheData *e)
+{
+   switch (e->c)
+   {
+   case CACHEID_SATCOU:
+   case CACHEID_SATCOULN:
+   case CACHEID_PATHCOU:
+      return cache_live(e->a);
+   case CACHEID_CONSTRAIN:
+      return cache_live(e->a)  &&  cache_live(e->b)  &&  cache_live(e->r.res);
+   }
+   return cache_live(e->a)  &&  cache_live(e->r.res)
+      &&  cache_livevar(e->c, 3);
+}
+
+
+/* Called by the garbage collector when the dead nodes have been freed */
+void bdd_operator_gbc(void)
+{
+   BDD n;
+
+      /* The count memo only forgets the freed nodes */
+   for (n=0 ; n<countmemosize  &&  n<bddnodesize ; n++)
+      if (countmemo[n].valid  &&  bddnodes[n].low == -1)
+	 countmemo[n].valid = 0;
+   for (n=0 ; n<countexactsize  &&  n<bddnodesize ; n++)
+      if (countexact[n] != NULL  &&  bddnodes[n].low == -1)
+      {
+	 free(countexact[n]);
+	 countexact[n] = NULL;
+      }
+
+      /* The n-ary cache has no selective cleaning */
+   nary_reset();
+   
+   if (cachemode != BDD_CACHE_SELECTIVE)
+   {
+      cache_reset();
+      return;
+   }
+
+   BddCache_clean(&applycache, keep_apply);
+   BddCache_clean(&itecache, keep_ite);
+   BddCache_clean(&quantcache, keep_quant);
+   BddCache_clean(&appexcache, keep_appex);
+   BddCache_clean(&replacecache, keep_replace);
+   BddCache_clean(&misccache, keep_misc);
+   BddCache_clean(&testcache, keep_test);
 }
 
 
@@ -242,17 +595,24 @@ void bdd_operator_varresize(void)
    memset(quantvarset, 0, sizeof(int)*bddvarnum);
    quantvarsetID = 0;
 
+      /* The levels strictly increase along the frames of the iterative
+	 operators, so there are never more frames than levels */
+   free(iterstack);
+   if ((iterstack=NEW(BddFrame,bddvarnum+2)) == NULL)
+      bdd_error(BDD_MEMORY);
+
    /* Bug fix: */
    /* After changing number of vars, satcount results are no longer valid. */
    BddCache_reset(&misccache);
+   countmemo_clear();
 }
 
 
 static void bdd_operator_noderesize(void)
 {
-   if (cacheratio > 0)
+   if (cacheratio > 0  &&  cachebudget == 0)
    {
-      int newcachesize = bddnodesize / cacheratio;
+      int newcachesize = (int)(bddnodesize / cacheratio);
       
       BddCache_resize(&applycache, newcachesize);
       BddCache_resize(&itecache, newcachesize);
@@ -260,7 +620,158 @@ static void bdd_operator_noderesize(void)
       BddCache_resize(&appexcache, newcachesize);
       BddCache_resize(&replacecache, newcachesize);
       BddCache_resize(&misccache, newcachesize);
+      BddCache_resize(&testcache, newcachesize);
+   }
+}
+
+
+/*************************************************************************
+  Adaptive cache sizes
+*************************************************************************/
+
+#define CACHENUM      BDD_CACHENUM  /* Number of operator caches */
+#define CACHEMINSIZE  1024   /* Smallest size of an adaptive cache */
+
+static const char *cachename[CACHENUM] =
+{ "apply", "ite", "quant", "appex", "replace", "misc", "test" };
+
+static void cachelist(BddCache **cache)
+{
+   cache[0] = &applycache;
+   cache[1] = &itecache;
+   cache[2] = &quantcache;
+   cache[3] = &appexcache;
+   cache[4] = &replacecache;
+   cache[5] = &misccache;
+   cache[6] = &testcache;
+}
+
+
+static void cache_resetcount(BddCache **cache)
+{
+   int n;
+   for (n=0 ; n<CACHENUM ; n++)
+      BddCache_sumcount(cache[n]);
+}
+
+
+   /* A cache is under pressure when at least half of its entries were
+      overwritten, and idle when looked up less than once per 16 entries */
+#define CACHEPRESSED(c) ((c)->overwrites >= (long unsigned int)(c)->tablesize/2)
+#define CACHEIDLE(c)    ((c)->hits+(c)->misses < (long unsigned int)(c)->tablesize/16)
+
+
+/* Revises the cache sizes when the caches have been used enough since the
+   last revision to tell anything. Caches are freed and allocated here, so
+   this must only be called before an operation starts. */
+static void bdd_operator_adapt(void)
+{
+   BddCache *cache[CACHENUM];
+   int newsize[CACHENUM];
+   int done[CACHENUM];
+   long unsigned int lookups = 0;
+   long total = 0, entries = 0;
+   int minsize, n, m;
+
+   cachelist(cache);
+   for (n=0 ; n<CACHENUM ; n++)
+   {
+      lookups += cache[n]->hits + cache[n]->misses;
+      entries += cache[n]->tablesize;
+   }
+   if (lookups < (long unsigned int)entries)
+      return;
+
+      /* Shrink the idle caches, but not below half of an even share of
+	 the budget, since a cache may be idle only in one phase of the
+	 computation and the sizes can only change between operations */
+   minsize = MAX(CACHEMINSIZE, cachebudget/(2*CACHENUM));
+   for (n=0 ; n<CACHENUM ; n++)
+   {
+      newsize[n] = cache[n]->tablesize;
+      done[n] = 0;
+      if (CACHEIDLE(cache[n])  &&  newsize[n] > minsize)
+	 newsize[n] = BddCache_size(MAX(newsize[n]/2, minsize));
+      total += newsize[n];
+   }
+
+      /* Grow the caches under pressure within the budget, those with the
+	 most overwrites per entry first. The space may be taken from the
+	 cache with the fewest lookups per entry. */
+   for (m=0 ; m<CACHENUM ; m++)
+   {
+      int best = -1, victim = -1, grown;
+      
+      for (n=0 ; n<CACHENUM ; n++)
+	 if (!done[n]  &&  CACHEPRESSED(cache[n])  &&
+	     (best < 0  ||  (double)cache[n]->overwrites/cache[n]->tablesize >
+	      (double)cache[best]->overwrites/cache[best]->tablesize))
+	    best = n;
+      if (best < 0)
+	 break;
+      done[best] = 1;
+      
+      if (newsize[best] > INT_MAX/2)
+	 continue;
+      grown = BddCache_size(2*newsize[best]);
+      
+      if (total - newsize[best] + grown > cachebudget)
+      {
+	 for (n=0 ; n<CACHENUM ; n++)
+	    if (n != best  &&  !CACHEPRESSED(cache[n])  &&
+		newsize[n] > minsize  &&
+		(victim < 0  ||
+		 (double)(cache[n]->hits+cache[n]->misses)/newsize[n] <
+		 (double)(cache[victim]->hits+cache[victim]->misses)/newsize[victim]))
+	       victim = n;
+	 if (victim < 0)
+	    continue;
+	 
+	 n = BddCache_size(MAX(newsize[victim]/2, minsize));
+	 if (total - newsize[best] + grown - newsize[victim] + n > cachebudget)
+	    continue;
+	 total += n - newsize[victim];
+	 newsize[victim] = n;
+      }
+      
+      total += grown - newsize[best];
+      newsize[best] = grown;
+   }
+
+      /* Halve the largest caches if the budget has been lowered */
+   while (total > cachebudget)
+   {
+      int largest = 0;
+      for (n=1 ; n<CACHENUM ; n++)
+	 if (newsize[n] > newsize[largest])
+	    largest = n;
+      if (newsize[largest] <= CACHEMINSIZE)
+	 break;
+      n = BddCache_size(MAX(newsize[largest]/2, CACHEMINSIZE));
+      total += n - newsize[largest];
+      newsize[largest] = n;
+   }
+
+   for (n=0 ; n<CACHENUM ; n++)
+   {
+      bddCacheAdapt stat;
+      
+      stat.name = cachename[n];
+      stat.oldsize = cache[n]->tablesize;
+      stat.hits = cache[n]->hits;
+      stat.misses = cache[n]->misses;
+      stat.overwrites = cache[n]->overwrites;
+      
+	 /* A cache that cannot be allocated keeps its old size */
+      if (newsize[n] != cache[n]->tablesize)
+	 BddCache_setsize(cache[n], newsize[n]);
+      stat.newsize = cache[n]->tablesize;
+      
+      if (cache_handler != NULL)
+	 cache_handler(&stat);
    }
+
+   cache_resetcount(cache);
 }
 
 
@@ -283,6 +794,130 @@ int bdd_setcacheratio(int r)
 }
 
 
+int bdd_setcachemode(int mode)
+{
+   int old = cachemode;
+
+   if (mode != BDD_CACHE_RESET  &&  mode != BDD_CACHE_SELECTIVE)
+      return bdd_error(BDD_RANGE);
+
+   cachemode = mode;
+   return old;
+}
+
+
+int bdd_setcachebudget(int budget)
+{
+   BddCache *cache[CACHENUM];
+   int old = cachebudget;
+   long total = 0;
+   int n;
+
+   if (budget < 0  ||  (budget > 0  &&  budget < CACHENUM*CACHEMINSIZE))
+      return bdd_error(BDD_RANGE);
+   
+   cachebudget = budget;
+   cachelist(cache);
+   
+   if (budget == 0)
+   {
+	 /* Back to the common fixed size */
+      int size = cacheratio > 0 ? (int)(bddnodesize / cacheratio)
+	 : bddcachesize;
+      if (old > 0)
+	 for (n=0 ; n<CACHENUM ; n++)
+	    if (BddCache_resize(cache[n], size) < 0)
+	       return bdd_error(BDD_MEMORY);
+      return old;
+   }
+
+   for (n=0 ; n<CACHENUM ; n++)
+      total += cache[n]->tablesize;
+
+      /* Start from an even split if the caches are too big already */
+   if (total > budget)
+      for (n=0 ; n<CACHENUM ; n++)
+	 if (BddCache_resize(cache[n], BddCache_fit(budget/CACHENUM)) < 0)
+	    return bdd_error(BDD_MEMORY);
+   cache_resetcount(cache);
+   
+   return old;
+}
+
+
+bddcachehandler bdd_cache_hook(bddcachehandler handler)
+{
+   bddcachehandler tmp = cache_handler;
+   cache_handler = handler;
+   return tmp;
+}
+
+
+static const char *opstatname[BDD_OPSTATNUM] =
+{ "not", "apply", "ite", "restrict", "constrain", "replace", "compose",
+  "veccompose", "simplify", "exist", "forall", "unique", "appex", "appall",
+  "appuni", "satcount", "satcountln", "pathcount", "satcountexact",
+  "applyn", "appexn", "leq", "disjoint", "equalunder" };
+
+int bdd_setstattime(int enable)
+{
+   int old = optiming;
+   optiming = (enable != 0);
+   return old;
+}
+
+
+   /* Total usage of the caches and calls of the operators since bdd_init */
+void bdd_operator_stats(bddCacheUsage *usage, bddOpStat *op)
+{
+   BddCache *cache[CACHENUM];
+   int n;
+
+   cachelist(cache);
+   for (n=0 ; n<CACHENUM ; n++)
+   {
+      usage[n].name = cachename[n];
+      usage[n].size = cache[n]->tablesize;
+      usage[n].hits = cache[n]->sumhits + cache[n]->hits;
+      usage[n].lookups = usage[n].hits +
+	 cache[n]->summisses + cache[n]->misses;
+      usage[n].overwrites = cache[n]->sumoverwrites + cache[n]->overwrites;
+      usage[n].resizes = cache[n]->resizes;
+   }
+
+   for (n=0 ; n<BDD_OPSTATNUM ; n++)
+   {
+      op[n].name = opstatname[n];
+      op[n].calls = opcalls[n];
+      op[n].time = optime[n];
+   }
+}
+
+
+int bdd_setengine(int kind)
+{
+   int old = opengine;
+
+   if (kind != BDD_ENGINE_RECURSIVE  &&  kind != BDD_ENGINE_ITERATIVE)
+      return bdd_error(BDD_RANGE);
+
+   opengine = kind;
+   return old;
+}
+
+
+int bdd_setnaryschedule(int mode)
+{
+   int old = naryschedule;
+
+   if (mode < BDD_NARY_SIZE  ||  mode > BDD_NARY_RECURSIVE)
+      return bdd_error(BDD_RANGE);
+
+   naryschedule = mode;
+   return old;
+}
+
+
 /*************************************************************************
   Operators
 *************************************************************************/
@@ -292,6 +927,8 @@ static void checkresize(void)
    if (bddresized)
       bdd_operator_noderesize();
    bddresized = 0;
+   if (cachebudget > 0)
+      bdd_operator_adapt();
 }
 
 
@@ -355,9 +992,16 @@ BDD bdd_ibuildcube(int value, int width, int *variables)
 BDD bdd_not(BDD r)
 {
    BDD res;
+   clock_t opstart;
    firstReorder = 1;
    CHECKa(r, bddfalse);
+   opstart = OPBEGIN(OPSTAT_NOT);
 
+#ifdef COMPLEMENT_EDGES
+      /* Negation only flips the complement bit */
+   return OPEND(OPSTAT_NOT, opstart, NOT(r));
+#endif
+   
  again:
    if (setjmp(bddexception) == 0)
    {
@@ -378,7 +1022,7 @@ BDD bdd_not(BDD r)
    }
 
    checkresize();
-   return res;
+   return OPEND(OPSTAT_NOT, opstart, res);
 }
 
 
@@ -387,23 +1031,23 @@ static BDD not_rec(BDD r)
    BddCacheData *entry;
    BDD res;
 
+#ifdef COMPLEMENT_EDGES
+   return NOT(r);
+#endif
+   
    if (ISZERO(r))
       return BDDONE;
    if (ISONE(r))
       return BDDZERO;
    
-   entry = BddCache_lookup(&applycache, NOTHASH(r));
+   entry = BddCache_lookup2(&applycache, NOTHASH(r), r, bddop_not);
       
    if (entry->a == r  &&  entry->c == bddop_not)
    {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
-#endif
+      CACHEHIT(applycache);
       return entry->r.res;
    }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
-#endif
+   CACHEMISS(applycache, entry);
    
    PUSHREF( not_rec(LOW(r)) );
    PUSHREF( not_rec(HIGH(r)) );
@@ -420,11 +1064,29 @@ static BDD not_rec(BDD r)
 
 /*=== APPLY ============================================================*/
 
-BDD bdd_apply(BDD l, BDD r, int op)
+   /* Less than and inverse implication are difference and implication
+      with the operands swapped. Mapping them onto those lets the two
+      forms share cache entries. */
+static int apply_swapop(int op, BDD *l, BDD *r)
 {
-   BDD res;
-   firstReorder = 1;
+   BDD tmp;
    
+   if (op == bddop_less)
+      op = bddop_diff;
+   else if (op == bddop_invimp)
+      op = bddop_imp;
+   else
+      return op;
+
+   tmp = *l;
+   *l = *r;
+   *r = tmp;
+   return op;
+}
+
+
+BDD bdd_apply(BDD l, BDD r, int op)
+{
    CHECKa(l, bddfalse);
    CHECKa(r, bddfalse);
 
@@ -433,16 +1095,40 @@ BDD bdd_apply(BDD l, BDD r, int op)
       bdd_error(BDD_OP);
       return bddfalse;
    }
+   op = apply_swapop(op, &l, &r);
+   return apply_run(l, r, op);
+}
+
+
+   /* Does the work of bdd_apply once the operands are in order. The
+      setjmp is kept out of bdd_apply so the operands it swaps cannot be
+      clobbered by the longjmp. */
+static BDD apply_run(BDD l, BDD r, int op)
+{
+   BDD res;
+   clock_t opstart;
+   firstReorder = 1;
+   
+   opstart = OPBEGIN(OPSTAT_APPLY);
 
  again:
    if (setjmp(bddexception) == 0)
    {
       INITREF;
       applyop = op;
+
+#ifdef BDD_THREADS
+      if (bddthreadnum > 1  &&
+	  (res=bdd_par_run(par_apply_task, l, r, op)) >= 0)
+      {
+	 checkresize();
+	 return OPEND(OPSTAT_APPLY, opstart, res);
+      }
+#endif
       
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = apply_rec(l, r);
+      res = RUNOP(apply, (l, r));
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -456,16 +1142,14 @@ BDD bdd_apply(BDD l, BDD r, int op)
    }
    
    checkresize();
-   return res;
+   return OPEND(OPSTAT_APPLY, opstart, res);
 }
 
 
-static BDD apply_rec(BDD l, BDD r)
+   /* Shortcuts for apply - returns -1 if the result has to be calculated */
+static BDD apply_terminal(int op, BDD l, BDD r)
 {
-   BddCacheData *entry;
-   BDD res;
-   
-   switch (applyop)
+   switch (op)
    {
     case bddop_and:
        if (l == r)
@@ -476,6 +1160,10 @@ static BDD apply_rec(BDD l, BDD r)
 	  return r;
        if (ISONE(r))
 	  return l;
+#ifdef COMPLEMENT_EDGES
+       if (l == NOT(r))
+	  return 0;
+#endif
        break;
     case bddop_or:
        if (l == r)
@@ -494,6 +1182,10 @@ static BDD apply_rec(BDD l, BDD r)
 	  return r;
        if (ISZERO(r))
 	  return l;
+#ifdef COMPLEMENT_EDGES
+       if (l == NOT(r))
+	  return 1;
+#endif
        break;
     case bddop_nand:
        if (ISZERO(l) || ISZERO(r))
@@ -514,59 +1206,89 @@ static BDD apply_rec(BDD l, BDD r)
    }
 
    if (ISCONST(l)  &&  ISCONST(r))
-      res = oprres[applyop][l<<1 | r];
-   else
-   {
-      entry = BddCache_lookup(&applycache, APPLYHASH(l,r,applyop));
-      
-      if (entry->a == l  &&  entry->b == r  &&  entry->c == applyop)
-      {
-#ifdef CACHESTATS
-	 bddcachestats.opHit++;
-#endif
-	 return entry->r.res;
-      }
-#ifdef CACHESTATS
-      bddcachestats.opMiss++;
-#endif
-      
-      if (LEVEL(l) == LEVEL(r))
-      {
-	 PUSHREF( apply_rec(LOW(l), LOW(r)) );
-	 PUSHREF( apply_rec(HIGH(l), HIGH(r)) );
-	 res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
-      }
-      else
-      if (LEVEL(l) < LEVEL(r))
-      {
-	 PUSHREF( apply_rec(LOW(l), r) );
-	 PUSHREF( apply_rec(HIGH(l), r) );
-	 res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
-      }
-      else
-      {
-	 PUSHREF( apply_rec(l, LOW(r)) );
-	 PUSHREF( apply_rec(l, HIGH(r)) );
-	 res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
-      }
-
-      POPREF(2);
-
-      entry->a = l;
-      entry->b = r;
-      entry->c = applyop;
-      entry->r.res = res;
-   }
-
-   return res;
+      return oprres[op][l<<1 | r];
+   
+   return -1;
 }
 
 
-BDD bdd_and(BDD l, BDD r)
+static BDD apply_rec(BDD l, BDD r)
 {
-   return bdd_apply(l,r,bddop_and);
-}
-
+   BddCacheData *entry;
+   BDD res;
+
+#ifdef COMPLEMENT_EDGES
+   if (applyop != bddop_and  &&  applyop != bddop_xor)
+   {
+      int oldop = applyop;
+      applyop = oprce[oldop][0];
+      res = apply_rec(l ^ oprce[oldop][1], r ^ oprce[oldop][2]);
+      applyop = oldop;
+      return res ^ oprce[oldop][3];
+   }
+#endif
+
+   if ((res=apply_terminal(applyop, l, r)) >= 0)
+      return res;
+   
+#ifdef COMPLEMENT_EDGES
+      /* Only cache xor of regular edges: l^r = !l^!r */
+   if (applyop == bddop_xor  &&  (ISCOMPL(l)  ||  ISCOMPL(r)))
+      return apply_rec(REGULAR(l), REGULAR(r)) ^ ((l ^ r) & 1);
+#endif
+   
+   if (l > r  &&  COMMUTATIVE(applyop))
+   {
+      BDD tmp = l;
+      l = r;
+      r = tmp;
+   }
+   
+   entry = BddCache_lookup3(&applycache, APPLYHASH(l,r,applyop), l, r, applyop);
+      
+   if (entry->a == l  &&  entry->b == r  &&  entry->c == applyop)
+   {
+      CACHEHIT(applycache);
+      return entry->r.res;
+   }
+   CACHEMISS(applycache, entry);
+      
+   if (LEVEL(l) == LEVEL(r))
+   {
+      PUSHREF( apply_rec(LOW(l), LOW(r)) );
+      PUSHREF( apply_rec(HIGH(l), HIGH(r)) );
+      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+   }
+   else
+   if (LEVEL(l) < LEVEL(r))
+   {
+      PUSHREF( apply_rec(LOW(l), r) );
+      PUSHREF( apply_rec(HIGH(l), r) );
+      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+   }
+   else
+   {
+      PUSHREF( apply_rec(l, LOW(r)) );
+      PUSHREF( apply_rec(l, HIGH(r)) );
+      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+   }
+
+   POPREF(2);
+
+   entry->a = l;
+   entry->b = r;
+   entry->c = applyop;
+   entry->r.res = res;
+
+   return res;
+}
+
+
+BDD bdd_and(BDD l, BDD r)
+{
+   return bdd_apply(l,r,bddop_and);
+}
+
 
 BDD bdd_or(BDD l, BDD r)
 {
@@ -592,362 +1314,674 @@ BDD bdd_biimp(BDD l, BDD r)
 }
 
 
-/*=== ITE ==============================================================*/
+/*=== CONTAINMENT TESTS ================================================*/
 
-BDD bdd_ite(BDD f, BDD g, BDD h)
+   /* These only read the node table and keep their answers (one or zero)
+      in testcache. The recursion stops at the first counterexample. */
+
+static int leq_rec(BDD f, BDD g);
+static int disjoint_rec(BDD f, BDD g);
+static int equal_rec(BDD f, BDD g, BDD c);
+
+int bdd_leq(BDD f, BDD g)
 {
-   BDD res;
-   firstReorder = 1;
-   
-   CHECKa(f, bddfalse);
-   CHECKa(g, bddfalse);
-   CHECKa(h, bddfalse);
+   clock_t opstart;
 
- again:
-   if (setjmp(bddexception) == 0)
-   {
-      INITREF;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = ite_rec(f,g,h);
-      if (!firstReorder)
-	 bdd_enable_reorder();
-   }
-   else
-   {
-      bdd_checkreorder();
+   CHECK(f);
+   CHECK(g);
 
-      if (firstReorder-- == 1)
-	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
-   }
+   opstart = OPBEGIN(OPSTAT_LEQ);
+   return OPEND(OPSTAT_LEQ, opstart, leq_rec(f, g));
+}
 
-   checkresize();
-   return res;
+
+int bdd_disjoint(BDD f, BDD g)
+{
+   clock_t opstart;
+
+   CHECK(f);
+   CHECK(g);
+
+   opstart = OPBEGIN(OPSTAT_DISJOINT);
+   return OPEND(OPSTAT_DISJOINT, opstart, disjoint_rec(f, g));
 }
 
 
-static BDD ite_rec(BDD f, BDD g, BDD h)
+int bdd_equal_under(BDD f, BDD g, BDD care)
 {
-   BddCacheData *entry;
-   BDD res;
+   clock_t opstart;
 
-   if (ISONE(f))
-      return g;
-   if (ISZERO(f))
-      return h;
-   if (g == h)
-      return g;
-   if (ISONE(g) && ISZERO(h))
-      return f;
-   if (ISZERO(g) && ISONE(h))
-      return not_rec(f);
+   CHECK(f);
+   CHECK(g);
+   CHECK(care);
 
-   entry = BddCache_lookup(&itecache, ITEHASH(f,g,h));
-   if (entry->a == f  &&  entry->b == g  &&  entry->c == h)
-   {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
-#endif
-      return entry->r.res;
-   }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
+   opstart = OPBEGIN(OPSTAT_EQUALUNDER);
+   return OPEND(OPSTAT_EQUALUNDER, opstart, equal_rec(f, g, care));
+}
+
+
+static int leq_rec(BDD f, BDD g)
+{
+   BddCacheData *entry;
+   int res, level;
+
+   if (f == g  ||  ISZERO(f)  ||  ISONE(g))
+      return 1;
+   if (ISCONST(f)  ||  ISCONST(g))
+      return 0;
+#ifdef COMPLEMENT_EDGES
+   if (f == NOT(g))
+      return 0;
 #endif
-      
-   if (LEVEL(f) == LEVEL(g))
-   {
-      if (LEVEL(f) == LEVEL(h))
-      {
-	 PUSHREF( ite_rec(LOW(f), LOW(g), LOW(h)) );
-	 PUSHREF( ite_rec(HIGH(f), HIGH(g), HIGH(h)) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
-      else
-      if (LEVEL(f) < LEVEL(h))
-      {
-	 PUSHREF( ite_rec(LOW(f), LOW(g), h) );
-	 PUSHREF( ite_rec(HIGH(f), HIGH(g), h) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
-      else /* f > h */
-      {
-	 PUSHREF( ite_rec(f, g, LOW(h)) );
-	 PUSHREF( ite_rec(f, g, HIGH(h)) );
-	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
-      }
-   }
-   else
-   if (LEVEL(f) < LEVEL(g))
-   {
-      if (LEVEL(f) == LEVEL(h))
-      {
-	 PUSHREF( ite_rec(LOW(f), g, LOW(h)) );
-	 PUSHREF( ite_rec(HIGH(f), g, HIGH(h)) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
-      else
-      if (LEVEL(f) < LEVEL(h))
-      {
-	 PUSHREF( ite_rec(LOW(f), g, h) );
-	 PUSHREF( ite_rec(HIGH(f), g, h) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
-      else /* f > h */
-      {
-	 PUSHREF( ite_rec(f, g, LOW(h)) );
-	 PUSHREF( ite_rec(f, g, HIGH(h)) );
-	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
-      }
-   }
-   else /* f > g */
+
+   entry = BddCache_lookup3(&testcache, TESTHASH(f,g,TESTID_LEQ), f, g,
+			    TESTID_LEQ);
+   if (entry->a == f  &&  entry->b == g  &&  entry->c == TESTID_LEQ)
    {
-      if (LEVEL(g) == LEVEL(h))
-      {
-	 PUSHREF( ite_rec(f, LOW(g), LOW(h)) );
-	 PUSHREF( ite_rec(f, HIGH(g), HIGH(h)) );
-	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
-      }
-      else
-      if (LEVEL(g) < LEVEL(h))
-      {
-	 PUSHREF( ite_rec(f, LOW(g), h) );
-	 PUSHREF( ite_rec(f, HIGH(g), h) );
-	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
-      }
-      else /* g > h */
-      {
-	 PUSHREF( ite_rec(f, g, LOW(h)) );
-	 PUSHREF( ite_rec(f, g, HIGH(h)) );
-	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
-      }
+      CACHEHIT(testcache);
+      return (int)entry->r.res;
    }
+   CACHEMISS(testcache, entry);
 
-   POPREF(2);
+   level = MIN(LEVEL(f), LEVEL(g));
+   res = leq_rec(LOWCOF(f,level), LOWCOF(g,level))  &&
+      leq_rec(HIGHCOF(f,level), HIGHCOF(g,level));
 
    entry->a = f;
    entry->b = g;
-   entry->c = h;
+   entry->c = TESTID_LEQ;
    entry->r.res = res;
-
+   
    return res;
 }
 
 
-/*=== RESTRICT =========================================================*/
-
-BDD bdd_restrict(BDD r, BDD var)
+static int disjoint_rec(BDD f, BDD g)
 {
-   BDD res;
-   firstReorder = 1;
-   
-   CHECKa(r,bddfalse);
-   CHECKa(var,bddfalse);
-   
-   if (var < 2)  /* Empty set */
-      return r;
-   
- again:
-   if (setjmp(bddexception) == 0)
-   {
-      if (varset2svartable(var) < 0)
-	 return bddfalse;
+   BddCacheData *entry;
+   int res, level;
 
-      INITREF;
-      miscid = (var << 3) | CACHEID_RESTRICT;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = restrict_rec(r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+   if (ISZERO(f)  ||  ISZERO(g))
+      return 1;
+   if (ISCONST(f)  ||  ISCONST(g)  ||  f == g)
+      return 0;
+#ifdef COMPLEMENT_EDGES
+   if (f == NOT(g))
+      return 1;
+#endif
+
+   if (f > g)
+   {
+      BDD tmp = f;
+      f = g;
+      g = tmp;
    }
-   else
+   
+   entry = BddCache_lookup3(&testcache, TESTHASH(f,g,TESTID_DISJOINT), f, g,
+			    TESTID_DISJOINT);
+   if (entry->a == f  &&  entry->b == g  &&  entry->c == TESTID_DISJOINT)
    {
-      bdd_checkreorder();
-
-      if (firstReorder-- == 1)
-	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
+      CACHEHIT(testcache);
+      return (int)entry->r.res;
    }
+   CACHEMISS(testcache, entry);
 
-   checkresize();
+   level = MIN(LEVEL(f), LEVEL(g));
+   res = disjoint_rec(LOWCOF(f,level), LOWCOF(g,level))  &&
+      disjoint_rec(HIGHCOF(f,level), HIGHCOF(g,level));
+
+   entry->a = f;
+   entry->b = g;
+   entry->c = TESTID_DISJOINT;
+   entry->r.res = res;
+   
    return res;
 }
 
 
-static int restrict_rec(int r)
+static int equal_rec(BDD f, BDD g, BDD c)
 {
    BddCacheData *entry;
-   int res;
-   
-   if (ISCONST(r)  ||  LEVEL(r) > quantlast)
-      return r;
+   int res, level;
 
-   entry = BddCache_lookup(&misccache, RESTRHASH(r,miscid));
-   if (entry->a == r  &&  entry->c == miscid)
-   {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
-#endif
-      return entry->r.res;
-   }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
+   if (f == g  ||  ISZERO(c))
+      return 1;
+      /* f and g differ somewhere and c is not empty */
+   if ((ISCONST(f)  &&  ISCONST(g))  ||  ISONE(c))
+      return 0;
+#ifdef COMPLEMENT_EDGES
+   if (f == NOT(g))
+      return 0;
 #endif
-   
-   if (INSVARSET(LEVEL(r)))
+
+   if (f > g)
    {
-      if (quantvarset[LEVEL(r)] > 0)
-	 res = restrict_rec(HIGH(r));
-      else
-	 res = restrict_rec(LOW(r));
+      BDD tmp = f;
+      f = g;
+      g = tmp;
    }
-   else
+   
+   entry = BddCache_lookup3r(&testcache, TESTHASH(f,g,c), f, g, c);
+   if (entry->a == f  &&  entry->b == g  &&  entry->r.res == c  &&
+       (entry->c & 0x3) == TESTID_EQUAL)
    {
-      PUSHREF( restrict_rec(LOW(r)) );
-      PUSHREF( restrict_rec(HIGH(r)) );
-      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
-      POPREF(2);
+      CACHEHIT(testcache);
+      return (int)(entry->c >> 2);
    }
+   CACHEMISS(testcache, entry);
 
-   entry->a = r;
-   entry->c = miscid;
-   entry->r.res = res;
+   level = MIN(MIN(LEVEL(f), LEVEL(g)), LEVEL(c));
+   res = equal_rec(LOWCOF(f,level), LOWCOF(g,level), LOWCOF(c,level))  &&
+      equal_rec(HIGHCOF(f,level), HIGHCOF(g,level), HIGHCOF(c,level));
 
+   entry->a = f;
+   entry->b = g;
+   entry->c = ((BDD)res << 2) | TESTID_EQUAL;
+   entry->r.res = c;
+   
    return res;
 }
 
 
-/*=== GENERALIZED COFACTOR =============================================*/
+/*=== N-ARY APPLY ======================================================*/
 
-BDD bdd_constrain(BDD f, BDD c)
+   /* The constant that leaves the result of an n-ary operator unchanged
+      and the one that decides it (-1 for xor, which has none) */
+#define NARYUNIT(op)   ((op) == bddop_and ? BDDONE : BDDZERO)
+#define NARYABSORB(op) \
+   ((op) == bddop_and ? BDDZERO : (op) == bddop_or ? BDDONE : -1)
+
+BDD bdd_apply_n(BDD *r, int num, int op)
 {
    BDD res;
-   firstReorder = 1;
-   
-   CHECKa(f,bddfalse);
-   CHECKa(c,bddfalse);
-   
- again:
-   if (setjmp(bddexception) == 0)
+   clock_t opstart;
+   int n;
+
+   if (num < 0)
    {
-      INITREF;
-      miscid = CACHEID_CONSTRAIN;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = constrain_rec(f, c);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+      bdd_error(BDD_RANGE);
+      return bddfalse;
+   }
+   for (n=0 ; n<num ; n++)
+      CHECKa(r[n], bddfalse);
+   
+   if (op != bddop_and  &&  op != bddop_or  &&  op != bddop_xor)
+   {
+      bdd_error(BDD_OP);
+      return bddfalse;
    }
+   opstart = OPBEGIN(OPSTAT_APPLYN);
+
+   if (naryschedule == BDD_NARY_RECURSIVE)
+      res = nary_recursive(r, num, op);
    else
+      res = nary_pairwise(r, num, op);
+
+   return OPEND(OPSTAT_APPLYN, opstart, res);
+}
+
+
+BDD bdd_and_n(BDD *r, int num)
+{
+   return bdd_apply_n(r, num, bddop_and);
+}
+
+
+BDD bdd_or_n(BDD *r, int num)
+{
+   return bdd_apply_n(r, num, bddop_or);
+}
+
+
+   /* Marks the variables in the support of r in the bitmap sup */
+static void nary_support_rec(BDD r, unsigned int *sup)
+{
+   BddNode *node;
+   int var;
+   
+   if (ISCONST(r))
+      return;
+
+   node = &bddnodes[NODE(r)];
+   if (LEVELp(node) & MARKON)
+      return;
+
+   var = bddlevel2var[LEVELp(node)];
+   sup[var >> 5] |= 1U << (var & 31);
+   LEVELp(node) |= MARKON;
+   
+   nary_support_rec(LOWp(node), sup);
+   nary_support_rec(HIGHp(node), sup);
+}
+
+
+static void nary_support(BDD r, unsigned int *sup, int words)
+{
+   memset(sup, 0, sizeof(unsigned int)*words);
+   nary_support_rec(r, sup);
+   bdd_unmark(r);
+}
+
+
+static int nary_overlap(unsigned int *a, unsigned int *b, int words)
+{
+   int cou = 0;
+   int n;
+
+   for (n=0 ; n<words ; n++)
+      cou += __builtin_popcount(a[n] & b[n]);
+   return cou;
+}
+
+
+   /* Min-heap on the node counts of the operands */
+static void nary_siftup(BddNaryItem *heap, int n)
+{
+   BddNaryItem tmp = heap[n];
+
+   while (n > 0  &&  heap[(n-1)/2].size > tmp.size)
    {
-      bdd_checkreorder();
+      heap[n] = heap[(n-1)/2];
+      n = (n-1)/2;
+   }
+   heap[n] = tmp;
+}
 
-      if (firstReorder-- == 1)
-	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
+
+static BddNaryItem nary_pop(BddNaryItem *heap, int num)
+{
+   BddNaryItem top = heap[0];
+   BddNaryItem tmp = heap[num-1];
+   int n = 0;
+
+   num--;
+   while (2*n+1 < num)
+   {
+      int c = 2*n+1;
+      if (c+1 < num  &&  heap[c+1].size < heap[c].size)
+	 c++;
+      if (heap[c].size >= tmp.size)
+	 break;
+      heap[n] = heap[c];
+      n = c;
    }
+   heap[n] = tmp;
+   return top;
+}
 
-   checkresize();
-   return res;
+
+   /* Picks the two operands to merge next with BDD_NARY_SUPPORT: the
+      smallest one and the one sharing most variables with it. The pair
+      is moved to the end of the array. */
+static void nary_pick(BddNaryItem *item, int num, int words)
+{
+   BddNaryItem tmp;
+   int a = 0, b = -1;
+   int best = -1;
+   int n;
+
+   for (n=1 ; n<num ; n++)
+      if (item[n].size < item[a].size)
+	 a = n;
+   tmp = item[a];
+   item[a] = item[num-1];
+   item[num-1] = tmp;
+
+   for (n=0 ; n<num-1 ; n++)
+   {
+      int ov = nary_overlap(item[n].sup, item[num-1].sup, words);
+      if (ov > best  ||  (ov == best  &&  item[n].size < item[b].size))
+      {
+	 best = ov;
+	 b = n;
+      }
+   }
+   tmp = item[b];
+   item[b] = item[num-2];
+   item[num-2] = tmp;
 }
 
 
-static BDD constrain_rec(BDD f, BDD c)
+   /* Merges the operands two at a time with bdd_apply in the order given
+      by naryschedule, stopping as soon as the result is decided */
+static BDD nary_pairwise(BDD *r, int num, int op)
 {
-   BddCacheData *entry;
-   BDD res;
+   BddNaryItem *item;
+   unsigned int *supbits = NULL;
+   int words = (bddvarnum+31) / 32;
+   int itemnum = 0;
+   BDD res = NARYUNIT(op);
+   int n;
 
-   if (ISONE(c))
-      return f;
-   if (ISCONST(f))
-      return f;
-   if (c == f)
-      return BDDONE;
-   if (ISZERO(c))
-      return BDDZERO;
+   if (num == 0)
+      return res;
+   
+   if ((item=NEW(BddNaryItem,num)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return bddfalse;
+   }
+   if (naryschedule == BDD_NARY_SUPPORT  &&
+       (supbits=NEW(unsigned int,num*words+1)) == NULL)
+   {
+      free(item);
+      bdd_error(BDD_MEMORY);
+      return bddfalse;
+   }
 
-   entry = BddCache_lookup(&misccache, CONSTRAINHASH(f,c));
-   if (entry->a == f  &&  entry->b == c  &&  entry->c == miscid)
+   for (n=0 ; n<num ; n++)
    {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
-#endif
-      return entry->r.res;
+      if (r[n] == NARYUNIT(op))
+	 continue;
+      if (r[n] == NARYABSORB(op))
+      {
+	 res = r[n];
+	 goto done;
+      }
+      
+      item[itemnum].r = bdd_addref(r[n]);
+      item[itemnum].size = bdd_nodecount(r[n]);
+      item[itemnum].sup = NULL;
+      if (supbits != NULL)
+      {
+	 item[itemnum].sup = supbits + itemnum*words;
+	 nary_support(r[n], item[itemnum].sup, words);
+      }
+      if (supbits == NULL)
+	 nary_siftup(item, itemnum);
+      itemnum++;
    }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
-#endif
 
-   if (LEVEL(f) == LEVEL(c))
+   while (itemnum > 1)
    {
-      if (ISZERO(LOW(c)))
-	 res = constrain_rec(HIGH(f), HIGH(c));
-      else if (ISZERO(HIGH(c)))
-	 res = constrain_rec(LOW(f), LOW(c));
+      BddNaryItem a, b;
+
+      if (supbits != NULL)
+      {
+	 nary_pick(item, itemnum, words);
+	 a = item[itemnum-1];
+	 b = item[itemnum-2];
+	 itemnum -= 2;
+      }
       else
       {
-	 PUSHREF( constrain_rec(LOW(f), LOW(c)) );
-	 PUSHREF( constrain_rec(HIGH(f), HIGH(c)) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-	 POPREF(2);
+	 a = nary_pop(item, itemnum--);
+	 b = nary_pop(item, itemnum--);
+      }
+
+      res = bdd_addref(bdd_apply(a.r, b.r, op));
+      bdd_delref(a.r);
+      bdd_delref(b.r);
+      a.r = res;
+      if (bdderrorcond  ||  a.r == NARYABSORB(op))
+      {
+	 res = a.r;
+	 bdd_delref(a.r);
+	 goto done;
       }
+      
+      a.size = bdd_nodecount(a.r);
+      if (supbits != NULL)
+	 nary_support(a.r, a.sup, words);
+      item[itemnum] = a;
+      if (supbits == NULL)
+	 nary_siftup(item, itemnum);
+      itemnum++;
    }
-   else
-   if (LEVEL(f) < LEVEL(c))
+
+   if (itemnum == 1)
    {
-      PUSHREF( constrain_rec(LOW(f), c) );
-      PUSHREF( constrain_rec(HIGH(f), c) );
-      res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      POPREF(2);
+      res = item[0].r;
+      bdd_delref(res);
    }
-   else
+   itemnum = 0;
+
+ done:
+   for (n=0 ; n<itemnum ; n++)
+      bdd_delref(item[n].r);
+   free(supbits);
+   free(item);
+   return res;
+}
+
+
+   /* Makes room for size operands in narystack. Returns -1 and sets the
+      error condition if out of memory. */
+static int nary_fit(int size)
+{
+   BDD *newstack;
+   int newsize;
+   
+   if (size <= narystacksize)
+      return 0;
+
+   newsize = MAX(size, narystacksize*2);
+   if ((newstack=(BDD*)realloc(narystack, sizeof(BDD)*newsize)) == NULL)
    {
-      if (ISZERO(LOW(c)))
-	 res = constrain_rec(f, HIGH(c));
-      else if (ISZERO(HIGH(c)))
-	 res = constrain_rec(f, LOW(c));
-      else
+      bdd_error(BDD_MEMORY);
+      bdderrorcond = abs(BDD_MEMORY);
+      return -1;
+   }
+   narystack = newstack;
+   narystacksize = newsize;
+   return 0;
+}
+
+
+   /* Gives the n-ary cache the size of the apply cache */
+static int nary_cachefit(void)
+{
+   if (narycache != NULL  &&  narycachesize == applycache.tablesize)
+      return 0;
+
+   nary_free();
+   if ((narycache=(BddNaryEntry*)calloc(applycache.tablesize,
+					 sizeof(BddNaryEntry))) == NULL)
+      return bdd_error(BDD_MEMORY);
+   narycachesize = applycache.tablesize;
+   return 0;
+}
+
+
+static void nary_reset(void)
+{
+   int n;
+   
+   for (n=0 ; n<narycachesize ; n++)
+      narycache[n].num = 0;
+}
+
+
+static void nary_free(void)
+{
+   int n;
+   
+   for (n=0 ; n<narycachesize ; n++)
+      free(narycache[n].key);
+   free(narycache);
+   narycache = NULL;
+   narycachesize = 0;
+}
+
+
+static int nary_cmp(const void *a, const void *b)
+{
+   BDD x = *(const BDD*)a;
+   BDD y = *(const BDD*)b;
+   return x < y ? -1 : x > y;
+}
+
+
+   /* Drops the unit operands of op from the num operands at
+      narystack[base], sorts the rest and removes duplicates. Returns the
+      new number of operands or -1 if the result is the absorbing
+      constant. With complement edges the negations of xor operands are
+      moved into *mask. */
+static int nary_normalize(int base, int num, int op, BDD *mask)
+{
+   BDD *s = narystack + base;
+   int n, m;
+
+#ifndef COMPLEMENT_EDGES
+   (void)mask;
+#endif
+   
+   for (n=m=0 ; n<num ; n++)
+   {
+      BDD x = s[n];
+#ifdef COMPLEMENT_EDGES
+      if (op == bddop_xor)
       {
-	 PUSHREF( constrain_rec(f, LOW(c)) );
-	 PUSHREF( constrain_rec(f, HIGH(c)) );
-	 res = bdd_makenode(LEVEL(c), READREF(2), READREF(1));
-	 POPREF(2);
+	 *mask ^= ISCOMPL(x);
+	 x = REGULAR(x);
       }
+#endif
+      if (x == NARYABSORB(op))
+	 return -1;
+      if (x != NARYUNIT(op))
+	 s[m++] = x;
    }
 
-   entry->a = f;
-   entry->b = c;
-   entry->c = miscid;
-   entry->r.res = res;
+   if (m > 1)
+      qsort(s, m, sizeof(BDD), nary_cmp);
 
-   return res;
+   for (n=num=0 ; n<m ; n++)
+   {
+      if (n+1 < m  &&  s[n] == s[n+1])
+      {
+	 if (op == bddop_xor)  /* x^x = 0 */
+	    n++;
+	 continue;
+      }
+#ifdef COMPLEMENT_EDGES
+      if (n+1 < m  &&  s[n+1] == NOT(s[n]))  /* x&!x = 0, x|!x = 1 */
+	 return -1;
+#endif
+      s[num++] = s[n];
+   }
+   
+   return num;
 }
 
 
-/*=== REPLACE ==========================================================*/
+   /* Hash value of the operands s with the operator and variable set */
+static unsigned int nary_hash(BDD *s, int num, int op, BDD var)
+{
+   bddhashval hash = PAIR(op, var);
+   int n;
 
-BDD bdd_replace(BDD r, bddPair *pair)
+   for (n=0 ; n<num ; n++)
+      hash = PAIR(hash, s[n]);
+   return (unsigned int)(hash % narycachesize);
+}
+
+
+   /* Returns the cached result for the num operands at narystack[base]
+      or -1 if there is none */
+static BDD nary_lookup(unsigned int hash, int base, int num, int op, BDD var)
 {
-   BDD res;
-   firstReorder = 1;
+   BddNaryEntry *entry = &narycache[hash];
    
-   CHECKa(r, bddfalse);
+   if (entry->num == num  &&  entry->op == op  &&  entry->var == var  &&
+       memcmp(entry->key, narystack+base, sizeof(BDD)*num) == 0)
+      return entry->res;
+   return -1;
+}
+
+
+   /* Stores res as the result for the num operands at narystack[base].
+      The entry is looked up again since it may have been cleared by a
+      garbage collection while res was calculated. */
+static void nary_store(unsigned int hash, int base, int num, int op, BDD var,
+		       BDD res)
+{
+   BddNaryEntry *entry = &narycache[hash];
+   
+   if (entry->keysize < num)
+   {
+      BDD *key = (BDD*)realloc(entry->key, sizeof(BDD)*num);
+      if (key == NULL)
+	 return;
+      entry->key = key;
+      entry->keysize = num;
+   }
+   memcpy(entry->key, narystack+base, sizeof(BDD)*num);
+   entry->num = num;
+   entry->op = op;
+   entry->var = var;
+   entry->res = res;
+}
+
+
+   /* Applies applyop to the normalized list of num operands at
+      narystack[base]. The cofactor lists are built above it. */
+static BDD nary_rec(int base, int num)
+{
+   BDD mask, res;
+   unsigned int hash;
+   int level, m, n;
+
+   if (num == 0)
+      return NARYUNIT(applyop);
+   if (num == 1)
+      return narystack[base];
+   if (num == 2)
+      return apply_rec(narystack[base], narystack[base+1]);
+
+   hash = nary_hash(narystack+base, num, applyop, 0);
+   if ((res=nary_lookup(hash, base, num, applyop, 0)) >= 0)
+      return res;
+
+   if (nary_fit(base+2*num) < 0)
+      return BDDZERO;
    
+   level = LEVEL(narystack[base]);
+   for (n=1 ; n<num ; n++)
+      level = MIN(level, LEVEL(narystack[base+n]));
+
+   mask = 0;
+   for (n=0 ; n<num ; n++)
+      narystack[base+num+n] = LOWCOF(narystack[base+n], level);
+   m = nary_normalize(base+num, num, applyop, &mask);
+   PUSHREF( m < 0 ? NARYABSORB(applyop) : nary_rec(base+num, m) ^ mask );
+
+   mask = 0;
+   for (n=0 ; n<num ; n++)
+      narystack[base+num+n] = HIGHCOF(narystack[base+n], level);
+   m = nary_normalize(base+num, num, applyop, &mask);
+   PUSHREF( m < 0 ? NARYABSORB(applyop) : nary_rec(base+num, m) ^ mask );
+
+   res = bdd_makenode(level, READREF(2), READREF(1));
+   POPREF(2);
+
+   nary_store(hash, base, num, applyop, 0, res);
+   return res;
+}
+
+
+   /* Applies op to all the operands in one recursion over their levels */
+static BDD nary_recursive(BDD *r, int num, int op)
+{
+   BDD res, mask;
+   int m;
+   firstReorder = 1;
+
  again:
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      replacepair = pair->result;
-      replacelast = pair->last;
-      replaceid = (pair->id << 2) | CACHEID_REPLACE;
+      applyop = op;
+
+      if (nary_fit(num) < 0  ||  nary_cachefit() < 0)
+	 return bddfalse;
+      if (num > 0)
+	 memcpy(narystack, r, sizeof(BDD)*num);
       
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = replace_rec(r);
+      mask = 0;
+      m = nary_normalize(0, num, op, &mask);
+      res = m < 0 ? NARYABSORB(op) : nary_rec(0, m) ^ mask;
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -965,103 +1999,270 @@ BDD bdd_replace(BDD r, bddPair *pair)
 }
 
 
-static BDD replace_rec(BDD r)
+/*=== ITE ==============================================================*/
+
+BDD bdd_ite(BDD f, BDD g, BDD h)
 {
-   BddCacheData *entry;
    BDD res;
+   clock_t opstart;
+   firstReorder = 1;
    
-   if (ISCONST(r)  ||  LEVEL(r) > replacelast)
-      return r;
-
-   entry = BddCache_lookup(&replacecache, REPLACEHASH(r));
-   if (entry->a == r  &&  entry->c == replaceid)
+   CHECKa(f, bddfalse);
+   CHECKa(g, bddfalse);
+   CHECKa(h, bddfalse);
+   opstart = OPBEGIN(OPSTAT_ITE);
+
+ again:
+   if (setjmp(bddexception) == 0)
    {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
+      INITREF;
+
+#ifdef BDD_THREADS
+      if (bddthreadnum > 1  &&
+	  (res=bdd_par_run(par_ite_task, f, g, h)) >= 0)
+      {
+	 checkresize();
+	 return OPEND(OPSTAT_ITE, opstart, res);
+      }
 #endif
-      return entry->r.res;
+      
+      if (!firstReorder)
+	 bdd_disable_reorder();
+      res = RUNOP(ite, (f,g,h));
+      if (!firstReorder)
+	 bdd_enable_reorder();
    }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
-#endif
+   else
+   {
+      bdd_checkreorder();
 
-   PUSHREF( replace_rec(LOW(r)) );
-   PUSHREF( replace_rec(HIGH(r)) );
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;  /* avoid warning about res being uninitialized */
+   }
 
-   res = bdd_correctify(LEVEL(replacepair[LEVEL(r)]), READREF(2), READREF(1));
-   POPREF(2);
+   checkresize();
+   return OPEND(OPSTAT_ITE, opstart, res);
+}
 
-   entry->a = r;
-   entry->c = replaceid;
-   entry->r.res = res;
 
-   return res;
+   /* Uses of f in g and h become constants. With complement edges f is
+      made regular first: ite(!f,g,h) = ite(f,h,g). The caller makes g
+      regular afterwards with ite(f,!g,!h) = !ite(f,g,h). */
+static void ite_normalize(BDD *f, BDD *g, BDD *h)
+{
+#ifdef COMPLEMENT_EDGES
+   if (ISCOMPL(*f))
+   {
+      BDD tmp = *g;
+      *g = *h;
+      *h = tmp;
+      *f = NOT(*f);
+   }
+#endif
+   if (*g == *f)
+      *g = BDDONE;
+#ifdef COMPLEMENT_EDGES
+   else if (*g == NOT(*f))
+      *g = BDDZERO;
+#endif
+   if (*h == *f)
+      *h = BDDZERO;
+#ifdef COMPLEMENT_EDGES
+   else if (*h == NOT(*f))
+      *h = BDDONE;
+#endif
 }
 
 
-static BDD bdd_correctify(int level, BDD l, BDD r)
+   /* Standard triples: an ITE with a constant argument (or with h = !g)
+      is a binary operator. It is computed by apply instead, so that
+      equivalent calls like ite(f,1,h), ite(h,1,f) and f|h share one entry
+      in the apply cache. Returns the operator with its operands in l and
+      r, or -1 for a proper ITE. */
+static int ite_standard(BDD f, BDD g, BDD h, BDD *l, BDD *r)
 {
-   BDD res;
-   
-   if (level < LEVEL(l)  &&  level < LEVEL(r))
-      return bdd_makenode(level, l, r);
+   if (ISONE(g))
+   {
+      *l = f;
+      *r = h;
+      return bddop_or;
+   }
+   if (ISZERO(h))
+   {
+      *l = f;
+      *r = g;
+      return bddop_and;
+   }
+#ifdef COMPLEMENT_EDGES
+   if (h == NOT(g))
+   {
+      *l = f;
+      *r = g;
+      return bddop_biimp;
+   }
+#endif
+   if (ISZERO(g))
+   {
+      *l = h;
+      *r = f;
+      return bddop_diff;
+   }
+   if (ISONE(h))
+   {
+      *l = f;
+      *r = g;
+      return bddop_imp;
+   }
+   return -1;
+}
 
-   if (level == LEVEL(l)  ||  level == LEVEL(r))
+
+static BDD ite_rec(BDD f, BDD g, BDD h)
+{
+   BddCacheData *entry;
+   BDD res, l, r;
+   int op;
+
+   if (ISONE(f))
+      return g;
+   if (ISZERO(f))
+      return h;
+   ite_normalize(&f, &g, &h);
+   if (g == h)
+      return g;
+   if (ISONE(g) && ISZERO(h))
+      return f;
+   if (ISZERO(g) && ISONE(h))
+      return not_rec(f);
+   if ((op=ite_standard(f, g, h, &l, &r)) >= 0)
    {
-      bdd_error(BDD_REPLACE);
-      return 0;
+      int oldop = applyop;
+      applyop = op;
+      res = apply_rec(l, r);
+      applyop = oldop;
+      return res;
    }
+#ifdef COMPLEMENT_EDGES
+   if (ISCOMPL(g))
+      return NOT(ite_rec(f, NOT(g), NOT(h)));
+#endif
 
-   if (LEVEL(l) == LEVEL(r))
+   entry = BddCache_lookup3(&itecache, ITEHASH(f,g,h), f, g, h);
+   if (entry->a == f  &&  entry->b == g  &&  entry->c == h)
    {
-      PUSHREF( bdd_correctify(level, LOW(l), LOW(r)) );
-      PUSHREF( bdd_correctify(level, HIGH(l), HIGH(r)) );
-      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+      CACHEHIT(itecache);
+      return entry->r.res;
    }
-   else
-   if (LEVEL(l) < LEVEL(r))
+   CACHEMISS(itecache, entry);
+      
+   if (LEVEL(f) == LEVEL(g))
    {
-      PUSHREF( bdd_correctify(level, LOW(l), r) );
-      PUSHREF( bdd_correctify(level, HIGH(l), r) );
-      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+      if (LEVEL(f) == LEVEL(h))
+      {
+	 PUSHREF( ite_rec(LOW(f), LOW(g), LOW(h)) );
+	 PUSHREF( ite_rec(HIGH(f), HIGH(g), HIGH(h)) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
+      else
+      if (LEVEL(f) < LEVEL(h))
+      {
+	 PUSHREF( ite_rec(LOW(f), LOW(g), h) );
+	 PUSHREF( ite_rec(HIGH(f), HIGH(g), h) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
+      else /* f > h */
+      {
+	 PUSHREF( ite_rec(f, g, LOW(h)) );
+	 PUSHREF( ite_rec(f, g, HIGH(h)) );
+	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
+      }
    }
    else
+   if (LEVEL(f) < LEVEL(g))
    {
-      PUSHREF( bdd_correctify(level, l, LOW(r)) );
-      PUSHREF( bdd_correctify(level, l, HIGH(r)) );
-      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+      if (LEVEL(f) == LEVEL(h))
+      {
+	 PUSHREF( ite_rec(LOW(f), g, LOW(h)) );
+	 PUSHREF( ite_rec(HIGH(f), g, HIGH(h)) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
+      else
+      if (LEVEL(f) < LEVEL(h))
+      {
+	 PUSHREF( ite_rec(LOW(f), g, h) );
+	 PUSHREF( ite_rec(HIGH(f), g, h) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
+      else /* f > h */
+      {
+	 PUSHREF( ite_rec(f, g, LOW(h)) );
+	 PUSHREF( ite_rec(f, g, HIGH(h)) );
+	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
+      }
+   }
+   else /* f > g */
+   {
+      if (LEVEL(g) == LEVEL(h))
+      {
+	 PUSHREF( ite_rec(f, LOW(g), LOW(h)) );
+	 PUSHREF( ite_rec(f, HIGH(g), HIGH(h)) );
+	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
+      }
+      else
+      if (LEVEL(g) < LEVEL(h))
+      {
+	 PUSHREF( ite_rec(f, LOW(g), h) );
+	 PUSHREF( ite_rec(f, HIGH(g), h) );
+	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
+      }
+      else /* g > h */
+      {
+	 PUSHREF( ite_rec(f, g, LOW(h)) );
+	 PUSHREF( ite_rec(f, g, HIGH(h)) );
+	 res = bdd_makenode(LEVEL(h), READREF(2), READREF(1));
+      }
    }
+
    POPREF(2);
-   
-   return res; /* FIXME: cache ? */
+
+   entry->a = f;
+   entry->b = g;
+   entry->c = h;
+   entry->r.res = res;
+
+   return res;
 }
 
 
-/*=== COMPOSE ==========================================================*/
+/*=== RESTRICT =========================================================*/
 
-BDD bdd_compose(BDD f, BDD g, int var)
+BDD bdd_restrict(BDD r, BDD var)
 {
    BDD res;
+   clock_t opstart;
    firstReorder = 1;
    
-   CHECKa(f, bddfalse);
-   CHECKa(g, bddfalse);
-   if (var < 0 || var >= bddvarnum)
-   {
-      bdd_error(BDD_VAR);
-      return bddfalse;
-   }
+   CHECKa(r,bddfalse);
+   CHECKa(var,bddfalse);
    
+   if (var < 2)  /* Empty set */
+      return r;
+
+   opstart = OPBEGIN(OPSTAT_RESTRICT);
+
  again:
    if (setjmp(bddexception) == 0)
    {
+      if (varset2svartable(var) < 0)
+	 return OPEND(OPSTAT_RESTRICT, opstart, bddfalse);
+
       INITREF;
-      composelevel = bddvar2level[var];
-      replaceid = (composelevel << 2) | CACHEID_COMPOSE;
+      miscid = (var << 3) | CACHEID_RESTRICT;
       
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = compose_rec(f, g);
+      res = restrict_rec(r);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1075,86 +2276,70 @@ BDD bdd_compose(BDD f, BDD g, int var)
    }
 
    checkresize();
-   return res;
+   return OPEND(OPSTAT_RESTRICT, opstart, res);
 }
 
 
-static BDD compose_rec(BDD f, BDD g)
+static BDD restrict_rec(BDD r)
 {
    BddCacheData *entry;
    BDD res;
+   
+   if (ISCONST(r)  ||  LEVEL(r) > quantlast)
+      return r;
 
-   if (LEVEL(f) > composelevel)
-      return f;
-
-   entry = BddCache_lookup(&replacecache, COMPOSEHASH(f,g));
-   if (entry->a == f  &&  entry->b == g  &&  entry->c == replaceid)
+   entry = BddCache_lookup2(&misccache, RESTRHASH(r,miscid), r, miscid);
+   if (entry->a == r  &&  entry->c == miscid)
    {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
-#endif
+      CACHEHIT(misccache);
       return entry->r.res;
    }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
-#endif
-
-   if (LEVEL(f) < composelevel)
+   CACHEMISS(misccache, entry);
+   
+   if (INSVARSET(LEVEL(r)))
    {
-      if (LEVEL(f) == LEVEL(g))
-      {
-	 PUSHREF( compose_rec(LOW(f), LOW(g)) );
-	 PUSHREF( compose_rec(HIGH(f), HIGH(g)) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
-      else
-      if (LEVEL(f) < LEVEL(g))
-      {
-	 PUSHREF( compose_rec(LOW(f), g) );
-	 PUSHREF( compose_rec(HIGH(f), g) );
-	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
-      }
+      if (quantvarset[LEVEL(r)] > 0)
+	 res = restrict_rec(HIGH(r));
       else
-      {
-	 PUSHREF( compose_rec(f, LOW(g)) );
-	 PUSHREF( compose_rec(f, HIGH(g)) );
-	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
-      }
-      POPREF(2);
+	 res = restrict_rec(LOW(r));
    }
    else
-      /*if (LEVEL(f) == composelevel) changed 2-nov-98 */
    {
-      res = ite_rec(g, HIGH(f), LOW(f));
+      PUSHREF( restrict_rec(LOW(r)) );
+      PUSHREF( restrict_rec(HIGH(r)) );
+      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+      POPREF(2);
    }
 
-   entry->a = f;
-   entry->b = g;
-   entry->c = replaceid;
+   entry->a = r;
+   entry->c = miscid;
    entry->r.res = res;
 
    return res;
 }
 
 
-BDD bdd_veccompose(BDD f, bddPair *pair)
+/*=== GENERALIZED COFACTOR =============================================*/
+
+BDD bdd_constrain(BDD f, BDD c)
 {
    BDD res;
+   clock_t opstart;
    firstReorder = 1;
    
-   CHECKa(f, bddfalse);
-   
+   CHECKa(f,bddfalse);
+   CHECKa(c,bddfalse);
+   opstart = OPBEGIN(OPSTAT_CONSTRAIN);
+
  again:
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      replacepair = pair->result;
-      replaceid = (pair->id << 2) | CACHEID_VECCOMPOSE;
-      replacelast = pair->last;
+      miscid = CACHEID_CONSTRAIN;
       
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = veccompose_rec(f);
+      res = constrain_rec(f, c);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1168,169 +2353,100 @@ BDD bdd_veccompose(BDD f, bddPair *pair)
    }
 
    checkresize();
-   return res;
-}
-
-
-static BDD veccompose_rec(BDD f)
-{
-   BddCacheData *entry;
-   register BDD res;
-   
-   if (LEVEL(f) > replacelast)
-      return f;
-   
-   entry = BddCache_lookup(&replacecache, VECCOMPOSEHASH(f));
-   if (entry->a == f  &&  entry->c == replaceid)
-   {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
-#endif
-      return entry->r.res;
-   }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
-#endif
-
-   PUSHREF( veccompose_rec(LOW(f)) );
-   PUSHREF( veccompose_rec(HIGH(f)) );
-   res = ite_rec(replacepair[LEVEL(f)], READREF(1), READREF(2));
-   POPREF(2);
-
-   entry->a = f;
-   entry->c = replaceid;
-   entry->r.res = res;
-
-   return res;
-}
-
-
-/*=== SIMPLIFY =========================================================*/
-
-BDD bdd_simplify(BDD f, BDD d)
-{
-   BDD res;
-   firstReorder = 1;
-   
-   CHECKa(f, bddfalse);
-   CHECKa(d, bddfalse);
-   
- again:
-   if (setjmp(bddexception) == 0)
-   {
-      INITREF;
-      applyop = bddop_or;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = simplify_rec(f, d);
-      if (!firstReorder)
-	 bdd_enable_reorder();
-   }
-   else
-   {
-      bdd_checkreorder();
-
-      if (firstReorder-- == 1)
-	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
-   }
-
-   checkresize();
-   return res;
+   return OPEND(OPSTAT_CONSTRAIN, opstart, res);
 }
 
 
-static BDD simplify_rec(BDD f, BDD d)
+static BDD constrain_rec(BDD f, BDD c)
 {
    BddCacheData *entry;
    BDD res;
 
-   if (ISONE(d)  ||  ISCONST(f))
+   if (ISONE(c))
       return f;
-   if (d == f)
+   if (ISCONST(f))
+      return f;
+   if (c == f)
       return BDDONE;
-   if (ISZERO(d))
+   if (ISZERO(c))
       return BDDZERO;
 
-   entry = BddCache_lookup(&applycache, APPLYHASH(f,d,bddop_simplify));
-   
-   if (entry->a == f  &&  entry->b == d  &&  entry->c == bddop_simplify)
+   entry = BddCache_lookup3(&misccache, CONSTRAINHASH(f,c), f, c, miscid);
+   if (entry->a == f  &&  entry->b == c  &&  entry->c == miscid)
    {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
-#endif
+      CACHEHIT(misccache);
       return entry->r.res;
    }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
-#endif
-   
-   if (LEVEL(f) == LEVEL(d))
+   CACHEMISS(misccache, entry);
+
+   if (LEVEL(f) == LEVEL(c))
    {
-      if (ISZERO(LOW(d)))
-	 res = simplify_rec(HIGH(f), HIGH(d));
-      else
-      if (ISZERO(HIGH(d)))
-	 res = simplify_rec(LOW(f), LOW(d));
+      if (ISZERO(LOW(c)))
+	 res = constrain_rec(HIGH(f), HIGH(c));
+      else if (ISZERO(HIGH(c)))
+	 res = constrain_rec(LOW(f), LOW(c));
       else
       {
-	 PUSHREF( simplify_rec(LOW(f),	LOW(d)) );
-	 PUSHREF( simplify_rec(HIGH(f), HIGH(d)) );
+	 PUSHREF( constrain_rec(LOW(f), LOW(c)) );
+	 PUSHREF( constrain_rec(HIGH(f), HIGH(c)) );
 	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
 	 POPREF(2);
       }
    }
    else
-   if (LEVEL(f) < LEVEL(d))
+   if (LEVEL(f) < LEVEL(c))
    {
-      PUSHREF( simplify_rec(LOW(f), d) );
-      PUSHREF( simplify_rec(HIGH(f), d) );
+      PUSHREF( constrain_rec(LOW(f), c) );
+      PUSHREF( constrain_rec(HIGH(f), c) );
       res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
       POPREF(2);
    }
-   else /* LEVEL(d) < LEVEL(f) */
+   else
    {
-      PUSHREF( apply_rec(LOW(d), HIGH(d)) ); /* Exist quant */
-      res = simplify_rec(f, READREF(1));
-      POPREF(1);
+      if (ISZERO(LOW(c)))
+	 res = constrain_rec(f, HIGH(c));
+      else if (ISZERO(HIGH(c)))
+	 res = constrain_rec(f, LOW(c));
+      else
+      {
+	 PUSHREF( constrain_rec(f, LOW(c)) );
+	 PUSHREF( constrain_rec(f, HIGH(c)) );
+	 res = bdd_makenode(LEVEL(c), READREF(2), READREF(1));
+	 POPREF(2);
+      }
    }
 
    entry->a = f;
-   entry->b = d;
-   entry->c = bddop_simplify;
+   entry->b = c;
+   entry->c = miscid;
    entry->r.res = res;
 
    return res;
 }
 
 
-/*=== QUANTIFICATION ===================================================*/
+/*=== REPLACE ==========================================================*/
 
-BDD bdd_exist(BDD r, BDD var)
+BDD bdd_replace(BDD r, bddPair *pair)
 {
    BDD res;
+   clock_t opstart;
    firstReorder = 1;
    
    CHECKa(r, bddfalse);
-   CHECKa(var, bddfalse);
-   
-   if (var < 2)  /* Empty set */
-      return r;
+   opstart = OPBEGIN(OPSTAT_REPLACE);
 
  again:
    if (setjmp(bddexception) == 0)
    {
-      if (varset2vartable(var) < 0)
-	 return bddfalse;
-
       INITREF;
-      quantid = (var << 3) | CACHEID_EXIST; /* FIXME: range */
-      applyop = bddop_or;
-
+      replacepair = pair->result;
+      replacelast = pair->last;
+      replaceid = (pair->id << 2) | CACHEID_REPLACE;
+      
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = quant_rec(r);
+      res = replace_rec(r);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1344,75 +2460,105 @@ BDD bdd_exist(BDD r, BDD var)
    }
 
    checkresize();
-   return res;
+   return OPEND(OPSTAT_REPLACE, opstart, res);
 }
 
 
-BDD bdd_forall(BDD r, BDD var)
+static BDD replace_rec(BDD r)
 {
+   BddCacheData *entry;
    BDD res;
-   firstReorder = 1;
-   
-   CHECKa(r, bddfalse);
-   CHECKa(var, bddfalse);
    
-   if (var < 2)  /* Empty set */
+   if (ISCONST(r)  ||  LEVEL(r) > replacelast)
       return r;
 
- again:
-   if (setjmp(bddexception) == 0)
+   entry = BddCache_lookup2(&replacecache, REPLACEHASH(r), r, replaceid);
+   if (entry->a == r  &&  entry->c == replaceid)
    {
-      if (varset2vartable(var) < 0)
-	 return bddfalse;
+      CACHEHIT(replacecache);
+      return entry->r.res;
+   }
+   CACHEMISS(replacecache, entry);
 
-      INITREF;
-      quantid = (var << 3) | CACHEID_FORALL;
-      applyop = bddop_and;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = quant_rec(r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+   PUSHREF( replace_rec(LOW(r)) );
+   PUSHREF( replace_rec(HIGH(r)) );
+
+   res = bdd_correctify(LEVEL(replacepair[LEVEL(r)]), READREF(2), READREF(1));
+   POPREF(2);
+
+   entry->a = r;
+   entry->c = replaceid;
+   entry->r.res = res;
+
+   return res;
+}
+
+
+static BDD bdd_correctify(int level, BDD l, BDD r)
+{
+   BDD res;
+   
+   if (level < LEVEL(l)  &&  level < LEVEL(r))
+      return bdd_makenode(level, l, r);
+
+   if (level == LEVEL(l)  ||  level == LEVEL(r))
+   {
+      bdd_error(BDD_REPLACE);
+      return 0;
+   }
+
+   if (LEVEL(l) == LEVEL(r))
+   {
+      PUSHREF( bdd_correctify(level, LOW(l), LOW(r)) );
+      PUSHREF( bdd_correctify(level, HIGH(l), HIGH(r)) );
+      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
    }
    else
+   if (LEVEL(l) < LEVEL(r))
    {
-      bdd_checkreorder();
-
-      if (firstReorder-- == 1)
-	 goto again;
-      res = BDDZERO;  /* avoid warning about res being uninitialized */
+      PUSHREF( bdd_correctify(level, LOW(l), r) );
+      PUSHREF( bdd_correctify(level, HIGH(l), r) );
+      res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
    }
-
-   checkresize();
-   return res;
+   else
+   {
+      PUSHREF( bdd_correctify(level, l, LOW(r)) );
+      PUSHREF( bdd_correctify(level, l, HIGH(r)) );
+      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+   }
+   POPREF(2);
+   
+   return res; /* FIXME: cache ? */
 }
 
 
-BDD bdd_unique(BDD r, BDD var)
+/*=== COMPOSE ==========================================================*/
+
+BDD bdd_compose(BDD f, BDD g, int var)
 {
    BDD res;
+   clock_t opstart;
    firstReorder = 1;
    
-   CHECKa(r, bddfalse);
-   CHECKa(var, bddfalse);
-   
-   if (var < 2)  /* Empty set */
-      return r;
+   CHECKa(f, bddfalse);
+   CHECKa(g, bddfalse);
+   if (var < 0 || var >= bddvarnum)
+   {
+      bdd_error(BDD_VAR);
+      return bddfalse;
+   }
+   opstart = OPBEGIN(OPSTAT_COMPOSE);
 
  again:
    if (setjmp(bddexception) == 0)
    {
-      if (varset2vartable(var) < 0)
-	 return bddfalse;
-
       INITREF;
-      quantid = (var << 3) | CACHEID_UNIQUE;
-      applyop = bddop_xor;
+      composelevel = bddvar2level[var];
+      replaceid = (composelevel << 2) | CACHEID_COMPOSE;
       
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = quant_rec(r);
+      res = compose_rec(f, g);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1426,83 +2572,151 @@ BDD bdd_unique(BDD r, BDD var)
    }
 
    checkresize();
-   return res;
+   return OPEND(OPSTAT_COMPOSE, opstart, res);
 }
 
 
-static int quant_rec(int r)
+static BDD compose_rec(BDD f, BDD g)
 {
    BddCacheData *entry;
-   int res;
-   
-   if (r < 2  ||  LEVEL(r) > quantlast)
-      return r;
+   BDD res;
 
-   entry = BddCache_lookup(&quantcache, QUANTHASH(r));
-   if (entry->a == r  &&  entry->c == quantid)
+   if (LEVEL(f) > composelevel)
+      return f;
+
+   entry = BddCache_lookup3(&replacecache, COMPOSEHASH(f,g), f, g, replaceid);
+   if (entry->a == f  &&  entry->b == g  &&  entry->c == replaceid)
    {
-#ifdef CACHESTATS
-      bddcachestats.opHit++;
-#endif
+      CACHEHIT(replacecache);
       return entry->r.res;
    }
-#ifdef CACHESTATS
-   bddcachestats.opMiss++;
-#endif
+   CACHEMISS(replacecache, entry);
 
-   PUSHREF( quant_rec(LOW(r)) );
-   PUSHREF( quant_rec(HIGH(r)) );
-   
-   if (INVARSET(LEVEL(r)))
-      res = apply_rec(READREF(2), READREF(1));
+   if (LEVEL(f) < composelevel)
+   {
+      if (LEVEL(f) == LEVEL(g))
+      {
+	 PUSHREF( compose_rec(LOW(f), LOW(g)) );
+	 PUSHREF( compose_rec(HIGH(f), HIGH(g)) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
+      else
+      if (LEVEL(f) < LEVEL(g))
+      {
+	 PUSHREF( compose_rec(LOW(f), g) );
+	 PUSHREF( compose_rec(HIGH(f), g) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      }
+      else
+      {
+	 PUSHREF( compose_rec(f, LOW(g)) );
+	 PUSHREF( compose_rec(f, HIGH(g)) );
+	 res = bdd_makenode(LEVEL(g), READREF(2), READREF(1));
+      }
+      POPREF(2);
+   }
    else
-      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+      /*if (LEVEL(f) == composelevel) changed 2-nov-98 */
+   {
+      res = ite_rec(g, HIGH(f), LOW(f));
+   }
 
-   POPREF(2);
-   
-   entry->a = r;
-   entry->c = quantid;
+   entry->a = f;
+   entry->b = g;
+   entry->c = replaceid;
    entry->r.res = res;
 
    return res;
 }
 
 
-/*=== APPLY & QUANTIFY =================================================*/
-
-BDD bdd_appex(BDD l, BDD r, int opr, BDD var)
+BDD bdd_veccompose(BDD f, bddPair *pair)
 {
    BDD res;
+   clock_t opstart;
    firstReorder = 1;
    
-   CHECKa(l, bddfalse);
-   CHECKa(r, bddfalse);
-   CHECKa(var, bddfalse);
+   CHECKa(f, bddfalse);
+   opstart = OPBEGIN(OPSTAT_VECCOMPOSE);
+
+ again:
+   if (setjmp(bddexception) == 0)
+   {
+      INITREF;
+      replacepair = pair->result;
+      replaceid = (pair->id << 2) | CACHEID_VECCOMPOSE;
+      replacelast = pair->last;
+      
+      if (!firstReorder)
+	 bdd_disable_reorder();
+      res = veccompose_rec(f);
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;  /* avoid warning about res being uninitialized */
+   }
+
+   checkresize();
+   return OPEND(OPSTAT_VECCOMPOSE, opstart, res);
+}
+
+
+static BDD veccompose_rec(BDD f)
+{
+   BddCacheData *entry;
+   register BDD res;
    
-   if (opr<0 || opr>bddop_invimp)
+   if (LEVEL(f) > replacelast)
+      return f;
+   
+   entry = BddCache_lookup2(&replacecache, VECCOMPOSEHASH(f), f, replaceid);
+   if (entry->a == f  &&  entry->c == replaceid)
    {
-      bdd_error(BDD_OP);
-      return bddfalse;
+      CACHEHIT(replacecache);
+      return entry->r.res;
    }
+   CACHEMISS(replacecache, entry);
+
+   PUSHREF( veccompose_rec(LOW(f)) );
+   PUSHREF( veccompose_rec(HIGH(f)) );
+   res = ite_rec(replacepair[LEVEL(f)], READREF(1), READREF(2));
+   POPREF(2);
+
+   entry->a = f;
+   entry->c = replaceid;
+   entry->r.res = res;
+
+   return res;
+}
+
+
+/*=== SIMPLIFY =========================================================*/
+
+BDD bdd_simplify(BDD f, BDD d)
+{
+   BDD res;
+   clock_t opstart;
+   firstReorder = 1;
    
-   if (var < 2)  /* Empty set */
-      return bdd_apply(l,r,opr);
+   CHECKa(f, bddfalse);
+   CHECKa(d, bddfalse);
+   opstart = OPBEGIN(OPSTAT_SIMPLIFY);
 
  again:
    if (setjmp(bddexception) == 0)
    {
-      if (varset2vartable(var) < 0)
-	 return bddfalse;
-   
       INITREF;
       applyop = bddop_or;
-      appexop = opr;
-      appexid = (var << 5) | (appexop << 1); /* FIXME: range! */
-      quantid = (appexid << 3) | CACHEID_APPEX;
       
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = appquant_rec(l, r);
+      res = simplify_rec(f, d);
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1514,45 +2728,161 @@ BDD bdd_appex(BDD l, BDD r, int opr, BDD var)
 	 goto again;
       res = BDDZERO;  /* avoid warning about res being uninitialized */
    }
-   
+
    checkresize();
+   return OPEND(OPSTAT_SIMPLIFY, opstart, res);
+}
+
+
+static BDD simplify_rec(BDD f, BDD d)
+{
+   BddCacheData *entry;
+   BDD res;
+
+   if (ISONE(d)  ||  ISCONST(f))
+      return f;
+   if (d == f)
+      return BDDONE;
+   if (ISZERO(d))
+      return BDDZERO;
+
+   entry = BddCache_lookup3(&applycache, APPLYHASH(f,d,bddop_simplify), f, d, bddop_simplify);
+   
+   if (entry->a == f  &&  entry->b == d  &&  entry->c == bddop_simplify)
+   {
+      CACHEHIT(applycache);
+      return entry->r.res;
+   }
+   CACHEMISS(applycache, entry);
+   
+   if (LEVEL(f) == LEVEL(d))
+   {
+      if (ISZERO(LOW(d)))
+	 res = simplify_rec(HIGH(f), HIGH(d));
+      else
+      if (ISZERO(HIGH(d)))
+	 res = simplify_rec(LOW(f), LOW(d));
+      else
+      {
+	 PUSHREF( simplify_rec(LOW(f),	LOW(d)) );
+	 PUSHREF( simplify_rec(HIGH(f), HIGH(d)) );
+	 res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+	 POPREF(2);
+      }
+   }
+   else
+   if (LEVEL(f) < LEVEL(d))
+   {
+      PUSHREF( simplify_rec(LOW(f), d) );
+      PUSHREF( simplify_rec(HIGH(f), d) );
+      res = bdd_makenode(LEVEL(f), READREF(2), READREF(1));
+      POPREF(2);
+   }
+   else /* LEVEL(d) < LEVEL(f) */
+   {
+      PUSHREF( apply_rec(LOW(d), HIGH(d)) ); /* Exist quant */
+      res = simplify_rec(f, READREF(1));
+      POPREF(1);
+   }
+
+   entry->a = f;
+   entry->b = d;
+   entry->c = bddop_simplify;
+   entry->r.res = res;
+
    return res;
 }
 
 
-BDD bdd_appall(BDD l, BDD r, int opr, BDD var)
+/*=== QUANTIFICATION ===================================================*/
+
+BDD bdd_exist(BDD r, BDD var)
 {
    BDD res;
+   clock_t opstart;
    firstReorder = 1;
    
-   CHECKa(l, bddfalse);
    CHECKa(r, bddfalse);
    CHECKa(var, bddfalse);
    
-   if (opr<0 || opr>bddop_invimp)
+   if (var < 2)  /* Empty set */
+      return r;
+   opstart = OPBEGIN(OPSTAT_EXIST);
+
+ again:
+   if (setjmp(bddexception) == 0)
    {
-      bdd_error(BDD_OP);
-      return bddfalse;
+      if (varset2vartable(var) < 0)
+	 return OPEND(OPSTAT_EXIST, opstart, bddfalse);
+
+      INITREF;
+      quantid = (var << 3) | CACHEID_EXIST; /* FIXME: range */
+      applyop = bddop_or;
+
+#ifdef BDD_THREADS
+      if (bddthreadnum > 1  &&
+	  (res=bdd_par_run(par_quant_task, r, 0, 0)) >= 0)
+      {
+	 checkresize();
+	 return OPEND(OPSTAT_EXIST, opstart, res);
+      }
+#endif
+
+      if (!firstReorder)
+	 bdd_disable_reorder();
+      res = RUNOP(quant, (r));
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;  /* avoid warning about res being uninitialized */
    }
+
+   checkresize();
+   return OPEND(OPSTAT_EXIST, opstart, res);
+}
+
+
+BDD bdd_forall(BDD r, BDD var)
+{
+   BDD res;
+   clock_t opstart;
+   firstReorder = 1;
+   
+   CHECKa(r, bddfalse);
+   CHECKa(var, bddfalse);
    
    if (var < 2)  /* Empty set */
-      return bdd_apply(l,r,opr);
+      return r;
+   opstart = OPBEGIN(OPSTAT_FORALL);
 
  again:
    if (setjmp(bddexception) == 0)
    {
       if (varset2vartable(var) < 0)
-	 return bddfalse;
+	 return OPEND(OPSTAT_FORALL, opstart, bddfalse);
 
       INITREF;
+      quantid = (var << 3) | CACHEID_FORALL;
       applyop = bddop_and;
-      appexop = opr;
-      appexid = (var << 5) | (appexop << 1) | 1; /* FIXME: range! */
-      quantid = (appexid << 3) | CACHEID_APPAL;
+
+#ifdef BDD_THREADS
+      if (bddthreadnum > 1  &&
+	  (res=bdd_par_run(par_quant_task, r, 0, 0)) >= 0)
+      {
+	 checkresize();
+	 return OPEND(OPSTAT_FORALL, opstart, res);
+      }
+#endif
       
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = appquant_rec(l, r);
+      res = RUNOP(quant, (r));
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1566,43 +2896,45 @@ BDD bdd_appall(BDD l, BDD r, int opr, BDD var)
    }
 
    checkresize();
-   return res;
+   return OPEND(OPSTAT_FORALL, opstart, res);
 }
 
 
-BDD bdd_appuni(BDD l, BDD r, int opr, BDD var)
+BDD bdd_unique(BDD r, BDD var)
 {
    BDD res;
+   clock_t opstart;
    firstReorder = 1;
    
-   CHECKa(l, bddfalse);
    CHECKa(r, bddfalse);
    CHECKa(var, bddfalse);
    
-   if (opr<0 || opr>bddop_invimp)
-   {
-      bdd_error(BDD_OP);
-      return bddfalse;
-   }
-   
    if (var < 2)  /* Empty set */
-      return bdd_apply(l,r,opr);
+      return r;
+   opstart = OPBEGIN(OPSTAT_UNIQUE);
 
  again:
    if (setjmp(bddexception) == 0)
    {
       if (varset2vartable(var) < 0)
-	 return bddfalse;
+	 return OPEND(OPSTAT_UNIQUE, opstart, bddfalse);
 
       INITREF;
+      quantid = (var << 3) | CACHEID_UNIQUE;
       applyop = bddop_xor;
-      appexop = opr;
-      appexid = (var << 5) | (appexop << 1) | 1; /* FIXME: range! */
-      quantid = (appexid << 3) | CACHEID_APPUN;
+
+#ifdef BDD_THREADS
+      if (bddthreadnum > 1  &&
+	  (res=bdd_par_run(par_quant_task, r, 0, 0)) >= 0)
+      {
+	 checkresize();
+	 return OPEND(OPSTAT_UNIQUE, opstart, res);
+      }
+#endif
       
       if (!firstReorder)
 	 bdd_disable_reorder();
-      res = appquant_rec(l, r);
+      res = RUNOP(quant, (r));
       if (!firstReorder)
 	 bdd_enable_reorder();
    }
@@ -1616,44 +2948,209 @@ BDD bdd_appuni(BDD l, BDD r, int opr, BDD var)
    }
 
    checkresize();
-   return res;
+   return OPEND(OPSTAT_UNIQUE, opstart, res);
 }
 
 
-static int appquant_rec(int l, int r)
+static BDD quant_rec(BDD r)
 {
    BddCacheData *entry;
-   int res;
-
-   switch (appexop)
+   BDD res;
+   
+   if (r < 2  ||  LEVEL(r) > quantlast)
+      return r;
+
+   entry = BddCache_lookup2(&quantcache, QUANTHASH(r), r, quantid);
+   if (entry->a == r  &&  entry->c == quantid)
+   {
+      CACHEHIT(quantcache);
+      return entry->r.res;
+   }
+   CACHEMISS(quantcache, entry);
+
+   PUSHREF( quant_rec(LOW(r)) );
+   PUSHREF( quant_rec(HIGH(r)) );
+   
+   if (INVARSET(LEVEL(r)))
+      res = apply_rec(READREF(2), READREF(1));
+   else
+      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+
+   POPREF(2);
+   
+   entry->a = r;
+   entry->c = quantid;
+   entry->r.res = res;
+
+   return res;
+}
+
+
+/*=== APPLY & QUANTIFY =================================================*/
+
+BDD bdd_appex(BDD l, BDD r, int opr, BDD var)
+{
+   CHECKa(l, bddfalse);
+   CHECKa(r, bddfalse);
+   CHECKa(var, bddfalse);
+   
+   if (opr<0 || opr>bddop_invimp)
+   {
+      bdd_error(BDD_OP);
+      return bddfalse;
+   }
+   opr = apply_swapop(opr, &l, &r);
+   
+   if (var < 2)  /* Empty set */
+      return bdd_apply(l,r,opr);
+   return appquant_run(l, r, opr, var, bddop_or, CACHEID_APPEX,
+		       OPSTAT_APPEX);
+}
+
+
+BDD bdd_appall(BDD l, BDD r, int opr, BDD var)
+{
+   CHECKa(l, bddfalse);
+   CHECKa(r, bddfalse);
+   CHECKa(var, bddfalse);
+   
+   if (opr<0 || opr>bddop_invimp)
+   {
+      bdd_error(BDD_OP);
+      return bddfalse;
+   }
+   opr = apply_swapop(opr, &l, &r);
+   
+   if (var < 2)  /* Empty set */
+      return bdd_apply(l,r,opr);
+   return appquant_run(l, r, opr, var, bddop_and, CACHEID_APPAL,
+		       OPSTAT_APPALL);
+}
+
+
+BDD bdd_appuni(BDD l, BDD r, int opr, BDD var)
+{
+   CHECKa(l, bddfalse);
+   CHECKa(r, bddfalse);
+   CHECKa(var, bddfalse);
+   
+   if (opr<0 || opr>bddop_invimp)
+   {
+      bdd_error(BDD_OP);
+      return bddfalse;
+   }
+   opr = apply_swapop(opr, &l, &r);
+   
+   if (var < 2)  /* Empty set */
+      return bdd_apply(l,r,opr);
+   return appquant_run(l, r, opr, var, bddop_xor, CACHEID_APPUN,
+		       OPSTAT_APPUNI);
+}
+
+
+   /* Does the work of bdd_appex, bdd_appall and bdd_appuni once the
+      operands are in order. The quantification operator is qop, the cache
+      entries are told apart by kind and the time is counted for stat. */
+static BDD appquant_run(BDD l, BDD r, int opr, BDD var, int qop, int kind,
+			int stat)
+{
+   BDD res;
+   clock_t opstart;
+   firstReorder = 1;
+   
+   opstart = OPBEGIN(stat);
+
+ again:
+   if (setjmp(bddexception) == 0)
+   {
+      if (varset2vartable(var) < 0)
+	 return OPEND(stat, opstart, bddfalse);
+   
+      INITREF;
+      applyop = qop;
+      appexop = opr;
+      appexid = (var << 5) | (appexop << 1) | /* FIXME: range! */
+	 (kind != CACHEID_APPEX);
+      quantid = (appexid << 3) | kind;
+
+#ifdef BDD_THREADS
+      if (bddthreadnum > 1  &&
+	  (res=bdd_par_run(par_appquant_task, l, r, 0)) >= 0)
+      {
+	 checkresize();
+	 return OPEND(stat, opstart, res);
+      }
+#endif
+      
+      if (!firstReorder)
+	 bdd_disable_reorder();
+      res = RUNOP(appquant, (l, r));
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;  /* avoid warning about res being uninitialized */
+   }
+
+   checkresize();
+   return OPEND(stat, opstart, res);
+}
+
+
+   /* Shortcuts for appquant - returns -1 if the result has to be
+      calculated. If *quant is set then the result must be quantified. */
+static BDD appquant_terminal(BDD l, BDD r, int *quant)
+{
+   *quant = 0;
+   
+   switch (appexop)
    {
     case bddop_and:
        if (l == 0  ||  r == 0)
 	  return 0;
+       *quant = 1;
        if (l == r)
-	  return quant_rec(l);
+	  return l;
        if (l == 1)
-	  return quant_rec(r);
+	  return r;
        if (r == 1)
-	  return quant_rec(l);
+	  return l;
+       *quant = 0;
+#ifdef COMPLEMENT_EDGES
+       if (l == NOT(r))
+	  return 0;
+#endif
        break;
     case bddop_or:
        if (l == 1  ||  r == 1)
 	  return 1;
+       *quant = 1;
        if (l == r)
-	  return quant_rec(l);
+	  return l;
        if (l == 0)
-	  return quant_rec(r);
+	  return r;
        if (r == 0)
-	  return quant_rec(l);
+	  return l;
+       *quant = 0;
+#ifdef COMPLEMENT_EDGES
+       if (l == NOT(r))
+	  return 1;
+#endif
        break;
     case bddop_xor:
        if (l == r)
 	  return 0;
+       *quant = 1;
        if (l == 0)
-	  return quant_rec(r);
+	  return r;
        if (r == 0)
-	  return quant_rec(l);
+	  return l;
+       *quant = 0;
        break;
     case bddop_nand:
        if (l == 0  ||  r == 0)
@@ -1664,6 +3161,19 @@ static int appquant_rec(int l, int r)
 	  return 0;
        break;
    }
+
+   return -1;
+}
+
+
+static BDD appquant_rec(BDD l, BDD r)
+{
+   BddCacheData *entry;
+   BDD res;
+   int quant;
+
+   if ((res=appquant_terminal(l, r, &quant)) >= 0)
+      return quant ? quant_rec(res) : res;
    
    if (ISCONST(l)  &&  ISCONST(r))
       res = oprres[appexop][(l<<1) | r];
@@ -1677,17 +3187,20 @@ static int appquant_rec(int l, int r)
    }
    else
    {
-      entry = BddCache_lookup(&appexcache, APPEXHASH(l,r,appexop));
+      if (l > r  &&  COMMUTATIVE(appexop))
+      {
+	 BDD tmp = l;
+	 l = r;
+	 r = tmp;
+      }
+      
+      entry = BddCache_lookup3(&appexcache, APPEXHASH(l,r,appexop), l, r, appexid);
       if (entry->a == l  &&  entry->b == r  &&  entry->c == appexid)
       {
-#ifdef CACHESTATS
-	 bddcachestats.opHit++;
-#endif
+	 CACHEHIT(appexcache);
 	 return entry->r.res;
       }
-#ifdef CACHESTATS
-      bddcachestats.opMiss++;
-#endif
+      CACHEMISS(appexcache, entry);
 
       if (LEVEL(l) == LEVEL(r))
       {
@@ -1718,17 +3231,1076 @@ static int appquant_rec(int l, int r)
 	    res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
       }
 
-      POPREF(2);
-      
-      entry->a = l;
-      entry->b = r;
-      entry->c = appexid;
-      entry->r.res = res;
+      POPREF(2);
+      
+      entry->a = l;
+      entry->b = r;
+      entry->c = appexid;
+      entry->r.res = res;
+   }
+
+   return res;
+}
+
+
+/*=== MULTI-OPERAND APPLY & QUANTIFY ===================================*/
+
+   /* Copies the operands of bdd_appex_n to op, referenced, and quantifies
+      each variable in var that only one operand depends on right away in
+      that operand */
+static void appexn_local(BDD *r, int num, BDD var, BDD *op)
+{
+   int words = (bddvarnum+31) / 32;
+   unsigned int *sup = NEW(unsigned int, num*words+1);
+   int *count = NEW(int, bddvarnum);
+   int *qvar = NEW(int, bddvarnum);
+   int *vars = NEW(int, bddvarnum);
+   int qnum = 0;
+   int n, v, varnum;
+   BDD s;
+
+   for (n=0 ; n<num ; n++)
+      op[n] = bdd_addref(r[n]);
+   if (num < 2  ||  sup == NULL  ||  count == NULL  ||  qvar == NULL  ||
+       vars == NULL)
+      goto done;
+
+   for (s=var ; s > 1 ; s=HIGH(s))
+      qvar[qnum++] = bddlevel2var[LEVEL(s)];
+   
+   memset(count, 0, sizeof(int)*bddvarnum);
+   for (n=0 ; n<num ; n++)
+   {
+      unsigned int *ns = sup + n*words;
+      nary_support(r[n], ns, words);
+      for (v=0 ; v<qnum ; v++)
+	 if (ns[qvar[v] >> 5] & (1U << (qvar[v] & 31)))
+	    count[qvar[v]]++;
+   }
+
+   for (n=0 ; n<num ; n++)
+   {
+      unsigned int *ns = sup + n*words;
+      
+      for (v=varnum=0 ; v<qnum ; v++)
+	 if (count[qvar[v]] == 1  &&
+	     (ns[qvar[v] >> 5] & (1U << (qvar[v] & 31))))
+	    vars[varnum++] = qvar[v];
+      
+      if (varnum > 0)
+      {
+	 BDD cube = bdd_addref(bdd_makeset(vars, varnum));
+	 BDD tmp = bdd_addref(bdd_exist(op[n], cube));
+	 bdd_delref(cube);
+	 bdd_delref(op[n]);
+	 op[n] = tmp;
+      }
+   }
+
+ done:
+   free(sup);
+   free(count);
+   free(qvar);
+   free(vars);
+}
+
+
+BDD bdd_appex_n(BDD *r, int num, BDD var)
+{
+   BDD *op;
+   BDD res;
+   clock_t opstart;
+   int n;
+
+   if (num < 0)
+   {
+      bdd_error(BDD_RANGE);
+      return bddfalse;
+   }
+   for (n=0 ; n<num ; n++)
+      CHECKa(r[n], bddfalse);
+   CHECKa(var, bddfalse);
+
+   if (var < 2)  /* Empty set */
+      return bdd_apply_n(r, num, bddop_and);
+   
+   if ((op=NEW(BDD,num+1)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return bddfalse;
+   }
+   opstart = OPBEGIN(OPSTAT_APPEXN);
+
+   appexn_local(r, num, var, op);
+   res = appexn(op, num, var);
+
+   for (n=0 ; n<num ; n++)
+      bdd_delref(op[n]);
+   free(op);
+   
+   return OPEND(OPSTAT_APPEXN, opstart, res);
+}
+
+
+static BDD appexn(BDD *r, int num, BDD var)
+{
+   BDD res, mask;
+   int m;
+   firstReorder = 1;
+
+ again:
+   if (setjmp(bddexception) == 0)
+   {
+      if (varset2vartable(var) < 0)
+	 return bddfalse;
+      
+      INITREF;
+      applyop = bddop_or;
+      appexop = bddop_and;
+      appexid = (var << 5) | (appexop << 1); /* FIXME: range! */
+      quantid = (appexid << 3) | CACHEID_APPEX;
+
+      if (nary_fit(num) < 0  ||  nary_cachefit() < 0)
+	 return bddfalse;
+      if (num > 0)
+	 memcpy(narystack, r, sizeof(BDD)*num);
+      
+      if (!firstReorder)
+	 bdd_disable_reorder();
+      mask = 0;
+      m = nary_normalize(0, num, bddop_and, &mask);
+      res = m < 0 ? BDDZERO : appexn_rec(0, m, var);
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;  /* avoid warning about res being uninitialized */
+   }
+
+   checkresize();
+   return res;
+}
+
+
+   /* Conjoins the normalized list of num operands at narystack[base] and
+      quantifies the variables in quantvarset on the way. Below the last
+      of those variables it is a plain n-ary conjunction. The variable set
+      var itself is only used as part of the cache key. */
+static BDD appexn_rec(int base, int num, BDD var)
+{
+   BDD mask = 0, res;
+   unsigned int hash;
+   int level, quant, m, n;
+
+   if (num == 0)
+      return BDDONE;
+   if (num == 1)
+      return quant_rec(narystack[base]);
+   if (num == 2)
+      return appquant_rec(narystack[base], narystack[base+1]);
+
+   level = LEVEL(narystack[base]);
+   for (n=1 ; n<num ; n++)
+      level = MIN(level, LEVEL(narystack[base+n]));
+
+   if (level > quantlast)
+   {
+      applyop = bddop_and;
+      res = nary_rec(base, num);
+      applyop = bddop_or;
+      return res;
+   }
+   
+   hash = nary_hash(narystack+base, num, appexop, var);
+   if ((res=nary_lookup(hash, base, num, appexop, var)) >= 0)
+      return res;
+
+   if (nary_fit(base+2*num) < 0)
+      return BDDZERO;
+   quant = INVARSET(level);
+
+   for (n=0 ; n<num ; n++)
+      narystack[base+num+n] = LOWCOF(narystack[base+n], level);
+   m = nary_normalize(base+num, num, bddop_and, &mask);
+   PUSHREF( m < 0 ? BDDZERO : appexn_rec(base+num, m, var) );
+
+      /* x | 1 = 1 so the high cofactor is not needed */
+   if (quant  &&  READREF(1) == BDDONE)
+      res = BDDONE;
+   else
+   {
+      for (n=0 ; n<num ; n++)
+	 narystack[base+num+n] = HIGHCOF(narystack[base+n], level);
+      m = nary_normalize(base+num, num, bddop_and, &mask);
+      PUSHREF( m < 0 ? BDDZERO : appexn_rec(base+num, m, var) );
+      
+      if (quant)
+	 res = apply_rec(READREF(2), READREF(1));
+      else
+	 res = bdd_makenode(level, READREF(2), READREF(1));
+      POPREF(1);
+   }
+   POPREF(1);
+   
+   nary_store(hash, base, num, appexop, var, res);
+   return res;
+}
+
+
+/*=== ITERATIVE OPERATORS ==============================================*/
+
+/* Versions of the operators above that keep their continuations in the
+   explicit frame stack iterstack instead of the C stack (see
+   bdd_setengine). They give the same results and use the caches and the
+   reference stack the same way. Starting an operation on some operands
+   (iter_apply and friends) either pushes the result on the reference
+   stack directly or pushes a frame that is then run by iter_run: the
+   cofactors are computed in state 0 and 1 and the result node is made in
+   state 2. Quantifications that need to apply the operator to the two
+   cofactor results do so from state 2 and pick up the result in state 3.
+   The cache entry is kept in the frame just as the recursive versions
+   keep it on the C stack. */
+
+
+static void iter_push(int kind, int op, int level, BDD a, BDD b, BDD c,
+		      BDD mask, BddCacheData *entry)
+{
+   BddFrame *fr = &iterstack[iterstacktop++];
+
+   fr->kind = kind;
+   fr->state = 0;
+   fr->op = op;
+   fr->level = level;
+   fr->a = a;
+   fr->b = b;
+   fr->c = c;
+   fr->mask = mask;
+   fr->entry = entry;
+
+   if (iterstacktop > itermaxdepth)
+      itermaxdepth = iterstacktop;
+}
+
+
+static void iter_not(BDD r)
+{
+   BddCacheData *entry;
+
+   if (ISZERO(r))
+   {
+      PUSHREF(BDDONE);
+      return;
+   }
+   if (ISONE(r))
+   {
+      PUSHREF(BDDZERO);
+      return;
+   }
+   
+   entry = BddCache_lookup2(&applycache, NOTHASH(r), r, bddop_not);
+   if (entry->a == r  &&  entry->c == bddop_not)
+   {
+      CACHEHIT(applycache);
+      PUSHREF(entry->r.res);
+      return;
+   }
+   CACHEMISS(applycache, entry);
+
+   iter_push(ITER_NOT, 0, LEVEL(r), r, 0, 0, 0, entry);
+}
+
+
+static void iter_apply(int op, BDD l, BDD r)
+{
+   BddCacheData *entry;
+   BDD res, mask = 0;
+
+#ifdef COMPLEMENT_EDGES
+   if (op != bddop_and  &&  op != bddop_xor)
+   {
+      l ^= oprce[op][1];
+      r ^= oprce[op][2];
+      mask = oprce[op][3];
+      op = oprce[op][0];
+   }
+#endif
+
+   if ((res=apply_terminal(op, l, r)) >= 0)
+   {
+      PUSHREF(res ^ mask);
+      return;
+   }
+
+#ifdef COMPLEMENT_EDGES
+   if (op == bddop_xor  &&  (ISCOMPL(l)  ||  ISCOMPL(r)))
+   {
+      mask ^= (l ^ r) & 1;
+      l = REGULAR(l);
+      r = REGULAR(r);
+      if ((res=apply_terminal(op, l, r)) >= 0)
+      {
+	 PUSHREF(res ^ mask);
+	 return;
+      }
+   }
+#endif
+   
+   if (l > r  &&  COMMUTATIVE(op))
+   {
+      BDD tmp = l;
+      l = r;
+      r = tmp;
+   }
+   
+   entry = BddCache_lookup3(&applycache, APPLYHASH(l,r,op), l, r, op);
+   if (entry->a == l  &&  entry->b == r  &&  entry->c == op)
+   {
+      CACHEHIT(applycache);
+      PUSHREF(entry->r.res ^ mask);
+      return;
+   }
+   CACHEMISS(applycache, entry);
+
+   iter_push(ITER_APPLY, op, MIN(LEVEL(l),LEVEL(r)), l, r, 0, mask, entry);
+}
+
+
+static void iter_ite(BDD f, BDD g, BDD h)
+{
+   BddCacheData *entry;
+   BDD mask = 0, l, r;
+   int op;
+
+   if (ISONE(f))
+   {
+      PUSHREF(g);
+      return;
+   }
+   if (ISZERO(f))
+   {
+      PUSHREF(h);
+      return;
+   }
+   ite_normalize(&f, &g, &h);
+   if (g == h)
+   {
+      PUSHREF(g);
+      return;
+   }
+   if (ISONE(g) && ISZERO(h))
+   {
+      PUSHREF(f);
+      return;
+   }
+   if (ISZERO(g) && ISONE(h))
+   {
+#ifdef COMPLEMENT_EDGES
+      PUSHREF(NOT(f));
+#else
+      iter_not(f);
+#endif
+      return;
+   }
+   if ((op=ite_standard(f, g, h, &l, &r)) >= 0)
+   {
+      iter_apply(op, l, r);
+      return;
+   }
+#ifdef COMPLEMENT_EDGES
+   if (ISCOMPL(g))
+   {
+      mask = 1;
+      g = NOT(g);
+      h = NOT(h);
+   }
+#endif
+
+   entry = BddCache_lookup3(&itecache, ITEHASH(f,g,h), f, g, h);
+   if (entry->a == f  &&  entry->b == g  &&  entry->c == h)
+   {
+      CACHEHIT(itecache);
+      PUSHREF(entry->r.res ^ mask);
+      return;
+   }
+   CACHEMISS(itecache, entry);
+
+   iter_push(ITER_ITE, 0, MIN(LEVEL(f),MIN(LEVEL(g),LEVEL(h))), f, g, h,
+	     mask, entry);
+}
+
+
+static void iter_quant(BDD r)
+{
+   BddCacheData *entry;
+   
+   if (r < 2  ||  LEVEL(r) > quantlast)
+   {
+      PUSHREF(r);
+      return;
+   }
+
+   entry = BddCache_lookup2(&quantcache, QUANTHASH(r), r, quantid);
+   if (entry->a == r  &&  entry->c == quantid)
+   {
+      CACHEHIT(quantcache);
+      PUSHREF(entry->r.res);
+      return;
+   }
+   CACHEMISS(quantcache, entry);
+
+   iter_push(ITER_QUANT, 0, LEVEL(r), r, 0, 0, 0, entry);
+}
+
+
+static void iter_appquant(BDD l, BDD r)
+{
+   BddCacheData *entry;
+   BDD res;
+   int quant;
+
+   if ((res=appquant_terminal(l, r, &quant)) >= 0)
+   {
+      if (quant)
+	 iter_quant(res);
+      else
+	 PUSHREF(res);
+      return;
+   }
+   
+   if (ISCONST(l)  &&  ISCONST(r))
+   {
+      PUSHREF(oprres[appexop][(l<<1) | r]);
+      return;
+   }
+   if (LEVEL(l) > quantlast  &&  LEVEL(r) > quantlast)
+   {
+      iter_apply(appexop, l, r);
+      return;
+   }
+
+   if (l > r  &&  COMMUTATIVE(appexop))
+   {
+      BDD tmp = l;
+      l = r;
+      r = tmp;
+   }
+
+   entry = BddCache_lookup3(&appexcache, APPEXHASH(l,r,appexop), l, r, appexid);
+   if (entry->a == l  &&  entry->b == r  &&  entry->c == appexid)
+   {
+      CACHEHIT(appexcache);
+      PUSHREF(entry->r.res);
+      return;
+   }
+   CACHEMISS(appexcache, entry);
+
+   iter_push(ITER_APPQUANT, 0, MIN(LEVEL(l),LEVEL(r)), l, r, 0, 0, entry);
+}
+
+
+   /* Stores the result of the top frame in the cache, pops the frame and
+      pushes the result on the reference stack */
+static void iter_return(BddFrame *fr, BDD res)
+{
+   BddCacheData *entry = fr->entry;
+
+   entry->a = fr->a;
+   entry->r.res = res;
+   switch (fr->kind)
+   {
+   case ITER_NOT:
+      entry->c = bddop_not;
+      break;
+   case ITER_APPLY:
+      entry->b = fr->b;
+      entry->c = fr->op;
+      break;
+   case ITER_ITE:
+      entry->b = fr->b;
+      entry->c = fr->c;
+      break;
+   case ITER_QUANT:
+      entry->c = quantid;
+      break;
+   case ITER_APPQUANT:
+      entry->b = fr->b;
+      entry->c = appexid;
+      break;
+   }
+
+   iterstacktop--;
+   PUSHREF(res ^ fr->mask);
+}
+
+
+   /* Runs the frames until the stack is empty and returns the result */
+static BDD iter_run(void)
+{
+   BDD res;
+   
+   while (iterstacktop > 0)
+   {
+      BddFrame *fr = &iterstack[iterstacktop-1];
+      int level = fr->level;
+
+      switch (fr->state++)
+      {
+      case 0: /* Low cofactors */
+	 switch (fr->kind)
+	 {
+	 case ITER_NOT:
+	    iter_not(LOW(fr->a));
+	    break;
+	 case ITER_APPLY:
+	    iter_apply(fr->op, LOWCOF(fr->a,level), LOWCOF(fr->b,level));
+	    break;
+	 case ITER_ITE:
+	    iter_ite(LOWCOF(fr->a,level), LOWCOF(fr->b,level),
+		     LOWCOF(fr->c,level));
+	    break;
+	 case ITER_QUANT:
+	    iter_quant(LOW(fr->a));
+	    break;
+	 case ITER_APPQUANT:
+	    iter_appquant(LOWCOF(fr->a,level), LOWCOF(fr->b,level));
+	    break;
+	 }
+	 break;
+	 
+      case 1: /* High cofactors */
+	 switch (fr->kind)
+	 {
+	 case ITER_NOT:
+	    iter_not(HIGH(fr->a));
+	    break;
+	 case ITER_APPLY:
+	    iter_apply(fr->op, HIGHCOF(fr->a,level), HIGHCOF(fr->b,level));
+	    break;
+	 case ITER_ITE:
+	    iter_ite(HIGHCOF(fr->a,level), HIGHCOF(fr->b,level),
+		     HIGHCOF(fr->c,level));
+	    break;
+	 case ITER_QUANT:
+	    iter_quant(HIGH(fr->a));
+	    break;
+	 case ITER_APPQUANT:
+	    iter_appquant(HIGHCOF(fr->a,level), HIGHCOF(fr->b,level));
+	    break;
+	 }
+	 break;
+
+      case 2: /* Combine the cofactors */
+	 if ((fr->kind == ITER_QUANT  ||  fr->kind == ITER_APPQUANT)  &&
+	     INVARSET(level))
+	 {
+	    iter_apply(applyop, READREF(2), READREF(1));
+	    break;
+	 }
+	 res = bdd_makenode(level, READREF(2), READREF(1));
+	 POPREF(2);
+	 iter_return(fr, res);
+	 break;
+
+      case 3: /* Result of the quantification */
+	 res = READREF(1);
+	 POPREF(3);
+	 iter_return(fr, res);
+	 break;
+      }
+   }
+
+   res = READREF(1);
+   POPREF(1);
+   return res;
+}
+
+
+static BDD apply_iter(BDD l, BDD r)
+{
+   iterstacktop = 0;
+   iter_apply(applyop, l, r);
+   return iter_run();
+}
+
+
+static BDD ite_iter(BDD f, BDD g, BDD h)
+{
+   iterstacktop = 0;
+   iter_ite(f, g, h);
+   return iter_run();
+}
+
+
+static BDD quant_iter(BDD r)
+{
+   iterstacktop = 0;
+   iter_quant(r);
+   return iter_run();
+}
+
+
+static BDD appquant_iter(BDD l, BDD r)
+{
+   iterstacktop = 0;
+   iter_appquant(l, r);
+   return iter_run();
+}
+
+
+/*=== PARALLEL OPERATORS ===============================================*/
+
+#ifdef BDD_THREADS
+
+/* The parallel versions of the recursive operators. The low cofactor is
+   spawned as a task while the high cofactor is calculated by the current
+   thread. The current operator is passed as an argument since the
+   global operator variables are only read here. Results are thrown away
+   as soon as bddparabort is set, and nothing is written to the caches
+   after that since the result may be a stand-in for a missing node. */
+
+static BDD par_apply_rec(BddWorker *w, int op, BDD l, BDD r)
+{
+   BddCacheData entry;
+   BddTask task;
+   BDD res, high;
+   int level;
+
+#ifdef COMPLEMENT_EDGES
+   if (op != bddop_and  &&  op != bddop_xor)
+      return par_apply_rec(w, oprce[op][0], l ^ oprce[op][1],
+			   r ^ oprce[op][2]) ^ oprce[op][3];
+#endif
+
+   if ((res=apply_terminal(op, l, r)) >= 0)
+      return res;
+   
+#ifdef COMPLEMENT_EDGES
+   if (op == bddop_xor  &&  (ISCOMPL(l)  ||  ISCOMPL(r)))
+      return par_apply_rec(w, op, REGULAR(l), REGULAR(r)) ^ ((l ^ r) & 1);
+#endif
+
+   if (bddparabort)
+      return 0;
+   
+   if (l > r  &&  COMMUTATIVE(op))
+   {
+      BDD tmp = l;
+      l = r;
+      r = tmp;
+   }
+   
+   if (BddCache_parread(&applycache, APPLYHASH(l,r,op), &entry)  &&
+       entry.a == l  &&  entry.b == r  &&  entry.c == op)
+      return entry.r.res;
+
+   level = MIN(LEVEL(l), LEVEL(r));
+   
+   task.fn = par_apply_task;
+   task.a = LOWCOF(l,level);
+   task.b = LOWCOF(r,level);
+   task.c = op;
+   bdd_par_spawn(w, &task);
+   high = par_apply_rec(w, op, HIGHCOF(l,level), HIGHCOF(r,level));
+   res = bdd_par_sync(w, &task);
+
+   if (bddparabort)
+      return 0;
+   
+   res = bdd_par_makenode(w, level, res, high);
+   if (bddparabort)
+      return 0;
+   BddCache_parwrite(&applycache, APPLYHASH(l,r,op), l, r, op, res);
+
+   return res;
+}
+
+
+static BDD par_apply_task(BddWorker *w, BddTask *t)
+{
+   return par_apply_rec(w, (int)t->c, t->a, t->b);
+}
+
+
+static BDD par_ite_rec(BddWorker *w, BDD f, BDD g, BDD h)
+{
+   BddCacheData entry;
+   BddTask task;
+   BDD res, high, l, r;
+   int level, op;
+
+   if (ISONE(f))
+      return g;
+   if (ISZERO(f))
+      return h;
+   ite_normalize(&f, &g, &h);
+   if (g == h)
+      return g;
+   if (ISONE(g) && ISZERO(h))
+      return f;
+   if (ISZERO(g) && ISONE(h))
+#ifdef COMPLEMENT_EDGES
+      return NOT(f);
+#else
+      return par_apply_rec(w, bddop_xor, f, BDDONE);
+#endif
+   if ((op=ite_standard(f, g, h, &l, &r)) >= 0)
+      return par_apply_rec(w, op, l, r);
+#ifdef COMPLEMENT_EDGES
+   if (ISCOMPL(g))
+      return NOT(par_ite_rec(w, f, NOT(g), NOT(h)));
+#endif
+
+   if (bddparabort)
+      return 0;
+   
+   if (BddCache_parread(&itecache, ITEHASH(f,g,h), &entry)  &&
+       entry.a == f  &&  entry.b == g  &&  entry.c == h)
+      return entry.r.res;
+
+   level = MIN(LEVEL(f), MIN(LEVEL(g), LEVEL(h)));
+
+   task.fn = par_ite_task;
+   task.a = LOWCOF(f,level);
+   task.b = LOWCOF(g,level);
+   task.c = LOWCOF(h,level);
+   bdd_par_spawn(w, &task);
+   high = par_ite_rec(w, HIGHCOF(f,level), HIGHCOF(g,level),
+		      HIGHCOF(h,level));
+   res = bdd_par_sync(w, &task);
+
+   if (bddparabort)
+      return 0;
+   
+   res = bdd_par_makenode(w, level, res, high);
+   if (bddparabort)
+      return 0;
+   BddCache_parwrite(&itecache, ITEHASH(f,g,h), f, g, h, res);
+
+   return res;
+}
+
+
+static BDD par_ite_task(BddWorker *w, BddTask *t)
+{
+   return par_ite_rec(w, t->a, t->b, t->c);
+}
+
+
+static BDD par_quant_rec(BddWorker *w, BDD r)
+{
+   BddCacheData entry;
+   BddTask task;
+   BDD res, high;
+   
+   if (r < 2  ||  LEVEL(r) > quantlast)
+      return r;
+
+   if (bddparabort)
+      return 0;
+   
+   if (BddCache_parread(&quantcache, QUANTHASH(r), &entry)  &&
+       entry.a == r  &&  entry.c == quantid)
+      return entry.r.res;
+
+   task.fn = par_quant_task;
+   task.a = LOW(r);
+   bdd_par_spawn(w, &task);
+   high = par_quant_rec(w, HIGH(r));
+   res = bdd_par_sync(w, &task);
+
+   if (bddparabort)
+      return 0;
+   
+   if (INVARSET(LEVEL(r)))
+      res = par_apply_rec(w, applyop, res, high);
+   else
+      res = bdd_par_makenode(w, LEVEL(r), res, high);
+   
+   if (bddparabort)
+      return 0;
+   BddCache_parwrite(&quantcache, QUANTHASH(r), r, 0, quantid, res);
+
+   return res;
+}
+
+
+static BDD par_quant_task(BddWorker *w, BddTask *t)
+{
+   return par_quant_rec(w, t->a);
+}
+
+
+static BDD par_appquant_rec(BddWorker *w, BDD l, BDD r)
+{
+   BddCacheData entry;
+   BddTask task;
+   BDD res, high;
+   int quant, level;
+
+   if ((res=appquant_terminal(l, r, &quant)) >= 0)
+      return quant ? par_quant_rec(w, res) : res;
+   
+   if (ISCONST(l)  &&  ISCONST(r))
+      return oprres[appexop][(l<<1) | r];
+   if (LEVEL(l) > quantlast  &&  LEVEL(r) > quantlast)
+      return par_apply_rec(w, appexop, l, r);
+
+   if (bddparabort)
+      return 0;
+   
+   if (l > r  &&  COMMUTATIVE(appexop))
+   {
+      BDD tmp = l;
+      l = r;
+      r = tmp;
+   }
+   
+   if (BddCache_parread(&appexcache, APPEXHASH(l,r,appexop), &entry)  &&
+       entry.a == l  &&  entry.b == r  &&  entry.c == appexid)
+      return entry.r.res;
+
+   level = MIN(LEVEL(l), LEVEL(r));
+   
+   task.fn = par_appquant_task;
+   task.a = LOWCOF(l,level);
+   task.b = LOWCOF(r,level);
+   bdd_par_spawn(w, &task);
+   high = par_appquant_rec(w, HIGHCOF(l,level), HIGHCOF(r,level));
+   res = bdd_par_sync(w, &task);
+
+   if (bddparabort)
+      return 0;
+   
+   if (INVARSET(level))
+      res = par_apply_rec(w, applyop, res, high);
+   else
+      res = bdd_par_makenode(w, level, res, high);
+   
+   if (bddparabort)
+      return 0;
+   BddCache_parwrite(&appexcache, APPEXHASH(l,r,appexop), l, r, appexid, res);
+
+   return res;
+}
+
+
+static BDD par_appquant_task(BddWorker *w, BddTask *t)
+{
+   return par_appquant_rec(w, t->a, t->b);
+}
+
+
+   /* Puts the exact count of the regular node r into the count memo.
+      Returns 0 or -1 if out of memory. A node reached by two threads at
+      the same time is counted twice but only stored once. */
+static BDD par_satexact_rec(BddWorker *w, BDD r)
+{
+   BddBigInt *res;
+   BddTask task;
+   BDD high;
+   
+   if (r < 2  ||  countexact[NODE(r)] != NULL)
+      return 0;
+
+   task.fn = par_satexact_task;
+   task.a = REGULAR(LOW(r));
+   bdd_par_spawn(w, &task);
+   high = par_satexact_rec(w, REGULAR(HIGH(r)));
+   if (bdd_par_sync(w, &task) < 0  ||  high < 0)
+      return -1;
+
+   if ((res=satexact_node(r)) == NULL)
+      return -1;
+   if (!__sync_bool_compare_and_swap(&countexact[NODE(r)], NULL, res))
+      free(res);
+   
+   return 0;
+}
+
+
+static BDD par_satexact_task(BddWorker *w, BddTask *t)
+{
+   return par_satexact_rec(w, t->a);
+}
+
+
+   /* Puts the satcount of the node r into the count memo. As with the
+      exact count a node may be counted by several threads, but they all
+      store the same number. */
+static BDD par_satcount_rec(BddWorker *w, BDD r)
+{
+   BddCount *count;
+   BddTask task;
+   BDD n = REGULAR(r);
+   double size;
+   
+   if (r < 2  ||  (countmemo[NODE(r)].valid & COUNT_SAT))
+      return 0;
+
+   task.fn = par_satcount_task;
+   task.a = LOW(n);
+   bdd_par_spawn(w, &task);
+   par_satcount_rec(w, HIGH(n));
+   bdd_par_sync(w, &task);
+
+   size = pow(2.0, (double)(LEVEL(LOW(n)) - LEVEL(n) - 1)) *
+      satcount_memo(LOW(n));
+   size += pow(2.0, (double)(LEVEL(HIGH(n)) - LEVEL(n) - 1)) *
+      satcount_memo(HIGH(n));
+
+   count = &countmemo[NODE(r)];
+   count->sat = size;
+   __sync_fetch_and_or(&count->valid, COUNT_SAT);
+   
+   return 0;
+}
+
+
+static BDD par_satcount_task(BddWorker *w, BddTask *t)
+{
+   return par_satcount_rec(w, t->a);
+}
+
+
+   /* Marks the nodes of r in the visited bitmap of the thread */
+static BDD par_visit_rec(BddWorker *w, BDD r)
+{
+   BddTask task;
+
+   if (r < 2  ||  !PARVISIT(w, NODE(r)))
+      return 0;
+
+   task.fn = par_visit_task;
+   task.a = LOW(r);
+   bdd_par_spawn(w, &task);
+   par_visit_rec(w, HIGH(r));
+   bdd_par_sync(w, &task);
+   
+   return 0;
+}
+
+
+static BDD par_visit_task(BddWorker *w, BddTask *t)
+{
+   return par_visit_rec(w, t->a);
+}
+
+
+   /* Smallest number of nodes worth a parallel traversal */
+#define PARVISITMIN 4096
+
+   /* Clearing and merging the visited bitmaps costs bddnodesize/32 words
+      per thread whatever the size of the BDDs, so only BDDs with at
+      least that many nodes are traversed in parallel */
+#define PARVISITLIMIT \
+   MAX((BDD)PARVISITMIN, (bddnodesize/32 + 1) * (BDD)bddthreadnum)
+
+static void markcount_upto(BDD r, BDD *cou, BDD limit)
+{
+   BddNode *node;
+   
+   if (r < 2  ||  *cou >= limit)
+      return;
+
+   node = &bddnodes[NODE(r)];
+   if (MARKEDp(node)  ||  LOWp(node) == -1)
+      return;
+   
+   SETMARKp(node);
+   *cou += 1;
+   
+   markcount_upto(LOWp(node), cou, limit);
+   markcount_upto(HIGHp(node), cou, limit);
+}
+
+
+   /* Counts the nodes of r[0..num-1] sequentially, but stops at
+      PARVISITLIMIT. The count is exact when it is below the limit. */
+static BDD par_visitprobe(BDD *r, int num)
+{
+   BDD limit = PARVISITLIMIT;
+   BDD cou = 0;
+   int n;
+
+   for (n=0 ; n<num ; n++)
+      markcount_upto(r[n], &cou, limit);
+   for (n=0 ; n<num ; n++)
+      bdd_unmark(r[n]);
+
+   return cou < limit ? cou : -1;
+}
+
+
+   /* Visits the nodes of the BDDs r[0..num-1] in parallel. Returns the
+      union of the visited bitmaps or NULL if out of memory. */
+static unsigned int *par_visit(BDD *r, int num)
+{
+   int n;
+
+   if (bdd_par_visitclear() < 0)
+      return NULL;
+   for (n=0 ; n<num ; n++)
+      if (bdd_par_run(par_visit_task, r[n], 0, 0) < 0)
+	 return NULL;
+
+   return bdd_par_visitunion();
+}
+
+
+   /* Parallel bdd_anodecount, small BDDs are counted by the probe.
+      Returns -1 if out of memory. */
+static BDD par_nodecount(BDD *r, int num)
+{
+   unsigned int *visited;
+   BDD size = bddnodesize/32 + 1;
+   BDD n, cou;
+
+   if ((cou=par_visitprobe(r, num)) >= 0)
+      return cou;
+   if ((visited=par_visit(r, num)) == NULL)
+      return -1;
+
+   for (n=0, cou=0 ; n<size ; n++)
+      cou += __builtin_popcount(visited[n]);
+
+   return cou;
+}
+
+
+   /* Parallel varprofile_rec. Returns 1 if r is too small to pay for
+      the visited bitmaps and -1 if out of memory. */
+static int par_varprofile(BDD r)
+{
+   unsigned int *visited;
+   int size = bddnodesize/32 + 1;
+   int n;
+
+   if (par_visitprobe(&r, 1) >= 0)
+      return 1;
+   if ((visited=par_visit(&r, 1)) == NULL)
+      return -1;
+
+   for (n=0 ; n<size ; n++)
+   {
+      unsigned int bits = visited[n];
+
+      for ( ; bits != 0 ; bits &= bits-1)
+      {
+	 BddNode *node = &bddnodes[n*32 + __builtin_ctz(bits)];
+	 varprofile[bddlevel2var[LEVELp(node)]]++;
+      }
    }
 
-   return res;
+   return 0;
 }
 
+#endif /* BDD_THREADS */
+
 
 /*************************************************************************
   Informational functions
@@ -1738,9 +4310,8 @@ static int appquant_rec(int l, int r)
 
 BDD bdd_support(BDD r)
 {
-   static int  supportSize = 0;
    int n;
-   int res=1;
+   BDD res=1;
 
    CHECKa(r, bddfalse);
 
@@ -1800,14 +4371,14 @@ BDD bdd_support(BDD r)
 }
 
 
-static void support_rec(int r, int* support)
+static void support_rec(BDD r, int* support)
 {
    BddNode *node;
    
    if (r < 2)
       return;
 
-   node = &bddnodes[r];
+   node = &bddnodes[NODE(r)];
    if (LEVELp(node) & MARKON  ||  LOWp(node) == -1)
       return;
 
@@ -1960,14 +4531,14 @@ BDD bdd_fullsatone(BDD r)
 }
 
 
-static int fullsatone_rec(int r)
+static BDD fullsatone_rec(BDD r)
 {
    if (r < 2)
       return r;
    
    if (LOW(r) != 0)
    {
-      int res = fullsatone_rec(LOW(r));
+      BDD res = fullsatone_rec(LOW(r));
       int v;
       
       for (v=LEVEL(LOW(r))-1 ; v>LEVEL(r) ; v--)
@@ -1979,7 +4550,7 @@ static int fullsatone_rec(int r)
    }
    else
    {
-      int res = fullsatone_rec(HIGH(r));
+      BDD res = fullsatone_rec(HIGH(r));
       int v;
       
       for (v=LEVEL(HIGH(r))-1 ; v>LEVEL(r) ; v--)
@@ -2064,13 +4635,34 @@ static void allsat_rec(BDD r)
 double bdd_satcount(BDD r)
 {
    double size=1;
+   clock_t opstart;
 
    CHECKa(r, 0.0);
+   opstart = OPBEGIN(OPSTAT_SATCOUNT);
 
-   miscid = CACHEID_SATCOU;
-   size = pow(2.0, (double)LEVEL(r));
+      /* The threads share their results through the count memo, which is
+	 only used for this call if it is not enabled */
+   if ((countmemoon  ||  bddthreadnum > 1)  &&  countmemo_fit() == 0)
+   {
+#ifdef BDD_THREADS
+      if (bddthreadnum > 1)
+	 bdd_par_run(par_satcount_task, r, 0, 0);
+#endif
+      size = pow(2.0, (double)LEVEL(r)) * satcount_memo(r);
+      if (!countmemoon)
+      {
+	 free(countmemo);
+	 countmemo = NULL;
+	 countmemosize = 0;
+      }
+   }
+   else
+   {
+      miscid = CACHEID_SATCOU;
+      size = pow(2.0, (double)LEVEL(r)) * satcount_rec(r);
+   }
    
-   return size * satcount_rec(r);
+   return OPEND(OPSTAT_SATCOUNT, opstart, size);
 }
 
 
@@ -2091,33 +4683,36 @@ double bdd_satcountset(BDD r, BDD varset)
 }
 
 
-static double satcount_rec(int root)
+static double satcount_rec(BDD root)
 {
    BddCacheData *entry;
-   BddNode *node;
    double size, s;
    
    if (root < 2)
       return root;
 
-   entry = BddCache_lookup(&misccache, SATCOUHASH(root));
+   entry = BddCache_lookup2(&misccache, SATCOUHASH(root), root, miscid);
    if (entry->a == root  &&  entry->c == miscid)
-      return entry->r.dres;
+   {
+      CACHEHIT(misccache);
+      BddCache_getdouble(entry, size);
+      return size;
+   }
+   CACHEMISS(misccache, entry);
 
-   node = &bddnodes[root];
    size = 0;
    s = 1;
 
-   s *= pow(2.0, (float)(LEVEL(LOWp(node)) - LEVELp(node) - 1));
-   size += s * satcount_rec(LOWp(node));
+   s *= pow(2.0, (float)(LEVEL(LOW(root)) - LEVEL(root) - 1));
+   size += s * satcount_rec(LOW(root));
 
    s = 1;
-   s *= pow(2.0, (float)(LEVEL(HIGHp(node)) - LEVELp(node) - 1));
-   size += s * satcount_rec(HIGHp(node));
+   s *= pow(2.0, (float)(LEVEL(HIGH(root)) - LEVEL(root) - 1));
+   size += s * satcount_rec(HIGH(root));
 
    entry->a = root;
    entry->c = miscid;
-   entry->r.dres = size;
+   BddCache_setdouble(entry, size);
    
    return size;
 }
@@ -2126,16 +4721,23 @@ static double satcount_rec(int root)
 double bdd_satcountln(BDD r)
 {
    double size;
+   clock_t opstart;
 
    CHECKa(r, 0.0);
+   opstart = OPBEGIN(OPSTAT_SATCOUNTLN);
 
-   miscid = CACHEID_SATCOULN;
-   size = satcountln_rec(r);
+   if (countmemoon  &&  countmemo_fit() == 0)
+      size = satcountln_memo(r);
+   else
+   {
+      miscid = CACHEID_SATCOULN;
+      size = satcountln_rec(r);
+   }
 
    if (size >= 0.0)
       size += LEVEL(r);
 
-   return size;
+   return OPEND(OPSTAT_SATCOUNTLN, opstart, size);
 }
 
 
@@ -2156,10 +4758,9 @@ double bdd_satcountln(BDD r)
 }
 
 
-static double satcountln_rec(int root)
+static double satcountln_rec(BDD root)
 {
    BddCacheData *entry;
-   BddNode *node;
    double size, s1,s2;
    
    if (root == 0)
@@ -2167,19 +4768,22 @@ static double satcountln_rec(int root)
    if (root == 1)
       return 0.0;
 
-   entry = BddCache_lookup(&misccache, SATCOUHASH(root));
+   entry = BddCache_lookup2(&misccache, SATCOUHASH(root), root, miscid);
    if (entry->a == root  &&  entry->c == miscid)
-      return entry->r.dres;
-
-   node = &bddnodes[root];
+   {
+      CACHEHIT(misccache);
+      BddCache_getdouble(entry, size);
+      return size;
+   }
+   CACHEMISS(misccache, entry);
 
-   s1 = satcountln_rec(LOWp(node));
+   s1 = satcountln_rec(LOW(root));
    if (s1 >= 0.0)
-      s1 += LEVEL(LOWp(node)) - LEVELp(node) - 1;
+      s1 += LEVEL(LOW(root)) - LEVEL(root) - 1;
    
-   s2 = satcountln_rec(HIGHp(node));
+   s2 = satcountln_rec(HIGH(root));
    if (s2 >= 0.0)
-      s2 += LEVEL(HIGHp(node)) - LEVELp(node) - 1;
+      s2 += LEVEL(HIGH(root)) - LEVEL(root) - 1;
    
    if (s1 < 0.0)
       size = s2;
@@ -2192,7 +4796,7 @@ static double satcountln_rec(int root)
    
    entry->a = root;
    entry->c = miscid;
-   entry->r.dres = size;
+   BddCache_setdouble(entry, size);
    
    return size;
 }
@@ -2200,11 +4804,17 @@ static double satcountln_rec(int root)
 
 /*=== COUNT NUMBER OF ALLOCATED NODES ==================================*/
 
-int bdd_nodecount(BDD r)
+BDD bdd_nodecount(BDD r)
 {
-   int num=0;
+   BDD num=0;
 
    CHECK(r);
+
+#ifdef BDD_THREADS
+   if (bddthreadnum > 1  &&  (num=par_nodecount(&r, 1)) >= 0)
+      return num;
+   num = 0;
+#endif
    
    bdd_markcount(r, &num);
    bdd_unmark(r);
@@ -2213,10 +4823,16 @@ int bdd_nodecount(BDD r)
 }
 
 
-int bdd_anodecount(BDD *r, int num)
+BDD bdd_anodecount(BDD *r, int num)
 {
    int n;
-   int cou=0;
+   BDD cou=0;
+
+#ifdef BDD_THREADS
+   if (bddthreadnum > 1  &&  (cou=par_nodecount(r, num)) >= 0)
+      return cou;
+   cou = 0;
+#endif
 
    for (n=0 ; n<num ; n++)
       bdd_markcount(r[n], &cou);
@@ -2228,6 +4844,94 @@ int bdd_anodecount(BDD *r, int num)
 }
 
 
+/*=== NODE PROFILE OF SEVERAL BDDS =====================================*/
+
+/* Each node remembers the last BDD (index in r) it was reached from and
+   gets a bit in a bitmap when it is reached from another one as well.
+   So no unmarking is needed and the counts are collected by running
+   over the node table once afterwards. */
+
+BDD bdd_anodeprofile(BDD *r, int num, bddRootProfile *prof, BDD *levels,
+		     BDD *shared)
+{
+   unsigned int *sharedmap;
+   int *last;
+   int n;
+   BDD i, cou = 0;
+
+   for (n=0 ; n<num ; n++)
+      CHECK(r[n]);
+   
+   last = NEW(int, bddnodesize);
+   sharedmap = (unsigned int*)calloc(bddnodesize/32 + 1, sizeof(unsigned int));
+   if (last == NULL  ||  sharedmap == NULL)
+   {
+      free(last);
+      free(sharedmap);
+      return bdd_error(BDD_MEMORY);
+   }
+
+   memset(last, -1, sizeof(int)*bddnodesize);
+   if (levels != NULL)
+      memset(levels, 0, sizeof(BDD)*bddvarnum);
+   if (shared != NULL)
+      memset(shared, 0, sizeof(BDD)*bddvarnum);
+   
+   for (n=0 ; n<num ; n++)
+   {
+      prof[n].total = anodeprofile_rec(r[n], n, last, sharedmap);
+      prof[n].exclusive = 0;
+   }
+
+   for (i=NODE(2) ; i<bddnodesize ; i++)
+   {
+      int level = LEVELp(&bddnodes[i]);
+
+      if (last[i] < 0)
+	 continue;
+      
+      cou++;
+      if (levels != NULL)
+	 levels[level]++;
+      
+      if (sharedmap[i >> 5] & (1U << (i & 31)))
+      {
+	 if (shared != NULL)
+	    shared[level]++;
+      }
+      else
+	 prof[last[i]].exclusive++;
+   }
+
+   for (n=0 ; n<num ; n++)
+      prof[n].shared = prof[n].total - prof[n].exclusive;
+
+   free(last);
+   free(sharedmap);
+   return cou;
+}
+
+
+static BDD anodeprofile_rec(BDD r, int root, int *last, unsigned int *sharedmap)
+{
+   BDD n;
+
+   if (r < 2)
+      return 0;
+
+   n = NODE(r);
+   if (last[n] == root)
+      return 0;
+   
+   if (last[n] >= 0)
+      sharedmap[n >> 5] |= 1U << (n & 31);
+   last[n] = root;
+   
+   return 1 + anodeprofile_rec(LOW(r), root, last, sharedmap) +
+      anodeprofile_rec(HIGH(r), root, last, sharedmap);
+}
+
+
 /*=== NODE PROFILE =====================================================*/
 
 int *bdd_varprofile(BDD r)
@@ -2241,20 +4945,24 @@ int *bdd_varprofile(BDD r)
    }
 
    memset(varprofile, 0, sizeof(int)*bddvarnum);
+#ifdef BDD_THREADS
+   if (bddthreadnum > 1  &&  par_varprofile(r) == 0)
+      return varprofile;
+#endif
    varprofile_rec(r);
    bdd_unmark(r);
    return varprofile;
 }
 
 
-static void varprofile_rec(int r)
+static void varprofile_rec(BDD r)
 {
    BddNode *node;
    
    if (r < 2)
       return;
 
-   node = &bddnodes[r];
+   node = &bddnodes[NODE(r)];
    if (LEVELp(node) & MARKON)
       return;
 
@@ -2270,11 +4978,21 @@ static void varprofile_rec(int r)
 
 double bdd_pathcount(BDD r)
 {
+   double size;
+   clock_t opstart;
+   
    CHECKa(r, 0.0);
+   opstart = OPBEGIN(OPSTAT_PATHCOUNT);
 
-   miscid = CACHEID_PATHCOU;
+   if (countmemoon  &&  countmemo_fit() == 0)
+      size = pathcount_memo(r);
+   else
+   {
+      miscid = CACHEID_PATHCOU;
+      size = bdd_pathcount_rec(r);
+   }
 
-   return bdd_pathcount_rec(r);
+   return OPEND(OPSTAT_PATHCOUNT, opstart, size);
 }
 
 
@@ -2288,20 +5006,400 @@ static double bdd_pathcount_rec(BDD r)
    if (ISONE(r))
       return 1.0;
 
-   entry = BddCache_lookup(&misccache, PATHCOUHASH(r));
+   entry = BddCache_lookup2(&misccache, PATHCOUHASH(r), r, miscid);
    if (entry->a == r  &&  entry->c == miscid)
-      return entry->r.dres;
+   {
+      CACHEHIT(misccache);
+      BddCache_getdouble(entry, size);
+      return size;
+   }
+   CACHEMISS(misccache, entry);
 
    size = bdd_pathcount_rec(LOW(r)) + bdd_pathcount_rec(HIGH(r));
 
    entry->a = r;
    entry->c = miscid;
-   entry->r.dres = size;
+   BddCache_setdouble(entry, size);
    
    return size;
 }
 
 
+/*=== COUNT MEMO =======================================================*/
+
+/* With the count memo the counting functions keep their results per node
+   instead of in the shared misccache. The counts of a node only change
+   when the node is freed, the variables are reordered or new variables
+   are added. So the memo survives garbage collections, except for the
+   freed nodes, and counting BDDs that share structure with BDDs counted
+   before only visits the new nodes. */
+
+int bdd_setcountmemo(int enable)
+{
+   int old = countmemoon;
+   
+   countmemoon = (enable != 0);
+   if (!countmemoon)
+      countmemo_free();
+   
+   return old;
+}
+
+
+   /* Makes the memo cover the node table, which may have been resized
+      since it was used last */
+static int countmemo_fit(void)
+{
+   BddCount *memo;
+   BDD n;
+
+   if (countmemosize == bddnodesize)
+      return 0;
+
+      /* A new memo is zeroed by calloc, which saves touching a big table
+	 when the memo is only used for a single call */
+   if (countmemo == NULL)
+      memo = (BddCount*)calloc(bddnodesize, sizeof(BddCount));
+   else if ((memo=(BddCount*)realloc(countmemo,
+				    sizeof(BddCount)*bddnodesize)) != NULL)
+   {
+      for (n=countmemosize ; n<bddnodesize ; n++)
+	 memo[n].valid = 0;
+   }
+   if (memo == NULL)
+      return bdd_error(BDD_MEMORY);
+
+   countmemo = memo;
+   countmemosize = bddnodesize;
+   
+   return 0;
+}
+
+
+static void countmemo_clear(void)
+{
+   BDD n;
+   for (n=0 ; n<countmemosize ; n++)
+      countmemo[n].valid = 0;
+   for (n=0 ; n<countexactsize ; n++)
+   {
+      free(countexact[n]);
+      countexact[n] = NULL;
+   }
+}
+
+
+static void countmemo_free(void)
+{
+   countmemo_clear();
+   free(countmemo);
+   free(countexact);
+   countmemo = NULL;
+   countmemosize = 0;
+   countexact = NULL;
+   countexactsize = 0;
+}
+
+
+static double satcount_memo(BDD root)
+{
+   BddCount *count;
+   
+   if (root < 2)
+      return root;
+
+   count = &countmemo[NODE(root)];
+   if (!(count->valid & COUNT_SAT))
+   {
+      BDD n = REGULAR(root);
+      double size = 0, s;
+
+      s = pow(2.0, (double)(LEVEL(LOW(n)) - LEVEL(n) - 1));
+      size += s * satcount_memo(LOW(n));
+      
+      s = pow(2.0, (double)(LEVEL(HIGH(n)) - LEVEL(n) - 1));
+      size += s * satcount_memo(HIGH(n));
+
+      count->sat = size;
+      count->valid |= COUNT_SAT;
+   }
+
+#ifdef COMPLEMENT_EDGES
+   if (ISCOMPL(root))
+      return pow(2.0, (double)(bddvarnum - LEVEL(root))) - count->sat;
+#endif
+   return count->sat;
+}
+
+
+static double satcountln_memo(BDD root)
+{
+   BddCount *count;
+   
+   if (root == 0)
+      return -1.0;
+   if (root == 1)
+      return 0.0;
+
+   count = &countmemo[NODE(root)];
+   if (!(count->valid & COUNT_SATLN))
+   {
+      BDD n = REGULAR(root);
+      double size, s1, s2;
+
+      s1 = satcountln_memo(LOW(n));
+      if (s1 >= 0.0)
+	 s1 += LEVEL(LOW(n)) - LEVEL(n) - 1;
+   
+      s2 = satcountln_memo(HIGH(n));
+      if (s2 >= 0.0)
+	 s2 += LEVEL(HIGH(n)) - LEVEL(n) - 1;
+   
+      if (s1 < 0.0)
+	 size = s2;
+      else if (s2 < 0.0)
+	 size = s1;
+      else if (s1 < s2)
+	 size = s2 + log1p(pow(2.0,s1-s2)) / M_LN2;
+      else
+	 size = s1 + log1p(pow(2.0,s2-s1)) / M_LN2;
+
+      count->satln = size;
+      count->valid |= COUNT_SATLN;
+   }
+
+#ifdef COMPLEMENT_EDGES
+   if (ISCOMPL(root))
+   {
+	 /* log2(2^k - 2^s) with k variables below the node */
+      double k = bddvarnum - LEVEL(root);
+      if (count->satln < 0.0)
+	 return k;
+      if (count->satln >= k)
+	 return -1.0;
+      return k + log1p(-pow(2.0, count->satln-k)) / M_LN2;
+   }
+#endif
+   return count->satln;
+}
+
+
+static double pathcount_memo(BDD r)
+{
+   BddCount *count;
+   
+   if (ISZERO(r))
+      return 0.0;
+   if (ISONE(r))
+      return 1.0;
+
+   count = &countmemo[NODE(r)];
+   if (!(count->valid & COUNT_PATH))
+   {
+      BDD n = REGULAR(r);
+      
+      count->path = pathcount_memo(LOW(n)) + pathcount_memo(HIGH(n));
+#ifdef COMPLEMENT_EDGES
+	 /* Paths to zero are the paths to one of the negated children */
+      count->path0 = pathcount_memo(NOT(LOW(n))) +
+	 pathcount_memo(NOT(HIGH(n)));
+#endif
+      count->valid |= COUNT_PATH;
+   }
+
+#ifdef COMPLEMENT_EDGES
+   if (ISCOMPL(r))
+      return count->path0;
+#endif
+   return count->path;
+}
+
+
+/*=== EXACT COUNT ======================================================*/
+
+/* The exact counts are kept per node in countexact. It is part of the
+   count memo if that is enabled and otherwise only used for a single
+   call. The count of a node at level L is the number of satisfying
+   assignments to the variables at the levels L..bddvarnum-1, which needs
+   at most bddvarnum-L bits. */
+
+static BddBigInt *satcountexact(BDD r)
+{
+   const BddBigInt *count;
+   BddBigInt *tmp = NULL, *res = NULL;
+   clock_t opstart;
+
+   CHECKa(r, NULL);
+   opstart = OPBEGIN(OPSTAT_SATEXACT);
+
+   if (countexact_fit() < 0)
+      return OPEND(OPSTAT_SATEXACT, opstart, NULL);
+
+#ifdef BDD_THREADS
+   if (bddthreadnum > 1)
+      bdd_par_run(par_satexact_task, REGULAR(r), 0, 0);
+#endif
+
+   if ((count=satexact_rec(REGULAR(r))) != NULL)
+   {
+#ifdef COMPLEMENT_EDGES
+      if (ISCOMPL(r))
+	 count = tmp = BddBigInt_pow2sub(bddvarnum - LEVEL(r), count);
+#endif
+      if (count != NULL)
+	 res = BddBigInt_shiftadd(count, LEVEL(r), &BddBigInt_zero, 0);
+      free(tmp);
+   }
+
+   if (!countmemoon)
+   {
+	 /* After an error there may be counts below nodes without one */
+      if (res != NULL)
+	 countexact_free(REGULAR(r));
+      else
+	 countmemo_clear();
+      free(countexact);
+      countexact = NULL;
+      countexactsize = 0;
+   }
+   if (res == NULL)
+      bdd_error(BDD_MEMORY);
+   
+   return OPEND(OPSTAT_SATEXACT, opstart, res);
+}
+
+
+unsigned int *bdd_satcountexact(BDD r, int *size)
+{
+   BddBigInt *count;
+   unsigned int *res;
+
+   if ((count=satcountexact(r)) == NULL)
+      return NULL;
+
+   *size = count->size > 0 ? count->size : 1;
+   if ((res=(unsigned int*)malloc(sizeof(unsigned int) * *size)) == NULL)
+   {
+      free(count);
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   res[0] = 0;
+   memcpy(res, count->word, sizeof(unsigned int)*count->size);
+   free(count);
+   
+   return res;
+}
+
+
+char *bdd_satcountstr(BDD r)
+{
+   BddBigInt *count;
+   char *res;
+
+   if ((count=satcountexact(r)) == NULL)
+      return NULL;
+
+   if ((res=BddBigInt_str(count)) == NULL)
+      bdd_error(BDD_MEMORY);
+   free(count);
+   
+   return res;
+}
+
+
+   /* The count of the regular node r, which is known */
+static const BddBigInt *satexact_get(BDD r)
+{
+   if (r < 2)
+      return ISONE(r) ? &BddBigInt_one : &BddBigInt_zero;
+   return countexact[NODE(r)];
+}
+
+
+   /* Calculates the count of the regular node r from the known counts of
+      its children. Returns NULL if out of memory. */
+static BddBigInt *satexact_node(BDD r)
+{
+   BDD low = LOW(r), high = HIGH(r);
+   const BddBigInt *l = satexact_get(REGULAR(low));
+   const BddBigInt *h = satexact_get(REGULAR(high));
+   BddBigInt *ltmp = NULL, *htmp = NULL, *res = NULL;
+
+#ifdef COMPLEMENT_EDGES
+   if (ISCOMPL(low))
+      l = ltmp = BddBigInt_pow2sub(bddvarnum - LEVEL(low), l);
+   if (ISCOMPL(high))
+      h = htmp = BddBigInt_pow2sub(bddvarnum - LEVEL(high), h);
+#endif
+
+   if (l != NULL  &&  h != NULL)
+      res = BddBigInt_shiftadd(l, LEVEL(low) - LEVEL(r) - 1,
+			       h, LEVEL(high) - LEVEL(r) - 1);
+
+   free(ltmp);
+   free(htmp);
+   return res;
+}
+
+
+   /* Returns the count of the regular node r or NULL if out of memory */
+static const BddBigInt *satexact_rec(BDD r)
+{
+   if (r < 2)
+      return satexact_get(r);
+
+   if (countexact[NODE(r)] == NULL)
+   {
+      if (satexact_rec(REGULAR(LOW(r))) == NULL  ||
+	  satexact_rec(REGULAR(HIGH(r))) == NULL)
+	 return NULL;
+      countexact[NODE(r)] = satexact_node(r);
+   }
+
+   return countexact[NODE(r)];
+}
+
+
+   /* Like countmemo_fit */
+static int countexact_fit(void)
+{
+   BddBigInt **exact;
+
+   if (countexactsize == bddnodesize)
+      return 0;
+
+   if (countexact == NULL)
+      exact = (BddBigInt**)calloc(bddnodesize, sizeof(BddBigInt*));
+   else if ((exact=(BddBigInt**)realloc(countexact,
+				sizeof(BddBigInt*)*bddnodesize)) != NULL)
+      memset(exact+countexactsize, 0,
+	     sizeof(BddBigInt*)*(bddnodesize-countexactsize));
+   if (exact == NULL)
+      return bdd_error(BDD_MEMORY);
+
+   countexact = exact;
+   countexactsize = bddnodesize;
+   
+   return 0;
+}
+
+
+   /* Frees the counts below the regular node r. Only the nodes with a
+      count are visited. */
+static void countexact_free(BDD r)
+{
+   if (r < 2  ||  countexact[NODE(r)] == NULL)
+      return;
+
+   free(countexact[NODE(r)]);
+   countexact[NODE(r)] = NULL;
+   countexact_free(REGULAR(LOW(r)));
+   countexact_free(REGULAR(HIGH(r)));
+}
+
+
 /*************************************************************************
   Other internal functions
 *************************************************************************/
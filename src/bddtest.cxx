@@ -28,9 +28,13 @@
 ========================================================================*/
 
 #include <string>
+#include <vector>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
 #include "bdd.h"
 #include "bvec.h"
+#include "image.h"
 
 using namespace std;
 
@@ -97,6 +101,1095 @@ void testBvecIte()
 }
 
 
+void testNegation()
+{
+  cout << "Testing negation and operators\n";
+
+  bdd f = (bdd_ithvar(0) & bdd_nithvar(1)) | (bdd_ithvar(2) ^ bdd_ithvar(3));
+  bdd g = bdd_ithvar(1) | (bdd_nithvar(4) & bdd_ithvar(5));
+
+  if ((!!f) != f)
+    ERROR("Double negation failed.");
+  if (bdd_satcount(f) + bdd_satcount(!f) != 1024.0)
+    ERROR("Satcount of negation failed.");
+  
+  if (bdd_apply(f,g,bddop_or) != !((!f) & (!g)))
+    ERROR("Or failed.");
+  if (bdd_apply(f,g,bddop_nand) != !(f & g))
+    ERROR("Nand failed.");
+  if (bdd_apply(f,g,bddop_nor) != ((!f) & (!g)))
+    ERROR("Nor failed.");
+  if (bdd_apply(f,g,bddop_imp) != bdd_ite(f,g,bddtrue))
+    ERROR("Implication failed.");
+  if (bdd_apply(f,g,bddop_biimp) != bdd_ite(f,g,!g))
+    ERROR("Bi-implication failed.");
+  if (bdd_apply(f,g,bddop_diff) != (f & !g))
+    ERROR("Difference failed.");
+  if (bdd_apply(f,g,bddop_less) != ((!f) & g))
+    ERROR("Less than failed.");
+  if (bdd_apply(f,g,bddop_invimp) != bdd_ite(g,f,bddtrue))
+    ERROR("Inverse implication failed.");
+  if (bdd_ite(!f,g,!g) != (f ^ g))
+    ERROR("ITE with negated condition failed.");
+}
+
+
+void testThreads()
+{
+  cout << "Testing parallel operators\n";
+
+  bdd f = bddfalse, g = bddtrue;
+  for (int n=0 ; n<9 ; n++)
+  {
+    f = f ^ (bdd_ithvar(n) & bdd_nithvar(n+1));
+    g = g & (bdd_ithvar(n) | bdd_ithvar(9-n));
+  }
+  bdd vars = bdd_ithvar(1) & bdd_ithvar(4) & bdd_ithvar(7);
+
+  bdd a = f & g, o = f | g, i = bdd_ite(f,g,!f);
+  bdd e = bdd_exist(f,vars), u = bdd_forall(f|g,vars);
+  bdd r = bdd_appex(f,g,bddop_and,vars);
+  bdd all[3] = { f, g, a };
+  double sat = bdd_satcount(o);
+  BDD nodes = bdd_nodecount(i), anodes = bdd_anodecount(all, 3);
+  int *profile = bdd_varprofile(f), *pprofile;
+
+  if (bdd_setthreads(4) != 1)
+    ERROR("Setting threads failed.");
+  bdd_gbc();   /* Clears the operator caches */
+
+  if ((f & g) != a  ||  (f | g) != o)
+    ERROR("Parallel apply failed.");
+  if (bdd_ite(f,g,!f) != i)
+    ERROR("Parallel ITE failed.");
+  if (bdd_exist(f,vars) != e  ||  bdd_forall(f|g,vars) != u)
+    ERROR("Parallel quantification failed.");
+  if (bdd_appex(f,g,bddop_and,vars) != r)
+    ERROR("Parallel appex failed.");
+
+  pprofile = bdd_varprofile(f);
+  if (bdd_satcount(o) != sat  ||  bdd_nodecount(i) != nodes  ||
+      bdd_anodecount(all, 3) != anodes  ||
+      memcmp(profile, pprofile, sizeof(int)*bdd_varnum()) != 0)
+    ERROR("Parallel traversal failed.");
+  free(profile);
+  free(pprofile);
+
+  bdd_setuniquetable(BDD_UNIQUE_OPEN);
+  bdd_gbc();
+  if ((f & g) != a  ||  bdd_appex(f,g,bddop_and,vars) != r)
+    ERROR("Parallel operators with open addressing failed.");
+  bdd_setuniquetable(BDD_UNIQUE_CHAINED);
+
+  bdd_setthreads(1);
+
+  /* Only BDDs with more nodes than the visited bitmaps have words are
+     traversed in parallel. Equality of two vectors with their bits in
+     separate halves of the order gives one of about 50000 nodes. */
+  bdd_manager m;
+  bdd_manager::scope s(m);
+
+  bdd_init(10000, 1000);
+  bdd_setvarnum(28);
+  bdd_gbc_hook(NULL);
+  bdd_resize_hook(NULL);
+
+  bdd big = bddtrue;
+  for (int n=0 ; n<14 ; n++)
+    big &= bdd_biimp(bdd_ithvar(n), bdd_ithvar(n+14));
+  bdd parts[2] = { big, big & bdd_ithvar(0) };
+  nodes = bdd_nodecount(big);
+  anodes = bdd_anodecount(parts, 2);
+  profile = bdd_varprofile(big);
+
+  bdd_setthreads(4);
+  pprofile = bdd_varprofile(big);
+  if (bdd_nodecount(big) != nodes  ||  bdd_anodecount(parts, 2) != anodes  ||
+      memcmp(profile, pprofile, sizeof(int)*bdd_varnum()) != 0)
+    ERROR("Parallel traversal of large BDD failed.");
+  free(profile);
+  free(pprofile);
+  bdd_setthreads(1);
+}
+
+void testEngines()
+{
+  cout << "Testing iterative operators\n";
+
+  bdd f = bddfalse, g = bddtrue;
+  for (int n=0 ; n<9 ; n++)
+  {
+    f = f ^ (bdd_ithvar(n) & bdd_nithvar(n+1));
+    g = g & (bdd_ithvar(n) | bdd_ithvar(9-n));
+  }
+  bdd vars = bdd_ithvar(1) & bdd_ithvar(4) & bdd_ithvar(7);
+
+  bdd ops[bddop_invimp+1];
+  for (int op=0 ; op<=bddop_invimp ; op++)
+    ops[op] = bdd_apply(f,g,op);
+  bdd i = bdd_ite(f,g,!f), n = bdd_ite(g,bddfalse,bddtrue);
+  bdd e = bdd_exist(f,vars), a = bdd_forall(f|g,vars), u = bdd_unique(f,vars);
+  bdd ae = bdd_appex(f,g,bddop_and,vars), aa = bdd_appall(f,g,bddop_or,vars);
+  bdd au = bdd_appuni(f,g,bddop_xor,vars);
+
+  if (bdd_setengine(BDD_ENGINE_ITERATIVE) != BDD_ENGINE_RECURSIVE)
+    ERROR("Setting engine failed.");
+  bdd_gbc();   /* Clears the operator caches */
+
+  for (int op=0 ; op<=bddop_invimp ; op++)
+    if (bdd_apply(f,g,op) != ops[op])
+      ERROR("Iterative apply failed.");
+  if (bdd_ite(f,g,!f) != i  ||  bdd_ite(g,bddfalse,bddtrue) != n)
+    ERROR("Iterative ITE failed.");
+  if (bdd_exist(f,vars) != e  ||  bdd_forall(f|g,vars) != a  ||
+      bdd_unique(f,vars) != u)
+    ERROR("Iterative quantification failed.");
+  if (bdd_appex(f,g,bddop_and,vars) != ae  ||
+      bdd_appall(f,g,bddop_or,vars) != aa  ||
+      bdd_appuni(f,g,bddop_xor,vars) != au)
+    ERROR("Iterative appex failed.");
+
+  bddStat s;
+  bdd_stats(&s);
+  if (s.opdepth < 1  ||  s.opdepth > bdd_varnum())
+    ERROR("Wrong depth of iterative operators.");
+  
+  bdd_setengine(BDD_ENGINE_RECURSIVE);
+}
+
+void testIteTriples()
+{
+  cout << "Testing standard triples of ITE\n";
+
+  bdd f = (bdd_ithvar(0) & bdd_nithvar(3)) | bdd_ithvar(5);
+  bdd g = bdd_ithvar(1) ^ (bdd_ithvar(4) & bdd_ithvar(6));
+  bdd h = bdd_ithvar(2) | bdd_nithvar(7);
+  
+  for (int engine=BDD_ENGINE_RECURSIVE ; engine<=BDD_ENGINE_ITERATIVE ; engine++)
+  {
+    bdd_setengine(engine);
+    bdd_gbc();   /* Clears the operator caches */
+    
+    if (bdd_ite(f,bddtrue,h) != (f | h)  ||  bdd_ite(f,f,h) != (f | h))
+      ERROR("ITE as disjunction failed.");
+    if (bdd_ite(f,g,bddfalse) != (f & g)  ||  bdd_ite(f,g,f) != (f & g))
+      ERROR("ITE as conjunction failed.");
+    if (bdd_ite(f,bddfalse,h) != ((!f) & h))
+      ERROR("ITE as less than failed.");
+    if (bdd_ite(f,g,bddtrue) != (f >> g))
+      ERROR("ITE as implication failed.");
+    if (bdd_ite(f,g,!g) != bdd_apply(f,g,bddop_biimp))
+      ERROR("ITE as bi-implication failed.");
+
+      /* Equivalent calls share one entry in the apply cache */
+    bddStatSnapshot s1, s2;
+    bdd r = bdd_ite(bdd_ithvar(3),bddtrue,bdd_ithvar(8));
+    bdd_statsnapshot(&s1);
+    r = bdd_ite(bdd_ithvar(8),bddtrue,bdd_ithvar(3));
+    bdd_statsnapshot(&s2);
+    if (s2.opcache[0].lookups - s1.opcache[0].lookups != 1  ||
+	s2.opcache[0].hits - s1.opcache[0].hits != 1  ||
+	s2.opcache[1].lookups != s1.opcache[1].lookups)
+      ERROR("Standard triple not found in the apply cache.");
+  }
+  
+  bdd_setengine(BDD_ENGINE_RECURSIVE);
+}
+
+void testCommutative()
+{
+  cout << "Testing operand order in the caches\n";
+
+  bdd f = (bdd_ithvar(0) & bdd_nithvar(3)) | bdd_ithvar(5);
+  bdd g = bdd_ithvar(1) ^ (bdd_ithvar(4) & bdd_ithvar(6));
+  bdd vars = bdd_ithvar(4) & bdd_ithvar(5);
+  static const int pair[][2] =
+    { {bddop_and,bddop_and}, {bddop_or,bddop_or}, {bddop_xor,bddop_xor},
+      {bddop_nand,bddop_nand}, {bddop_nor,bddop_nor},
+      {bddop_biimp,bddop_biimp}, {bddop_diff,bddop_less},
+      {bddop_imp,bddop_invimp} };
+  
+  for (int engine=BDD_ENGINE_RECURSIVE ; engine<=BDD_ENGINE_ITERATIVE ; engine++)
+  {
+    bdd_setengine(engine);
+    
+    for (unsigned n=0 ; n<sizeof(pair)/sizeof(pair[0]) ; n++)
+    {
+      bdd_gbc();   /* Clears the operator caches */
+      bdd a = bdd_apply(f,g,pair[n][0]);
+      bdd e = bdd_appex(f,g,pair[n][0],vars);
+
+	/* Swapped operands find the results in the caches */
+      bddStatSnapshot s1, s2;
+      bdd_statsnapshot(&s1);
+      if (bdd_apply(g,f,pair[n][1]) != a)
+	ERROR("Apply with swapped operands failed.");
+      if (bdd_appex(g,f,pair[n][1],vars) != e)
+	ERROR("Appex with swapped operands failed.");
+      bdd_statsnapshot(&s2);
+      if (s2.cache.opMiss != s1.cache.opMiss)
+	ERROR("Swapped operands not found in the caches.");
+    }
+  }
+  
+  bdd_setengine(BDD_ENGINE_RECURSIVE);
+}
+
+void testCacheMode()
+{
+  cout << "Testing selective cache invalidation\n";
+
+  double sum[2];
+  
+  for (int mode=BDD_CACHE_RESET ; mode<=BDD_CACHE_SELECTIVE ; mode++)
+  {
+    bdd_setcachemode(mode);
+    bdd_gbc();
+    sum[mode] = 0.0;
+    
+    bdd f = bddfalse;
+    for (int n=0 ; n<8 ; n++)
+    {
+      f = f ^ (bdd_ithvar(n) & bdd_ithvar(9-n));
+
+         /* The variable sets and operands die at each gbc and their nodes
+	    are reused by the next round */
+      bdd vars = bdd_ithvar(n) & bdd_ithvar(n+1);
+      bdd g = f | bdd_ithvar(n+2);
+      sum[mode] += bdd_satcount(bdd_exist(f,vars)) + bdd_satcount(g & !f)
+	+ bdd_satcount(bdd_appex(f,g,bddop_and,vars))
+	+ bdd_satcount(bdd_restrict(g,vars)) + bdd_satcount(bdd_ite(f,g,!g))
+	+ bdd_satcount(bdd_compose(g,f,n+1)) + bdd_satcount(bdd_constrain(g,f));
+      g = bddfalse;
+      vars = bddfalse;
+      bdd_gbc();
+    }
+  }
+
+  if (sum[BDD_CACHE_RESET] != sum[BDD_CACHE_SELECTIVE])
+    ERROR("Selective cache invalidation gives other results.");
+  if (bdd_setcachemode(BDD_CACHE_RESET) != BDD_CACHE_SELECTIVE)
+    ERROR("Setting cache mode failed.");
+
+  /* Parallel operators run out of nodes in a small table and are retried.
+     Nothing they cached before the abort may survive the gbc in between. */
+  bdd_manager m;
+  bdd_manager::scope s(m);
+
+  bdd_init(500, 1000);
+  bdd_setvarnum(12);
+  bdd_gbc_hook(NULL);
+  bdd_resize_hook(NULL);
+
+  srand48(0xf00d);
+  for (int n=0 ; n<300 ; n++)
+  {
+    bdd r[3];
+    for (int k=0 ; k<3 ; k++)
+      for (int t=0 ; t<6 ; t++)
+      {
+	bdd c = bddtrue;
+	for (int v=0 ; v<12 ; v++)
+	  if (lrand48() % 3 == 0)
+	    c &= bdd_ithvar(v);
+	  else if (lrand48() % 2 == 0)
+	    c &= bdd_nithvar(v);
+	r[k] |= c;
+      }
+    bdd vars = bdd_ithvar(lrand48()%12) & bdd_ithvar(lrand48()%12);
+    int op = lrand48() % 4;
+
+    bdd_setcachemode(BDD_CACHE_SELECTIVE);
+    bdd_setthreads(4);
+    bdd a = bdd_apply(r[0], r[1], op);
+    bdd o = bdd_apply_n(r, 3, bddop_or);
+    bdd e = bdd_appex_n(r, 3, vars);
+    
+    bdd_setthreads(1);
+    bdd_setcachemode(BDD_CACHE_RESET);
+    bdd_gbc();
+    if (a != bdd_apply(r[0], r[1], op)  ||  o != bdd_apply_n(r, 3, bddop_or)  ||
+	e != bdd_appex_n(r, 3, vars))
+      ERROR("Parallel operators with selective invalidation failed.");
+  }
+}
+
+static int cacheAdaptCalls;
+static int cacheAdaptTotal;
+static int cacheApplySize;
+static int cacheReplaceSize;
+
+static void cacheAdaptHandler(bddCacheAdapt *stat)
+{
+  cacheAdaptCalls++;
+  cacheAdaptTotal += stat->newsize;
+  if (string(stat->name) == "apply")
+    cacheApplySize = stat->newsize;
+  else if (string(stat->name) == "replace")
+    cacheReplaceSize = stat->newsize;
+}
+
+void testCacheBudget()
+{
+  bdd_manager m;
+  bdd_manager::scope s(m);
+
+  cout << "Testing adaptive cache sizes\n";
+
+  const int budget = BDD_CACHENUM*4096;
+  bdd_init(10000, 4000);
+  bdd_setvarnum(20);
+  bdd_gbc_hook(NULL);
+  bdd_cache_hook(cacheAdaptHandler);
+  if (bdd_setcachebudget(budget) != 0)
+    ERROR("Setting cache budget failed.");
+
+     /* Lots of apply and nothing else */
+  for (int n=0 ; n<200 ; n++)
+  {
+    bdd f = bddfalse;
+    for (int i=0 ; i<20 ; i++)
+      f ^= bdd_ithvar(i) & bdd_ithvar((i*n+7) % 20);
+    cacheAdaptTotal = 0;
+    bdd g = f & bdd_ithvar(n % 20);
+    if (cacheAdaptTotal > budget)
+      ERROR("Cache budget exceeded.");
+  }
+
+  if (cacheAdaptCalls == 0  ||  cacheAdaptCalls % BDD_CACHENUM != 0)
+    ERROR("Wrong number of cache sizing calls.");
+  if (cacheApplySize <= 4096  ||  cacheReplaceSize >= 4096)
+    ERROR("Cache sizes not adapted.");
+  bddinthandler eh = bdd_error_hook(NULL);
+  if (bdd_setcachebudget(100) >= 0)
+    ERROR("Too small cache budget accepted.");
+  bdd_error_hook(eh);
+  if (bdd_setcachebudget(0) != budget)
+    ERROR("Clearing cache budget failed.");
+  
+  bdd_done();
+}
+
+void testStats()
+{
+  bdd_manager m;
+  bdd_manager::scope s(m);
+
+  cout << "Testing statistics\n";
+
+  bdd_init(1000, 1000);
+  bdd_setvarnum(10);
+  bdd_setstattime(1);
+
+  bdd f = bddfalse;
+  for (int i=0 ; i<9 ; i++)
+    f |= bdd_ithvar(i) & bdd_nithvar(i+1);
+  bdd g = bdd_exist(f, bdd_ithvar(3));
+  double count = bdd_satcount(f) + bdd_satcount(f);
+
+  bddStatSnapshot snap;
+  bdd_statsnapshot(&snap);
+
+  bddOpStat *apply = NULL, *exist = NULL, *satcount = NULL;
+  for (int n=0 ; n<BDD_OPSTATNUM ; n++)
+  {
+    if (strcmp(snap.op[n].name, "apply") == 0)
+      apply = &snap.op[n];
+    else if (strcmp(snap.op[n].name, "exist") == 0)
+      exist = &snap.op[n];
+    else if (strcmp(snap.op[n].name, "satcount") == 0)
+      satcount = &snap.op[n];
+  }
+  if (apply == NULL  ||  exist == NULL  ||  satcount == NULL)
+    ERROR("Operator missing in statistics.");
+  if (apply->calls != 18  ||  exist->calls != 1  ||  satcount->calls != 2)
+    ERROR("Wrong number of operator calls.");
+  if (apply->time < 0)
+    ERROR("Wrong operator time.");
+
+  /* f fails only for the 11 assignments where x0 <= x1 <= ... <= x9 */
+  if (count != 2.0*(ldexp(1.0, 10) - 11))
+    ERROR("Wrong satcount with statistics.");
+
+  long unsigned int hits = 0, lookups = 0;
+  for (int n=0 ; n<BDD_CACHENUM ; n++)
+  {
+    if (snap.opcache[n].hits > snap.opcache[n].lookups  ||
+	snap.opcache[n].resizes != 0)
+      ERROR("Wrong cache usage.");
+    hits += snap.opcache[n].hits;
+    lookups += snap.opcache[n].lookups;
+  }
+  if (snap.cache.opHit != hits  ||  snap.cache.opHit+snap.cache.opMiss != lookups)
+    ERROR("Cache statistics differ from cache usage.");
+  if (snap.opcache[5].hits == 0)
+    ERROR("Repeated satcount not found in cache.");
+
+  bdd_setcacheratio(4);
+  bdd_statsnapshot(&snap);
+  if (snap.opcache[0].resizes != 1)
+    ERROR("Cache resize not counted.");
+
+  FILE *dump = tmpfile();
+  bdd_fdumpstat(dump);
+  rewind(dump);
+  char buf[64];
+  if (fgets(buf, sizeof(buf), dump) == NULL  ||  buf[0] != '{')
+    ERROR("Statistics dump failed.");
+  fclose(dump);
+
+  bdd_done();
+}
+
+void testCountMemo()
+{
+  bdd_manager m;
+  bdd_manager::scope s(m);
+
+  cout << "Testing count memo\n";
+
+  bdd_init(1000, 1000);
+  bdd_setvarnum(16);
+  bdd_gbc_hook(NULL);
+
+  vector<bdd> f;
+  vector<double> sat, satln, path;
+  srand48(0xbeef);
+  for (int n=0 ; n<40 ; n++)
+  {
+    bdd g = bddfalse;
+    for (int i=0 ; i<6 ; i++)
+      g |= bdd_ithvar(lrand48()%16) & bdd_nithvar(lrand48()%16) & bdd_ithvar(lrand48()%16);
+    if (n % 3 == 0)
+      g = !g;
+    f.push_back(g);
+    sat.push_back(bdd_satcount(g));
+    satln.push_back(bdd_satcountln(g));
+    path.push_back(bdd_pathcount(g));
+  }
+
+  if (bdd_setcountmemo(1) != 0)
+    ERROR("Setting count memo failed.");
+
+  for (int round=0 ; round<4 ; round++)
+  {
+    bddStatSnapshot s1, s2;
+    bdd_statsnapshot(&s1);
+    for (unsigned n=0 ; n<f.size() ; n++)
+      if (bdd_satcount(f[n]) != sat[n]  ||  bdd_pathcount(f[n]) != path[n]  ||
+	  fabs(bdd_satcountln(f[n]) - satln[n]) > 1e-9)
+	ERROR("Count with memo failed.");
+    bdd_statsnapshot(&s2);
+    if (s2.opcache[5].lookups != s1.opcache[5].lookups)
+      ERROR("Count with memo used the cache.");
+
+    if (round == 0)
+    {
+      /* Garbage collection frees some nodes */
+      for (int n=0 ; n<20 ; n++)
+	bdd h = f[n] ^ f[n+1];
+      bdd_gbc();
+    }
+    else if (round == 1)
+    {
+      /* Reordering changes all nodes and the number of paths */
+      bdd_varblockall();
+      bdd_reorder(BDD_REORDER_SIFT);
+      bdd_setcountmemo(0);
+      for (unsigned n=0 ; n<f.size() ; n++)
+	path[n] = bdd_pathcount(f[n]);
+      bdd_setcountmemo(1);
+    }
+    else if (round == 2)
+    {
+      /* New variables double the counts */
+      bdd_setvarnum(17);
+      for (unsigned n=0 ; n<f.size() ; n++)
+      {
+	sat[n] *= 2;
+	satln[n] += 1;
+      }
+    }
+  }
+  
+  bdd_setcountmemo(0);
+  bdd_done();
+}
+
+static double satexact_double(const bdd &f)
+{
+  int size;
+  unsigned int *words = bdd_satcountexact(f, &size);
+  double res = 0.0;
+  for (int n=size-1 ; n>=0 ; n--)
+    res = res*4294967296.0 + words[n];
+  free(words);
+  return res;
+}
+
+static bool satexact_check(const bdd &f, int size, const unsigned int *expected)
+{
+  int n, fsize;
+  unsigned int *words = bdd_satcountexact(f, &fsize);
+  for (n=0 ; n<size  &&  fsize == size  &&  words[n] == expected[n] ; n++)
+    ;
+  free(words);
+  return n == size;
+}
+
+void testSatExact()
+{
+  bdd_manager m;
+  bdd_manager::scope s(m);
+
+  cout << "Testing exact satcount\n";
+
+  bdd_init(1000, 1000);
+  bdd_setvarnum(20);
+  bdd_gbc_hook(NULL);
+
+  /* Small counts agree with the doubles */
+  srand48(0xcafe);
+  for (int n=0 ; n<40 ; n++)
+  {
+    bdd g = bddfalse;
+    for (int i=0 ; i<6 ; i++)
+      g |= bdd_ithvar(lrand48()%20) & bdd_nithvar(lrand48()%20) & bdd_ithvar(lrand48()%20);
+    if (n % 3 == 0)
+      g = !g;
+
+    char buf[64], *str = bdd_satcountstr(g);
+    sprintf(buf, "%.0f", bdd_satcount(g));
+    if (satexact_double(g) != bdd_satcount(g)  ||  strcmp(str, buf) != 0)
+      ERROR("Exact satcount differs from satcount.");
+    free(str);
+  }
+
+  char *str = bdd_satcountstr(bddfalse);
+  if (strcmp(str, "0") != 0)
+    ERROR("Exact satcount of false failed.");
+  free(str);
+
+  /* Far more variables than a double can count */
+  bdd_setvarnum(2000);
+
+  bdd c = bddtrue;
+  for (int i=0 ; i<1900 ; i++)
+    c &= bdd_nithvar(i);
+  str = bdd_satcountstr(c);
+  if (strcmp(str, "1267650600228229401496703205376") != 0)
+    ERROR("Exact satcount of 2^100 failed.");
+  free(str);
+
+  bdd g = bdd_ithvar(1999);
+  for (int i=0 ; i<100 ; i++)
+    g &= bdd_nithvar(i*7);
+
+  for (int threads=1 ; threads<=4 ; threads*=4)
+  {
+    bdd_setthreads(threads);
+
+    /* 2^1899 and 2^2000 - 2^1899 */
+    unsigned int expected[63] = { 0 };
+    expected[59] = 1U << 11;
+    if (!satexact_check(g, 60, expected))
+      ERROR("Exact satcount of 2^1899 failed.");
+
+    expected[59] = 0xffffffffU << 11;
+    expected[60] = expected[61] = 0xffffffffU;
+    expected[62] = 0xffffU;
+    if (!satexact_check(!g, 63, expected))
+      ERROR("Exact satcount of 2^2000 - 2^1899 failed.");
+  }
+  bdd_setthreads(1);
+
+  /* The memo keeps the counts of the surviving nodes */
+  bdd_setcountmemo(1);
+  for (int round=0 ; round<2 ; round++)
+  {
+    unsigned int expected[60] = { 0 };
+    expected[59] = 1U << 11;
+    if (!satexact_check(g, 60, expected))
+      ERROR("Exact satcount with memo failed.");
+    for (int i=0 ; i<50 ; i++)
+      bdd h = g & bdd_ithvar(i*3+1);
+    bdd_gbc();
+  }
+  bdd_setcountmemo(0);
+  bdd_done();
+}
+
+void testAnodeProfile()
+{
+  cout << "Testing node profile of several BDDs\n";
+
+  bdd r[4];
+  r[0] = bdd_ithvar(0) & bdd_ithvar(6) & bdd_ithvar(9);
+  r[1] = (bdd_ithvar(1) | bdd_ithvar(5)) & bdd_ithvar(9);
+  r[2] = bdd_ithvar(2) ^ bdd_ithvar(3) ^ bdd_ithvar(4);
+  r[3] = r[2];
+
+  bddRootProfile prof[4];
+  BDD *levels = new BDD[bdd_varnum()];
+  BDD *shared = new BDD[bdd_varnum()];
+
+  if (bdd_anodeprofile(r, 4, prof, levels, shared) != bdd_anodecount(r, 4))
+    ERROR("Node profile count differs from anodecount.");
+
+  BDD sum = 0;
+  for (int n=0 ; n<4 ; n++)
+  {
+    if (prof[n].total != bdd_nodecount(r[n])  ||
+	prof[n].exclusive + prof[n].shared != prof[n].total)
+      ERROR("Node profile of a BDD failed.");
+    sum += prof[n].exclusive;
+  }
+
+  /* The node of x9 is the only one shared between r0 and r1, r2 and r3
+     share everything */
+  if (prof[0].exclusive != 2  ||  prof[1].shared != 1  ||
+      prof[2].exclusive != 0  ||  prof[3].shared != prof[3].total)
+    ERROR("Exclusive node counts failed.");
+
+  BDD levelsum = 0, sharedsum = 0;
+  for (int n=0 ; n<bdd_varnum() ; n++)
+  {
+    levelsum += levels[n];
+    sharedsum += shared[n];
+  }
+  if (levelsum != bdd_anodecount(r, 4)  ||  sharedsum != levelsum - sum  ||
+      levels[bdd_var2level(9)] != 1  ||  shared[bdd_var2level(9)] != 1)
+    ERROR("Level histograms failed.");
+
+  delete[] levels;
+  delete[] shared;
+}
+
+void testNary()
+{
+  cout << "Testing n-ary operators\n";
+
+  bdd r[12];
+  for (int n=0 ; n<12 ; n++)
+    r[n] = (bdd_ithvar(n%10) | bdd_nithvar((3*n+1)%10)) ^
+      (bdd_ithvar((n+5)%10) & bdd_ithvar((7*n+2)%10));
+  r[10] = r[3];
+  r[11] = !r[4];
+
+  int ops[3] = { bddop_and, bddop_or, bddop_xor };
+  for (int o=0 ; o<3 ; o++)
+    for (int num=0 ; num<=12 ; num+=(num < 3 ? 1 : 4))
+    {
+      bdd expect = (ops[o] == bddop_and ? bddtrue : bddfalse);
+      for (int n=0 ; n<num ; n++)
+	expect = bdd_apply(expect, r[n], ops[o]);
+      
+      for (int mode=BDD_NARY_SIZE ; mode<=BDD_NARY_RECURSIVE ; mode++)
+      {
+	bdd_setnaryschedule(mode);
+	if (bdd_apply_n(r, num, ops[o]) != expect)
+	  ERROR("N-ary apply failed.");
+      }
+    }
+
+  vector<bdd> v(r, r+10);
+  bdd all = bddtrue, any = bddfalse;
+  for (int n=0 ; n<10 ; n++)
+  {
+    all &= r[n];
+    any |= r[n];
+  }
+  if (bdd_and_n(v.begin(), v.end()) != all  ||
+      bdd_or_n(v.begin(), v.end()) != any)
+    ERROR("N-ary apply over a range failed.");
+
+  bdd_setnaryschedule(BDD_NARY_SIZE);
+}
+
+void testContainment()
+{
+  cout << "Testing containment tests\n";
+
+  bdd r[12];
+  for (int n=0 ; n<8 ; n++)
+    r[n] = (bdd_ithvar(n%10) | bdd_nithvar((3*n+1)%10)) ^
+      (bdd_ithvar((n+5)%10) & bdd_ithvar((7*n+2)%10));
+  r[8] = r[0] & r[1];
+  r[9] = !r[2];
+  r[10] = bddtrue;
+  r[11] = bddfalse;
+
+  for (int i=0 ; i<12 ; i++)
+    for (int j=0 ; j<12 ; j++)
+    {
+      if (bdd_leq(r[i], r[j]) != (bdd_imp(r[i], r[j]) == bddtrue))
+	ERROR("Implication test failed.");
+      if (bdd_disjoint(r[i], r[j]) != ((r[i] & r[j]) == bddfalse))
+	ERROR("Disjointness test failed.");
+      for (int k=0 ; k<12 ; k++)
+	if (bdd_equal_under(r[i], r[j], r[k]) !=
+	    (bdd_imp(r[k], bdd_biimp(r[i], r[j])) == bddtrue))
+	  ERROR("Equality on a care set failed.");
+    }
+
+  bdd a = r[0] & r[1], b = r[0] | r[2];
+  BDD nodes = bdd_getnodenum();
+  if (bdd_leq(a, r[0]) != 1  ||  bdd_leq(r[0], a) != 0  ||
+      bdd_disjoint(a, !r[1]) != 1  ||  bdd_equal_under(a, b, r[0] & r[1]) != 1)
+    ERROR("Containment test failed.");
+  if (bdd_getnodenum() != nodes)
+    ERROR("Containment tests made new nodes.");
+}
+
+void testAppexN()
+{
+  cout << "Testing n-ary relational product\n";
+
+  bdd r[5];
+  for (int n=0 ; n<5 ; n++)
+    r[n] = bdd_biimp(bdd_ithvar(2*n+1), bdd_ithvar(2*n) ^
+		     (bdd_ithvar((2*n+2)%10) & bdd_nithvar((2*n+5)%10)));
+  r[4] |= bdd_ithvar(3) & bdd_ithvar(8);
+
+  int even[5] = { 0, 2, 4, 6, 8 }, some[3] = { 1, 4, 9 };
+  bdd varsets[3] = { bdd_makeset(even, 5), bdd_makeset(some, 3), bddtrue };
+
+  for (int v=0 ; v<3 ; v++)
+    for (int num=0 ; num<=5 ; num++)
+    {
+      bdd all = bddtrue;
+      for (int n=0 ; n<num ; n++)
+	all &= r[n];
+      bdd expect = bdd_exist(all, varsets[v]);
+      
+      if (bdd_appex_n(r, num, varsets[v]) != expect)
+	ERROR("N-ary relational product failed.");
+	  /* Once more through the cache */
+      if (bdd_appex_n(r, num, varsets[v]) != expect)
+	ERROR("Cached n-ary relational product failed.");
+    }
+}
+
+void testImage()
+{
+  cout << "Testing image computation\n";
+
+  int cur[5] = { 0, 2, 4, 6, 8 }, next[5] = { 1, 3, 5, 7, 9 };
+  bdd x[5], y[5];
+  for (int n=0 ; n<5 ; n++)
+  {
+    x[n] = bdd_ithvar(cur[n]);
+    y[n] = bdd_ithvar(next[n]);
+  }
+  bdd curset = bdd_makeset(cur, 5), nextset = bdd_makeset(next, 5);
+  bddPair *tocur = bdd_newpair(), *tonext = bdd_newpair();
+  bdd_setpairs(tocur, next, cur, 5);
+  bdd_setpairs(tonext, cur, next, 5);
+
+    /* Conjunctive partitions: one next state function per variable */
+  bdd conj[5];
+  conj[0] = bdd_biimp(y[0], x[1] ^ x[2]);
+  conj[1] = bdd_biimp(y[1], x[0] & x[3]);
+  conj[2] = bdd_biimp(y[2], !x[2]);
+  conj[3] = bdd_biimp(y[3], x[3] | x[4]);
+  conj[4] = bdd_biimp(y[4], x[0] ^ x[4]);
+
+    /* Disjunctive partitions: flip one variable, keep the others */
+  bdd disj[5];
+  for (int n=0 ; n<5 ; n++)
+  {
+    disj[n] = bdd_biimp(y[n], !x[n]);
+    for (int m=0 ; m<5 ; m++)
+      if (m != n)
+	disj[n] &= bdd_biimp(y[m], x[m]);
+  }
+
+  bdd states[3] = { x[0] & !x[1], x[2] | (x[3] & x[4]), bddtrue };
+  int thresholds[3] = { 0, 8, 1000 };
+  
+  for (int kind=BDD_IMAGE_CONJ ; kind<=BDD_IMAGE_DISJ ; kind++)
+  {
+    bdd *part = (kind == BDD_IMAGE_CONJ ? conj : disj);
+    bdd T = (kind == BDD_IMAGE_CONJ ? bddtrue : bddfalse);
+    for (int n=0 ; n<5 ; n++)
+      T = bdd_apply(T, part[n], kind == BDD_IMAGE_CONJ ? bddop_and : bddop_or);
+    
+    for (int t=0 ; t<3 ; t++)
+    {
+      bddImage *img = bdd_newimage(part, 5, kind, cur, next, 5, thresholds[t]);
+      if (img == NULL)
+      {
+	ERROR("Making image relation failed.");
+	continue;
+      }
+      if ((thresholds[t] == 0  &&  bdd_imageclusters(img, 0) != 5)  ||
+	  (thresholds[t] == 1000  &&  bdd_imageclusters(img, 1) != 1))
+	ERROR("Wrong number of image clusters.");
+      
+      for (int n=0 ; n<3 ; n++)
+      {
+	bdd img1 = bdd_replace(bdd_appex(states[n], T, bddop_and, curset), tocur);
+	bdd pre1 = bdd_appex(bdd_replace(states[n], tonext), T, bddop_and,
+			     nextset);
+	if (bdd_image(img, states[n]) != img1)
+	  ERROR("Partitioned image failed.");
+	if (bdd_preimage(img, states[n]) != pre1)
+	  ERROR("Partitioned preimage failed.");
+      }
+      bdd_freeimage(img);
+    }
+  }
+
+  bdd_freepair(tocur);
+  bdd_freepair(tonext);
+}
+
+
+static int reachiterations;
+
+static void reachhandler(bddReachStat *stat)
+{
+  if (stat->iteration != ++reachiterations  ||  stat->setsize <= 0)
+    ERROR("Wrong reachability statistics.");
+}
+
+
+void testReachable()
+{
+  cout << "Testing reachability\n";
+
+  int cur[5] = { 0, 2, 4, 6, 8 }, next[5] = { 1, 3, 5, 7, 9 };
+  bdd x[5], y[5];
+  for (int n=0 ; n<5 ; n++)
+  {
+    x[n] = bdd_ithvar(cur[n]);
+    y[n] = bdd_ithvar(next[n]);
+  }
+  bdd curset = bdd_makeset(cur, 5), nextset = bdd_makeset(next, 5);
+  bddPair *tocur = bdd_newpair(), *tonext = bdd_newpair();
+  bdd_setpairs(tocur, next, cur, 5);
+  bdd_setpairs(tonext, cur, next, 5);
+
+    /* Events that pass a token to the next variable or drop the last one,
+       with and without the frame conditions */
+  bdd event[5], disj[5], T = bddfalse;
+  for (int n=0 ; n<5 ; n++)
+  {
+    if (n < 4)
+      event[n] = x[n] & !x[n+1] & !y[n] & y[n+1];
+    else
+      event[n] = x[n] & !y[n];
+    disj[n] = event[n];
+    for (int m=0 ; m<5 ; m++)
+      if (m != n  &&  m != n+1)
+	disj[n] &= bdd_biimp(x[m], y[m]);
+    if (n == 4)
+      disj[n] &= bdd_biimp(x[0], y[0]);
+    T |= disj[n];
+  }
+
+  bdd init[2] = { x[0] & !x[1] & !x[2] & !x[3] & !x[4],
+		  x[1] & x[3] & !x[0] };
+  for (int i=0 ; i<2 ; i++)
+  {
+    bdd R = init[i], prev;
+    do
+    {
+      prev = R;
+      R |= bdd_replace(bdd_appex(R, T, bddop_and, curset), tocur);
+    }
+    while (R != prev);
+    
+    for (int kind=BDD_IMAGE_DISJ ; kind<=BDD_IMAGE_EVENT ; kind++)
+    {
+      bddImage *img = bdd_newimage(kind == BDD_IMAGE_DISJ ? disj : event, 5,
+				   kind, cur, next, 5, 0);
+      if (img == NULL)
+      {
+	ERROR("Making image relation failed.");
+	continue;
+      }
+      if (bdd_image(img, R) != bdd_replace(bdd_appex(R, T, bddop_and, curset),
+					   tocur))
+	ERROR("Event image failed.");
+      if (bdd_preimage(img, init[i]) !=
+	  bdd_appex(bdd_replace(init[i], tonext), T, bddop_and, nextset))
+	ERROR("Event preimage failed.");
+      
+      for (int method=BDD_REACH_BFS ; method<=BDD_REACH_SAT ; method++)
+      {
+	reachiterations = 0;
+	if (bdd_reachable(img, init[i], method, reachhandler) != R)
+	  ERROR("Reachable states failed.");
+	if (reachiterations == 0)
+	  ERROR("No reachability statistics.");
+      }
+      bdd_freeimage(img);
+    }
+  }
+
+  bdd_freepair(tocur);
+  bdd_freepair(tonext);
+}
+
+void testManagers()
+{
+  cout << "Testing managers\n";
+
+  bdd f = bdd_ithvar(0) & bdd_ithvar(1);
+  double count = bdd_satcount(f);
+  bdd_manager m;
+  bdd h;
+  bvec v;
+  BDD used;
+
+  {
+    bdd_manager::scope s(m);
+    bdd_init(100,100);
+    bdd_setvarnum(3);
+    
+    bdd g = bdd_ithvar(1) | bdd_ithvar(2);
+    if (bdd_varnum() != 3  ||  bdd_satcount(g) != 6.0)
+      ERROR("Operation in second manager failed.");
+
+    h = g;
+    v = bvec_var(3, 0, 1) + bvec_con(3, 5);
+    bdd_gbc();
+    used = bdd_getnodenum();
+  }
+
+  if (bdd_getmanager() == m.handle())
+    ERROR("Manager scope failed.");
+
+     // The objects from the second manager are copied, overwritten and
+     // destroyed while the main manager is current
+  {
+    bdd h2 = h;
+    bvec v2 = v;
+    h = f;
+    v = bvec();
+    if (h2 == f  ||  v2.bitnum() != 3)
+      ERROR("Copy of object from second manager failed.");
+  }
+  
+  if (bdd_varnum() != 10  ||  bdd_satcount(f) != count  ||  h != f)
+    ERROR("Main manager changed by second manager.");
+
+  {
+    bdd_manager::scope s(m);
+    bdd_gbc();
+    if (bdd_getnodenum() >= used)
+      ERROR("Nodes released outside their manager not collected.");
+  }
+}
+
+   /* Gives a node more references than fit in its refcou field and checks
+      that it is kept exactly as long as any of them is left. */
+void testRefOverflow()
+{
+  cout << "Testing reference count overflow\n";
+
+  bddgbchandler hook = bdd_gbc_hook(NULL);
+  bdd_gbc();
+  BDD used = bdd_getnodenum();
+
+  {
+    vector<bdd> refs(3000, bdd_ithvar(2) & bdd_ithvar(3));
+    vector<bdd> vars(3000, bdd_ithvar(4));
+
+    refs.resize(1);
+    vars.clear();
+    bdd_gbc();
+    if (bdd_getnodenum() != used+1  ||  refs[0] != (bdd_ithvar(2) & bdd_ithvar(3)))
+      ERROR("Node with overflowed reference count lost.");
+    if (bdd_var(bdd_ithvar(4)) != 4)
+      ERROR("Variable node lost.");
+  }
+
+  bdd_gbc();
+  if (bdd_getnodenum() != used)
+    ERROR("Node with overflowed reference count not collected.");
+  bdd_gbc_hook(hook);
+}
+
+   /* Builds some BDDs among a lot of garbage, compacts the node table with
+      part of them as roots and checks that they are all unchanged. */
+void testCompact()
+{
+  bdd_manager m;
+  bdd_manager::scope s(m);
+
+  cout << "Testing compaction\n";
+  
+  bdd_init(1000, 1000);
+  bdd_setvarnum(16);
+  bdd_gbc_hook(NULL);
+
+  vector<bdd> keep;
+  vector<double> count;
+  for (int n=0 ; n<200 ; n++)
+  {
+    bdd f = bddfalse;
+    for (int i=0 ; i<16 ; i++)
+      if ((n*7+i*13) % 5 < 2)
+	f ^= bdd_ithvar(i) & bdd_ithvar((i*n+3) % 16);
+    if (n % 10 == 0)
+    {
+      keep.push_back(f);
+      count.push_back(bdd_satcount(f));
+    }
+  }
+  bdd pinned = keep[3] | keep[7];
+  BDD pinnedid = pinned.id();
+  double pinnedcount = bdd_satcount(pinned);
+  BDD oldsize = bdd_getallocnum();
+
+  if (bdd_compact(&keep[0], (int)keep.size()) != 0)
+    ERROR("Compaction failed.");
+  if (bdd_getallocnum() >= oldsize)
+    ERROR("Node table not shrunk by compaction.");
+  if (pinned.id() != pinnedid  ||  bdd_satcount(pinned) != pinnedcount)
+    ERROR("Pinned node changed by compaction.");
+  for (unsigned n=0 ; n<keep.size() ; n++)
+    if (bdd_satcount(keep[n]) != count[n])
+      ERROR("BDD changed by compaction.");
+  if ((keep[3] | keep[7]) != pinned)
+    ERROR("Nodes not found after compaction.");
+  bdd_done();
+}
+
+   /* Builds the conjunction of x_i <=> y_i with all x's before all y's,
+      which needs 3*2^n-1 nodes. The size n can be set with the environment
+      variable BDD_BIGTEST - with n=30 the node table grows past 2^31 nodes,
+      which needs 64 bit node indices (--enable-64bit-nodes) and about
+      130GB of memory. */
+void testBigTable()
+{
+  int n = getenv("BDD_BIGTEST") ? atoi(getenv("BDD_BIGTEST")) : 14;
+  bdd_manager m;
+  bdd_manager::scope s(m);
+
+  cout << "Testing node table with " << n << " variable pairs\n";
+  
+  bdd_init(100000, 10000);
+  bdd_setvarnum(2*n);
+  bdd_gbc_hook(NULL);
+  bdd_setmaxincrease((BDD)1 << (8*sizeof(BDD)-2));
+
+  bdd f = bddtrue;
+  for (int i=n-1 ; i>=0 ; i--)
+    f &= bdd_biimp(bdd_ithvar(i), bdd_ithvar(n+i));
+
+  if (bdd_satcount(f) != ldexp(1.0, n))
+    ERROR("Wrong result in big node table.");
+  if ((double)bdd_getnodenum() < 3.0*ldexp(1.0,n)-1)
+    ERROR("Too few nodes in big node table.");
+  if (n >= 30  &&  (double)bdd_getallocnum() <= ldexp(1.0,31))
+    ERROR("Node table did not grow past 2^31 nodes.");
+  
+  bdd_done();
+}
+
 int main(int ac, char** av)
 {
   bdd_init(1000,1000);
@@ -105,6 +1198,26 @@ int main(int ac, char** av)
 
   testSupport();
   testBvecIte();
+  testNegation();
+  testThreads();
+  testEngines();
+  testIteTriples();
+  testCommutative();
+  testCacheMode();
+  testCacheBudget();
+  testStats();
+  testCountMemo();
+  testSatExact();
+  testAnodeProfile();
+  testNary();
+  testContainment();
+  testAppexN();
+  testImage();
+  testReachable();
+  testManagers();
+  testRefOverflow();
+  testCompact();
+  testBigTable();
 
   bdd_done();
   return 0;
@@ -0,0 +1,198 @@
+/*========================================================================
+              Copyright (C) 2026 by the BuDDy contributors
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  $Header$
+  FILE:  bigint.c
+  DESCR: Unsigned integers of arbitrary size for exact counting
+  DATE:  (C) 2026
+
+  Only the few operations needed by the exact satcount are supported:
+  a sum of two shifted integers, the difference from a power of two and
+  conversion to decimal. Words are 32 bits with 64 bit intermediates.
+*************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "bigint.h"
+
+#define WORDBITS 32
+
+typedef unsigned long long bigword;
+
+const BddBigInt BddBigInt_zero = { 0, { 0 } };
+const BddBigInt BddBigInt_one = { 1, { 1 } };
+
+
+static BddBigInt *bigint_new(int size)
+{
+   BddBigInt *res;
+
+   res = (BddBigInt*)malloc(sizeof(BddBigInt) +
+			    sizeof(unsigned int)*(size > 0 ? size-1 : 0));
+   if (res == NULL)
+      return NULL;
+
+   res->size = size;
+   memset(res->word, 0, sizeof(unsigned int)*size);
+   return res;
+}
+
+
+static void bigint_trim(BddBigInt *a)
+{
+   while (a->size > 0  &&  a->word[a->size-1] == 0)
+      a->size--;
+}
+
+
+   /* Add a shifted left by shift bits to res, which must be big enough */
+static void bigint_addshifted(BddBigInt *res, const BddBigInt *a, int shift)
+{
+   int pos = shift / WORDBITS;
+   int bits = shift % WORDBITS;
+   bigword carry = 0;
+   int n;
+
+   for (n=0 ; n<a->size ; n++, pos++)
+   {
+      bigword v = (bigword)a->word[n] << bits;
+
+      carry += (bigword)res->word[pos] + (unsigned int)v;
+      res->word[pos] = (unsigned int)carry;
+      carry = (carry >> WORDBITS) + (v >> WORDBITS);
+   }
+
+   for ( ; carry != 0 ; pos++)
+   {
+      carry += res->word[pos];
+      res->word[pos] = (unsigned int)carry;
+      carry >>= WORDBITS;
+   }
+}
+
+
+/* Returns (a << sa) + (b << sb) or NULL if out of memory */
+BddBigInt *BddBigInt_shiftadd(const BddBigInt *a, int sa,
+			      const BddBigInt *b, int sb)
+{
+   int sizea = a->size + sa/WORDBITS + 1;
+   int sizeb = b->size + sb/WORDBITS + 1;
+   BddBigInt *res;
+
+   if ((res=bigint_new((sizea > sizeb ? sizea : sizeb) + 1)) == NULL)
+      return NULL;
+
+   bigint_addshifted(res, a, sa);
+   bigint_addshifted(res, b, sb);
+   bigint_trim(res);
+
+   return res;
+}
+
+
+/* Returns 2^k - a, where a must not be larger than 2^k, or NULL if out of
+   memory */
+BddBigInt *BddBigInt_pow2sub(int k, const BddBigInt *a)
+{
+   BddBigInt *res;
+   bigword borrow = 0;
+   int n;
+
+   if ((res=bigint_new(k/WORDBITS + 1)) == NULL)
+      return NULL;
+
+   res->word[k/WORDBITS] = 1U << (k % WORDBITS);
+
+   for (n=0 ; n<res->size ; n++)
+   {
+      bigword sub = (n < a->size ? a->word[n] : 0) + borrow;
+
+      borrow = (bigword)res->word[n] < sub;
+      res->word[n] = (unsigned int)((bigword)res->word[n] - sub);
+   }
+
+   bigint_trim(res);
+   return res;
+}
+
+
+/* Returns the decimal representation of a in a string allocated with
+   malloc() or NULL if out of memory */
+char *BddBigInt_str(const BddBigInt *a)
+{
+      /* Nine digits per chunk, ten per word is more than enough */
+   unsigned int *tmp, *chunk;
+   int size = a->size, chunks = 0;
+   char *res, *p;
+   int n;
+
+   tmp = (unsigned int*)malloc(sizeof(unsigned int)*(size+1));
+   chunk = (unsigned int*)malloc(sizeof(unsigned int)*(2*size+1));
+   res = (char*)malloc(10*size + 2);
+   if (tmp == NULL  ||  chunk == NULL  ||  res == NULL)
+   {
+      free(tmp);
+      free(chunk);
+      free(res);
+      return NULL;
+   }
+
+   memcpy(tmp, a->word, sizeof(unsigned int)*size);
+
+      /* Divide by 10^9 until nothing is left */
+   do
+   {
+      bigword rest = 0;
+
+      for (n=size-1 ; n>=0 ; n--)
+      {
+	 bigword v = (rest << WORDBITS) | tmp[n];
+	 tmp[n] = (unsigned int)(v / 1000000000);
+	 rest = v % 1000000000;
+      }
+      chunk[chunks++] = (unsigned int)rest;
+
+      while (size > 0  &&  tmp[size-1] == 0)
+	 size--;
+   }
+   while (size > 0);
+
+   p = res + sprintf(res, "%u", chunk[chunks-1]);
+   for (n=chunks-2 ; n>=0 ; n--)
+      p += sprintf(p, "%09u", chunk[n]);
+
+   free(tmp);
+   free(chunk);
+   return res;
+}
+
+
+/* EOF */
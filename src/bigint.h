@@ -0,0 +1,61 @@
+/*========================================================================
+              Copyright (C) 2026 by the BuDDy contributors
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  $Header$
+  FILE:  bigint.h
+  DESCR: Unsigned integers of arbitrary size for exact counting
+  DATE:  (C) 2026
+*************************************************************************/
+
+#ifndef _BIGINT_H
+#define _BIGINT_H
+
+   /* An unsigned integer with the least significant word first. The size
+      is the number of words in use, so the top word is never zero and
+      zero itself has size zero. The words are allocated together with
+      the header and the whole thing is released with free(). */
+typedef struct s_BddBigInt
+{
+   int size;
+   unsigned int word[1];
+} BddBigInt;
+
+extern const BddBigInt BddBigInt_zero;
+extern const BddBigInt BddBigInt_one;
+
+extern BddBigInt *BddBigInt_shiftadd(const BddBigInt *, int,
+				      const BddBigInt *, int);
+extern BddBigInt *BddBigInt_pow2sub(int, const BddBigInt *);
+extern char      *BddBigInt_str(const BddBigInt *);
+
+#endif /* _BIGINT_H */
+
+
+/* EOF */
@@ -36,6 +36,7 @@
 *************************************************************************/
 
 #include <stdlib.h>
+#include "config.h"
 #include "kernel.h"
 #include "bvec.h"
 
@@ -518,22 +518,26 @@ class bvec
 {
  public:
 
-   bvec(void)                { roots.bitvec=NULL; roots.bitnum=0; }
-   bvec(int bitnum)          { roots=bvec_false(bitnum); }
-   bvec(int bitnum, int val) { roots=bvec_con(bitnum,val); }
-   bvec(const bvec &v)       { roots=bvec_copy(v.roots); }
-   ~bvec(void)               { bvec_free(roots); }
+   bvec(void)                { roots.bitvec=NULL; roots.bitnum=0; mgr=NULL; }
+   bvec(int bitnum)          { roots=bvec_false(bitnum); mgr=bdd_getmanager(); }
+   bvec(int bitnum, int val) { roots=bvec_con(bitnum,val); mgr=bdd_getmanager(); }
+   bvec(const bvec &v)       { copy(v); }
+   ~bvec(void)               { release(); }
 
    void set(int i, const bdd &b);
-   bdd operator[](int i)  const { return roots.bitvec[i]; }
+   bdd operator[](int i)  const { return bdd(roots.bitvec[i], mgr); }
    int bitnum(void) const       { return roots.bitnum; }
    int empty(void) const        { return roots.bitnum==0; }
    bvec operator=(const bvec &src);
    
 private:
    BVEC roots;
+   bddManager *mgr;  /* Manager of the bits, see bdd::mgr */
 
-   bvec(const BVEC &v) { roots=v; } /* NOTE: Must be a shallow copy! */
+      /* NOTE: Must be a shallow copy! */
+   bvec(const BVEC &v) { roots=v; mgr=bdd_getmanager(); }
+   void copy(const bvec &v);
+   void release(void);
 
    friend bvec bvec_truepp(int bitnum);
    friend bvec bvec_falsepp(int bitnum);
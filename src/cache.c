@@ -35,6 +35,8 @@
   DATE:  (C) june 1997
 *************************************************************************/
 #include <stdlib.h>
+#include <limits.h>
+#include "config.h"
 #include "kernel.h"
 #include "cache.h"
 #include "prime.h"
@@ -42,46 +44,115 @@
 /*************************************************************************
 *************************************************************************/
 
-int BddCache_init(BddCache *cache, int size)
+   /* Packed caches have a power-of-two size so that they can be indexed
+      by masking, the others a prime size. Set associative caches have
+      twice that many entries, two per set. */
+#ifdef ASSOC_CACHE
+#define CACHEWAYS 2
+#else
+#define CACHEWAYS 1
+#endif
+
+int BddCache_size(int size)
 {
+#ifdef PACKED_CACHE
+   int n = CACHEWAYS;
+   while (n < size  &&  n < (INT_MAX >> 1) + 1)
+      n <<= 1;
+   return n;
+#else
+   return CACHEWAYS * (int)bdd_prime_gte(MAX((size+CACHEWAYS-1)/CACHEWAYS, 2));
+#endif
+}
+
+
+   /* Allocates a new empty table of the given size. On failure the old
+      table is kept and -1 is returned without reporting an error. */
+int BddCache_setsize(BddCache *cache, int size)
+{
+   BddCacheData *table;
+#ifdef BDD_THREADS
+   unsigned int *seq;
+#endif
    int n;
 
-   size = bdd_prime_gte(size);
+   size = BddCache_size(size);
    
-   if ((cache->table=NEW(BddCacheData,size)) == NULL)
-      return bdd_error(BDD_MEMORY);
+   if ((table=NEW(BddCacheData,size)) == NULL)
+      return -1;
+#ifdef BDD_THREADS
+   if ((seq=(unsigned int*)calloc(size,sizeof(unsigned int))) == NULL)
+   {
+      free(table);
+      return -1;
+   }
+   free(cache->seq);
+   cache->seq = seq;
+#endif
+   if (cache->table != NULL  &&  size != cache->tablesize)
+      cache->resizes++;
+   free(cache->table);
    
    for (n=0 ; n<size ; n++)
-      cache->table[n].a = -1;
+      table[n].a = -1;
+   cache->table = table;
    cache->tablesize = size;
+#ifdef PACKED_CACHE
+   cache->mask = (bddhashval)(size-1);
+#endif
+   BddCache_sumcount(cache);
    
    return 0;
 }
 
 
+   /* The largest valid size not above size */
+int BddCache_fit(int size)
+{
+#ifdef PACKED_CACHE
+   int n = CACHEWAYS;
+   while (n <= (size >> 1))
+      n <<= 1;
+   return n;
+#else
+   return CACHEWAYS * (int)bdd_prime_lte(MAX(size/CACHEWAYS, 2));
+#endif
+}
+
+
+int BddCache_init(BddCache *cache, int size)
+{
+   cache->table = NULL;
+   cache->tablesize = 0;
+   cache->hits = cache->misses = cache->overwrites = 0;
+   cache->sumhits = cache->summisses = cache->sumoverwrites = 0;
+   cache->resizes = 0;
+#ifdef BDD_THREADS
+   cache->seq = NULL;
+#endif
+   
+   if (BddCache_setsize(cache, size) < 0)
+      return bdd_error(BDD_MEMORY);
+   return 0;
+}
+
+
 void BddCache_done(BddCache *cache)
 {
    free(cache->table);
    cache->table = NULL;
    cache->tablesize = 0;
+#ifdef BDD_THREADS
+   free(cache->seq);
+   cache->seq = NULL;
+#endif
 }
 
 
 int BddCache_resize(BddCache *cache, int newsize)
 {
-   int n;
-
-   free(cache->table);
-
-   newsize = bdd_prime_gte(newsize);
-   
-   if ((cache->table=NEW(BddCacheData,newsize)) == NULL)
+   if (BddCache_setsize(cache, newsize) < 0)
       return bdd_error(BDD_MEMORY);
-   
-   for (n=0 ; n<newsize ; n++)
-      cache->table[n].a = -1;
-   cache->tablesize = newsize;
-   
    return 0;
 }
 
@@ -94,4 +165,68 @@ void BddCache_reset(BddCache *cache)
 }
 
 
+void BddCache_clean(BddCache *cache, BddCacheKeep keep)
+{
+   register int n;
+   for (n=0 ; n<cache->tablesize ; n++)
+      if (cache->table[n].a >= 0  &&  !keep(&cache->table[n]))
+	 cache->table[n].a = -1;
+}
+
+
+   /* Adds the counts since the last call to the totals and clears them */
+void BddCache_sumcount(BddCache *cache)
+{
+   cache->sumhits += cache->hits;
+   cache->summisses += cache->misses;
+   cache->sumoverwrites += cache->overwrites;
+   cache->hits = cache->misses = cache->overwrites = 0;
+}
+
+
+#ifdef BDD_THREADS
+
+/* Entries are protected by a sequence number which is odd while the entry
+   is written. Readers never wait - they copy the entry and report a miss
+   if the sequence number changed meanwhile. Writers skip the update if
+   another writer holds the entry. */
+
+int BddCache_parread(BddCache *cache, bddhashval hash, BddCacheData *res)
+{
+   int n = (int)BddCache_index(cache, hash);
+   volatile unsigned int *seq = &cache->seq[n];
+   unsigned int s = *seq;
+
+   if (s & 0x1)
+      return 0;
+   __sync_synchronize();
+   *res = cache->table[n];
+   __sync_synchronize();
+   
+   return *seq == s;
+}
+
+
+void BddCache_parwrite(BddCache *cache, bddhashval hash,
+		       BDD a, BDD b, BDD c, BDD res)
+{
+   int n = (int)BddCache_index(cache, hash);
+   volatile unsigned int *seq = &cache->seq[n];
+   unsigned int s = *seq;
+   BddCacheData *entry = &cache->table[n];
+
+   if ((s & 0x1)  ||  !__sync_bool_compare_and_swap(seq, s, s+1))
+      return;
+
+   entry->a = a;
+   entry->b = b;
+   entry->c = c;
+   entry->r.res = res;
+   __sync_synchronize();
+   *seq = s+2;
+}
+
+#endif /* BDD_THREADS */
+
+
 /* EOF */
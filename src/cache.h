@@ -38,30 +38,194 @@
 #ifndef _CACHE_H
 #define _CACHE_H
 
+#include <string.h>
+
+#ifdef PACKED_CACHE
+
+   /* Packed entries of four words (16 bytes with 32 bit node indices).
+      The operator ids already fit in c, so the only thing to save is the
+      double result of the counting functions. It is kept in place of b and
+      r, which these functions do not use, and must be accessed through
+      BddCache_getdouble() and BddCache_setdouble(). */
+typedef struct
+{
+   BDD a,c,b;
+   union
+   {
+      BDD res;
+   } r;
+} BddCacheData;
+
+#define BddCache_getdouble(e,d) memcpy(&(d), &(e)->b, sizeof(double))
+#define BddCache_setdouble(e,d) memcpy(&(e)->b, &(d), sizeof(double))
+
+#else
+
 typedef struct
 {
    union
    {
       double dres;
-      int res;
+      BDD res;
    } r;
-   int a,b,c;
+   BDD a,b,c;
 } BddCacheData;
 
+#define BddCache_getdouble(e,d) ((d) = (e)->r.dres)
+#define BddCache_setdouble(e,d) ((e)->r.dres = (d))
+
+#endif /* PACKED_CACHE */
+
 
 typedef struct
 {
    BddCacheData *table;
    int tablesize;
+#ifdef PACKED_CACHE
+   bddhashval mask;       /* tablesize-1 */
+#endif
+#ifdef BDD_THREADS
+   unsigned int *seq;     /* Sequence locks for parallel operations */
+#endif
+   long unsigned int hits;        /* Lookups that found their entry */
+   long unsigned int misses;      /* Lookups that did not */
+   long unsigned int overwrites;  /* Misses that will evict another entry */
+   long unsigned int sumhits;     /* Totals of the above counts since the */
+   long unsigned int summisses;   /* cache was created, not including the */
+   long unsigned int sumoverwrites; /* counts not yet summed up */
+   long unsigned int resizes;     /* Number of times the size changed */
 } BddCache;
 
+   /* Tells whether an entry may stay in the cache */
+typedef int (*BddCacheKeep)(BddCacheData *);
+
 
 extern int  BddCache_init(BddCache *, int);
 extern void BddCache_done(BddCache *);
 extern int  BddCache_resize(BddCache *, int);
+extern int  BddCache_setsize(BddCache *, int);
+extern int  BddCache_size(int);
+extern int  BddCache_fit(int);
 extern void BddCache_reset(BddCache *);
+extern void BddCache_clean(BddCache *, BddCacheKeep);
+extern void BddCache_sumcount(BddCache *);
+
+#ifdef PACKED_CACHE
+
+   /* Power-of-two caches are indexed by the low bits of the hash, so it is
+      mixed first to make all bits depend on the whole key (the finalizer
+      of MurmurHash3). */
+static inline bddhashval BddCache_mix(bddhashval h)
+{
+#ifdef BDD_INDEX64
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+   h *= 0xc4ceb9fe1a85ec53ULL;
+   h ^= h >> 33;
+#else
+   h ^= h >> 16;
+   h *= 0x85ebca6bU;
+   h ^= h >> 13;
+   h *= 0xc2b2ae35U;
+   h ^= h >> 16;
+#endif
+   return h;
+}
+
+#ifdef ASSOC_CACHE
+#define BddCache_index(cache, hash) \
+   (BddCache_mix(hash) & (cache)->mask & ~(bddhashval)1)
+#else
+#define BddCache_index(cache, hash) (BddCache_mix(hash) & (cache)->mask)
+#endif
+#else
+#ifdef ASSOC_CACHE
+#define BddCache_index(cache, hash) \
+   (((hash) % (bddhashval)((cache)->tablesize >> 1)) << 1)
+#else
+#define BddCache_index(cache, hash) ((hash) % (cache)->tablesize)
+#endif
+#endif /* PACKED_CACHE */
+
+#define BddCache_lookup(cache, hash) (&(cache)->table[BddCache_index(cache, hash)])
+
+#ifdef ASSOC_CACHE
+
+   /* Two-way set associative caches. The entries 2n and 2n+1 form a set
+      and BddCache_index() gives the first of them. The first way always
+      holds the most recently used entry, which makes the order of the two
+      ways the recency bit: a hit in the second way swaps them and a miss
+      moves the first entry to the second way, evicting the older one, and
+      returns the first way to be filled in. The lookups take the key of
+      the entry, with and without the b field. Parallel operations use the
+      first way only, as a direct mapped cache. */
+static inline BddCacheData *BddCache_way(BddCacheData *e, int hit)
+{
+   BddCacheData tmp;
+
+   if (hit)
+   {
+      tmp = e[0];
+      e[0] = e[1];
+      e[1] = tmp;
+   }
+   else if (e[0].a >= 0)
+   {
+      int evict = e[1].a >= 0;
+      e[1] = e[0];
+      if (!evict)
+	 e[0].a = -1;
+   }
+   return e;
+}
+
+static inline BddCacheData *BddCache_lookup3(BddCache *cache, bddhashval hash,
+					     BDD a, BDD b, BDD c)
+{
+   BddCacheData *e = BddCache_lookup(cache, hash);
+   if (e[0].a == a  &&  e[0].b == b  &&  e[0].c == c)
+      return e;
+   return BddCache_way(e, e[1].a == a  &&  e[1].b == b  &&  e[1].c == c);
+}
+
+static inline BddCacheData *BddCache_lookup2(BddCache *cache, bddhashval hash,
+					     BDD a, BDD c)
+{
+   BddCacheData *e = BddCache_lookup(cache, hash);
+   if (e[0].a == a  &&  e[0].c == c)
+      return e;
+   return BddCache_way(e, e[1].a == a  &&  e[1].c == c);
+}
+
+   /* For entries that keep part of the key in the result field */
+static inline BddCacheData *BddCache_lookup3r(BddCache *cache, bddhashval hash,
+					      BDD a, BDD b, BDD res)
+{
+   BddCacheData *e = BddCache_lookup(cache, hash);
+   if (e[0].a == a  &&  e[0].b == b  &&  e[0].r.res == res)
+      return e;
+   return BddCache_way(e, e[1].a == a  &&  e[1].b == b  &&  e[1].r.res == res);
+}
+
+#else
+
+#define BddCache_lookup3(cache, hash, a, b, c) BddCache_lookup(cache, hash)
+#define BddCache_lookup2(cache, hash, a, c) BddCache_lookup(cache, hash)
+#define BddCache_lookup3r(cache, hash, a, b, res) BddCache_lookup(cache, hash)
+
+#endif /* ASSOC_CACHE */
+
+   /* Counting of lookups for the adaptive cache sizes. A miss on a used
+      entry means that the entry is about to be overwritten. */
+#define BddCache_hit(cache) ((cache)->hits++)
+#define BddCache_miss(cache, entry) \
+   ((cache)->misses++, (cache)->overwrites += ((entry)->a >= 0))
 
-#define BddCache_lookup(cache, hash) (&(cache)->table[hash % (cache)->tablesize])
+#ifdef BDD_THREADS
+extern int  BddCache_parread(BddCache *, bddhashval, BddCacheData *);
+extern void BddCache_parwrite(BddCache *, bddhashval, BDD, BDD, BDD, BDD);
+#endif
 
 
 #endif /* _CACHE_H */
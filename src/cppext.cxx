@@ -37,8 +37,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <iomanip>
+#include "config.h"
 #include "kernel.h"
 #include "bvec.h"
+#include "image.h"
 
 using namespace std;
 
@@ -61,16 +63,20 @@ const bdd bddtruepp = bdd_true();
 const bdd bddfalsepp = bdd_false();
 
    /* Internal prototypes */
-static void bdd_printset_rec(ostream&, int, int*);
-static void bdd_printdot_rec(ostream&, int);
-static void fdd_printset_rec(ostream &, int, int *);
+static void bdd_printset_rec(ostream&, BDD, int*);
+static void bdd_printdot_rec(ostream&, BDD);
+static void fdd_printset_rec(ostream &, BDD, int *);
 
 
 static bddstrmhandler strmhandler_bdd;
 static bddstrmhandler strmhandler_fdd;
 
-   // Avoid calling C++ version of anodecount
+   // Avoid calling C++ version of anodecount, anodeprofile, compact and
+   // newimage
 #undef bdd_anodecount
+#undef bdd_anodeprofile
+#undef bdd_compact
+#undef bdd_newimage
 
 /*************************************************************************
   Setup (and shutdown)
@@ -124,10 +130,10 @@ int bdd_setbddpairs(bddPair *pair, int *oldvar, const bdd *newvar, int size)
 }
 
 
-int bdd_anodecountpp(const bdd *r, int num)
+BDD bdd_anodecountpp(const bdd *r, int num)
 {
    BDD *cpr = NEW(BDD,num);
-   int cou;
+   BDD cou;
    int n;
 
       // No need for ref.cou. since r[n] holds the reference
@@ -141,29 +147,171 @@ int bdd_anodecountpp(const bdd *r, int num)
    return cou;
 }
 
+
+BDD bdd_anodeprofilepp(const bdd *r, int num, bddRootProfile *prof,
+		       BDD *levels, BDD *shared)
+{
+   BDD *cpr = NEW(BDD,num);
+   BDD cou;
+   int n;
+
+   if (cpr == NULL  &&  num > 0)
+      return bdd_error(BDD_MEMORY);
+   
+   for (n=0 ; n<num ; n++)
+      cpr[n] = r[n].root;
+
+   cou = bdd_anodeprofile(cpr, num, prof, levels, shared);
+   
+   free(cpr);
+
+   return cou;
+}
+
+
+bdd bdd_apply_npp(const bdd *r, int num, int op)
+{
+   BDD *cpr = NEW(BDD,num);
+   BDD res;
+   int n;
+
+   if (cpr == NULL  &&  num > 0)
+   {
+      bdd_error(BDD_MEMORY);
+      return bddfalse;
+   }
+   
+   for (n=0 ; n<num ; n++)
+      cpr[n] = r[n].root;
+
+   res = bdd_apply_n(cpr, num, op);
+   
+   free(cpr);
+
+   return res;
+}
+
+
+bdd bdd_appex_npp(const bdd *r, int num, const bdd &var)
+{
+   BDD *cpr = NEW(BDD,num);
+   BDD res;
+   int n;
+
+   if (cpr == NULL  &&  num > 0)
+   {
+      bdd_error(BDD_MEMORY);
+      return bddfalse;
+   }
+   
+   for (n=0 ; n<num ; n++)
+      cpr[n] = r[n].root;
+
+   res = bdd_appex_n(cpr, num, var.root);
+   
+   free(cpr);
+
+   return res;
+}
+
+
+bddImage *bdd_newimagepp(const bdd *part, int num, int kind, int *curvar,
+			 int *nextvar, int varnum, int threshold)
+{
+   BDD *cpr = NEW(BDD,num);
+   bddImage *img;
+   int n;
+
+   if (cpr == NULL  &&  num > 0)
+   {
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+   
+   for (n=0 ; n<num ; n++)
+      cpr[n] = part[n].root;
+
+   img = bdd_newimage(cpr, num, kind, curvar, nextvar, varnum, threshold);
+   
+   free(cpr);
+
+   return img;
+}
+
+
+int bdd_compactpp(bdd *r, int num)
+{
+   BDD *cpr = NEW(BDD,num);
+   int e;
+   int n;
+
+   if (cpr == NULL  &&  num > 0)
+      return bdd_error(BDD_MEMORY);
+   
+      // The nodes are moved with their reference counts, so the objects
+      // just get the new numbers
+   for (n=0 ; n<num ; n++)
+      cpr[n] = r[n].root;
+
+   if ((e=bdd_compact(cpr,num)) == 0)
+      for (n=0 ; n<num ; n++)
+	 r[n].root = cpr[n];
+   
+   free(cpr);
+
+   return e;
+}
+
 /*************************************************************************
   BDD class functions
 *************************************************************************/
 
+   // Makes the manager of an object current while it lives. A NULL
+   // manager, as used for constants and empty vectors, is not selected.
+class managerswitch
+{
+ public:
+   managerswitch(bddManager *m) { old=(m == NULL ? NULL : bdd_setmanager(m)); }
+   ~managerswitch(void)          { if (old != NULL) bdd_setmanager(old); }
+ private:
+   bddManager *old;
+};
+
+
+void bdd::otherref(int inc) const
+{
+   managerswitch use(mgr);
+
+   if (inc > 0)
+      bdd_addref(root);
+   else
+      bdd_delref(root);
+}
+
+
 bdd bdd::operator=(const bdd &r)
 {
-   if (root != r.root)
+   if (root != r.root  ||  mgr != r.mgr)
    {
-      bdd_delref(root);
+      delref();
       root = r.root;
-      bdd_addref(root);
+      mgr = r.mgr;
+      addref();
    }
    return *this;
 }
 
 
-bdd bdd::operator=(int r)
+bdd bdd::operator=(BDD r)
 {
-   if (root != r)
+   bddManager *m = managerof(r);
+   
+   if (root != r  ||  mgr != m)
    {
-      bdd_delref(root);
+      delref();
       root = r;
-      bdd_addref(root);
+      mgr = m;
+      addref();
    }
    return *this;
 }
@@ -237,12 +385,12 @@ ostream &operator<<(ostream &o, const bdd &r)
       
       bdd_mark(r.root);
 
-      for (int n=0 ; n<bddnodesize ; n++)
+      for (BDD n=0 ; n<bddnodesize ; n++)
       {
-	 if (LEVEL(n) & MARKON)
-	 {
-	    BddNode *node = &bddnodes[n];
+	 BddNode *node = &bddnodes[n];
 	 
+	 if (LEVELp(node) & MARKON)
+	 {
 	    LEVELp(node) &= MARKOFF;
 
 	    o << "[" << setw(5) << n << "] ";
@@ -263,12 +411,22 @@ ostream &operator<<(ostream &o, const bdd &r)
       o << "digraph G {\n";
       o << "0 [shape=box, label=\"0\", style=filled, shape=box, height=0.3, width=0.3];\n";
       o << "1 [shape=box, label=\"1\", style=filled, shape=box, height=0.3, width=0.3];\n";
+
+      BDD root = r.root;
+#ifdef COMPLEMENT_EDGES
+      if (!ISCONST(root)  &&  ISCOMPL(root))
+      {
+	 o << "root [shape=plaintext, label=\"\"];\n";
+	 o << "root -> " << REGULAR(root) << " [arrowhead=odot];\n";
+	 root = REGULAR(root);
+      }
+#endif
       
-      bdd_printdot_rec(o, r.root);
+      bdd_printdot_rec(o, root);
       
       o << "}\n";
 
-      bdd_unmark(r.root);
+      bdd_unmark(root);
    }
    else
    if (bdd_ioformat::curformat == IOFORMAT_FDDSET)
@@ -330,7 +488,7 @@ ostream &operator<<(ostream &o, const bdd_ioformat &f)
    else
    if (f.format == IOFORMAT_ALL)
    {
-      for (int n=0 ; n<bddnodesize ; n++)
+      for (BDD n=0 ; n<bddnodesize ; n++)
       {
 	 const BddNode *node = &bddnodes[n];
 	 
@@ -352,7 +510,7 @@ ostream &operator<<(ostream &o, const bdd_ioformat &f)
 }
 
 
-static void bdd_printset_rec(ostream& o, int r, int* set)
+static void bdd_printset_rec(ostream& o, BDD r, int* set)
 {
    int n;
    int first;
@@ -395,7 +553,7 @@ static void bdd_printset_rec(ostream& o, int r, int* set)
 }
 
 
-static void bdd_printdot_rec(ostream& o, int r)
+static void bdd_printdot_rec(ostream& o, BDD r)
 {
    if (ISCONST(r) || MARKED(r))
       return;
@@ -406,6 +564,20 @@ static void bdd_printdot_rec(ostream& o, int r)
    else
       o << bddlevel2var[LEVEL(r)];
    o << "\"];\n";
+#ifdef COMPLEMENT_EDGES
+      /* Only the high edge can be complemented - draw it with a circle */
+   o << r << " -> " << LOW(r) << "[style=dotted];\n";
+   if (ISCONST(HIGH(r))  ||  !ISCOMPL(HIGH(r)))
+      o << r << " -> " << HIGH(r) << "[style=filled];\n";
+   else
+      o << r << " -> " << REGULAR(HIGH(r))
+	<< "[style=filled, arrowhead=odot];\n";
+
+   SETMARK(r);
+   
+   bdd_printdot_rec(o, LOW(r));
+   bdd_printdot_rec(o, REGULAR(HIGH(r)));
+#else
    o << r << " -> " << LOW(r) << "[style=dotted];\n";
    o << r << " -> " << HIGH(r) << "[style=filled];\n";
 
@@ -413,10 +585,11 @@ static void bdd_printdot_rec(ostream& o, int r)
    
    bdd_printdot_rec(o, LOW(r));
    bdd_printdot_rec(o, HIGH(r));
+#endif
 }
 
 
-static void fdd_printset_rec(ostream &o, int r, int *set)
+static void fdd_printset_rec(ostream &o, BDD r, int *set)
 {
    int n,m,i;
    int used = 0;
@@ -535,12 +708,29 @@ bddstrmhandler fdd_strm_hook(bddstrmhandler handler)
    bvec functions
 *************************************************************************/
 
+void bvec::copy(const bvec &v)
+{
+   managerswitch use(v.mgr);
+   
+   roots = bvec_copy(v.roots);
+   mgr = v.mgr;
+}
+
+
+void bvec::release(void)
+{
+   managerswitch use(mgr);
+   
+   bvec_free(roots);
+}
+
+
 bvec bvec::operator=(const bvec &src)
 {
    if (&src != this)
    {
-      bvec_free(roots);
-      roots = bvec_copy(src.roots);
+      release();
+      copy(src);
    }
    return *this;
 }
@@ -548,6 +738,8 @@ bvec bvec::operator=(const bvec &src)
 
 void bvec::set(int bitnum, const bdd &b)
 {
+   managerswitch use(mgr);
+   
    bdd_delref(roots.bitvec[bitnum]);
    roots.bitvec[bitnum] = b.root;
    bdd_addref(roots.bitvec[bitnum]);
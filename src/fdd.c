@@ -39,11 +39,12 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include "config.h"
 #include "kernel.h"
 #include "fdd.h"
 
 
-static void fdd_printset_rec(FILE *, int, int *);
+static void fdd_printset_rec(FILE *, BDD, int *);
 
 /*======================================================================*/
 /* NOTE: ALL FDD operations works with LSB in top of the variable order */
@@ -62,12 +63,12 @@ typedef struct s_Domain
 static void Domain_allocate(Domain*, int);
 static void Domain_done(Domain*);
 
-static int    firstbddvar;
-static int    fdvaralloc;         /* Number of allocated domains */
-static int    fdvarnum;           /* Number of defined domains */
-static Domain *domain;            /* Table of domain sizes */
+#define firstbddvar (bddmanager->firstbddvar)
+#define fdvaralloc  (bddmanager->fdvaralloc)  /* Number of allocated domains */
+#define fdvarnum    (bddmanager->fdvarnum)    /* Number of defined domains */
+#define domain      (bddmanager->domain)      /* Table of domain sizes */
 
-static bddfilehandler filehandler;
+#define filehandler (bddmanager->fddfilehandler)
 
 /*************************************************************************
   Domain definition
@@ -270,7 +271,7 @@ int *fdd_vars(int v)
 BDD fdd_ithvar(int var, int val)
 {
    int n;
-   int v=1, tmp;
+   BDD v=1, tmp;
    
    if (!bddrunning)
    {
@@ -527,7 +528,7 @@ void fdd_fprintset(FILE *ofile, BDD r)
 }
 
 
-static void fdd_printset_rec(FILE *ofile, int r, int *set)
+static void fdd_printset_rec(FILE *ofile, BDD r, int *set)
 {
    int n,m,i;
    int used = 0;
@@ -0,0 +1,768 @@
+/*========================================================================
+              Copyright (C) 2026 by the BuDDy contributors
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  $Header$
+  FILE:  image.c
+  DESCR: Image computation with partitioned transition relations
+  DATE:  (C) 2026
+
+  The partitions of a conjunctive relation are ordered greedily with the
+  benefit measure of IWLS95 (Ranjan et al.): prefer the partition that
+  lets most variables be quantified relative to its support and that
+  brings in few new variables. Neighbouring partitions in that order are
+  merged into clusters up to a node threshold and every variable is
+  quantified right after the last cluster that depends on it. The two
+  directions get their own order, clusters and schedule.
+
+  Reachability applies the clusters of a disjunctive relation one at a
+  time. For saturation order the clusters are grouped by top level and
+  saturated from the bottom and up at the level of whole sets, that is
+  without the per node fixed points of Ciardo's saturation algorithm.
+*************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "kernel.h"
+#include "image.h"
+
+   /* Clusters and quantification schedule of one direction */
+typedef struct s_ImageSchedule
+{
+   int num;          /* Number of clusters */
+   BDD *cluster;     /* The clusters in the order they are applied */
+   BDD *quant;       /* Variables quantified after each cluster */
+   BDD first;        /* Variables quantified from the set itself */
+} ImageSchedule;
+
+struct s_bddImage
+{
+   int kind;              /* BDD_IMAGE_CONJ, _DISJ or _EVENT */
+   ImageSchedule dir[2];  /* For bdd_image and for bdd_preimage */
+   bddPair *tocur;        /* Next state to current state variables */
+   bddPair *tonext;       /* Current state to next state variables */
+};
+
+
+/*************************************************************************
+  Scheduling
+*************************************************************************/
+
+   /* Sets sup[v] for the variables v in the support of r */
+static void image_support(BDD r, char *sup)
+{
+   BDD s = bdd_support(r);
+   
+   memset(sup, 0, bddvarnum);
+   while (!ISCONST(s))
+   {
+      sup[bddlevel2var[LEVEL(s)]] = 1;
+      s = HIGH(s);
+   }
+}
+
+
+   /* Orders the conjunctive partitions for quantification of the
+      variables in q. Returns -1 if out of memory. */
+static int image_order(int num, char *sup, const char *q, int *order)
+{
+   int *occur = NEW(int, bddvarnum);
+   char *seen = NEW(char, bddvarnum);
+   char *done = NEW(char, num);
+   int step, c, v;
+
+   if (occur == NULL  ||  seen == NULL  ||  done == NULL)
+   {
+      free(occur);
+      free(seen);
+      free(done);
+      return bdd_error(BDD_MEMORY);
+   }
+   memset(occur, 0, sizeof(int)*bddvarnum);
+   memset(seen, 0, bddvarnum);
+   memset(done, 0, num);
+
+   for (c=0 ; c<num ; c++)
+      for (v=0 ; v<bddvarnum ; v++)
+	 occur[v] += sup[c*bddvarnum+v];
+
+   for (step=0 ; step<num ; step++)
+   {
+      double bestscore = 0.0;
+      int best = -1;
+      
+      for (c=0 ; c<num ; c++)
+      {
+	 char *s = sup + c*bddvarnum;
+	 int quantnum = 0, supnum = 0, newnum = 0;
+	 double score;
+
+	 if (done[c])
+	    continue;
+	 
+	 for (v=0 ; v<bddvarnum ; v++)
+	    if (s[v])
+	    {
+	       supnum++;
+	       if (q[v]  &&  occur[v] == 1)
+		  quantnum++;
+	       else if (!q[v]  &&  !seen[v])
+		  newnum++;
+	    }
+
+	 score = (2.0*quantnum - newnum) / MAX(supnum,1);
+	 if (best < 0  ||  score > bestscore)
+	 {
+	    best = c;
+	    bestscore = score;
+	 }
+      }
+
+      order[step] = best;
+      done[best] = 1;
+      for (v=0 ; v<bddvarnum ; v++)
+	 if (sup[best*bddvarnum+v])
+	 {
+	    occur[v]--;
+	    seen[v] = 1;
+	 }
+   }
+
+   free(occur);
+   free(seen);
+   free(done);
+   return 0;
+}
+
+
+   /* Merges neighbouring partitions in the given order as long as the
+      clusters have no more than threshold nodes. Returns the number of
+      clusters, which are referenced. */
+static int image_cluster(BDD *part, int num, int *order, int kind,
+			 int threshold, BDD *cluster)
+{
+   BDD cur;
+   int cnum = 0;
+   int n;
+
+   if (num <= 0)
+      return 0;
+   
+   cur = bdd_addref(part[order[0]]);
+   for (n=1 ; n<num ; n++)
+   {
+      BDD next = part[order[n]];
+      
+      if (threshold > 0)
+      {
+	 BDD tmp = bdd_addref(kind == BDD_IMAGE_CONJ ?
+			      bdd_and(cur, next) : bdd_or(cur, next));
+	 if (bdd_nodecount(tmp) <= threshold)
+	 {
+	    bdd_delref(cur);
+	    cur = tmp;
+	    continue;
+	 }
+	 bdd_delref(tmp);
+      }
+      
+      cluster[cnum++] = cur;
+      cur = bdd_addref(next);
+   }
+   cluster[cnum++] = cur;
+
+   return cnum;
+}
+
+
+   /* Makes the clusters and the schedule for quantification of the
+      variables in q. Partner maps a state variable to its other copy. */
+static int image_schedule(ImageSchedule *sch, BDD *part, int num, int kind,
+			  const char *q, const int *partner, int threshold)
+{
+   int *order = NEW(int, num+1);
+   int *last = NEW(int, bddvarnum);
+   int *vars = NEW(int, bddvarnum);
+   char *sup = NEW(char, (num+1)*bddvarnum);
+   int err = 0;
+   int n, v, varnum;
+
+   sch->num = 0;
+   sch->cluster = NEW(BDD, num+1);
+   sch->quant = NEW(BDD, num+1);
+   sch->first = bdd_addref(bddtrue);
+
+   if (order == NULL  ||  last == NULL  ||  vars == NULL  ||  sup == NULL  ||
+       sch->cluster == NULL  ||  sch->quant == NULL)
+   {
+      err = bdd_error(BDD_MEMORY);
+      goto done;
+   }
+
+   for (n=0 ; n<num ; n++)
+      order[n] = n;
+
+      /* An event quantifies the variables of its own support */
+   if (kind == BDD_IMAGE_EVENT)
+   {
+      for (n=0 ; n<num ; n++)
+      {
+	 image_support(part[n], sup);
+	 for (v=varnum=0 ; v<bddvarnum ; v++)
+	    if (q[v]  &&  (sup[v]  ||  sup[partner[v]]))
+	       vars[varnum++] = v;
+	 sch->cluster[n] = bdd_addref(part[n]);
+	 sch->quant[n] = bdd_addref(bdd_makeset(vars, varnum));
+	 sch->num = n+1;
+      }
+      goto done;
+   }
+   
+   if (kind == BDD_IMAGE_CONJ)
+   {
+      for (n=0 ; n<num ; n++)
+	 image_support(part[n], sup + n*bddvarnum);
+      if ((err=image_order(num, sup, q, order)) < 0)
+	 goto done;
+   }
+
+   sch->num = image_cluster(part, num, order, kind, threshold, sch->cluster);
+
+      /* A disjunctive cluster quantifies all variables on its own */
+   if (kind == BDD_IMAGE_DISJ)
+   {
+      for (v=varnum=0 ; v<bddvarnum ; v++)
+	 if (q[v])
+	    vars[varnum++] = v;
+      for (n=0 ; n<sch->num ; n++)
+	 sch->quant[n] = bdd_addref(bdd_makeset(vars, varnum));
+      goto done;
+   }
+   
+   for (v=0 ; v<bddvarnum ; v++)
+      last[v] = -1;
+   for (n=0 ; n<sch->num ; n++)
+   {
+      image_support(sch->cluster[n], sup);
+      for (v=0 ; v<bddvarnum ; v++)
+	 if (sup[v])
+	    last[v] = n;
+   }
+
+   for (n=-1 ; n<sch->num ; n++)
+   {
+      for (v=varnum=0 ; v<bddvarnum ; v++)
+	 if (q[v]  &&  last[v] == n)
+	    vars[varnum++] = v;
+      if (n < 0)
+      {
+	 bdd_delref(sch->first);
+	 sch->first = bdd_addref(bdd_makeset(vars, varnum));
+      }
+      else
+	 sch->quant[n] = bdd_addref(bdd_makeset(vars, varnum));
+   }
+   
+ done:
+   free(order);
+   free(last);
+   free(vars);
+   free(sup);
+   return err;
+}
+
+
+static void image_unschedule(ImageSchedule *sch)
+{
+   int n;
+
+   for (n=0 ; n<sch->num ; n++)
+   {
+      bdd_delref(sch->cluster[n]);
+      bdd_delref(sch->quant[n]);
+   }
+   bdd_delref(sch->first);
+   free(sch->cluster);
+   free(sch->quant);
+   sch->num = 0;
+}
+
+
+/*************************************************************************
+  Partitioned relations
+*************************************************************************/
+
+bddImage *bdd_newimage(BDD *part, int num, int kind, int *curvar,
+		       int *nextvar, int varnum, int threshold)
+{
+   bddImage *img;
+   char *q;
+   int *partner;
+   int n;
+
+   for (n=0 ; n<num ; n++)
+      CHECKa(part[n], NULL);
+   if (num < 0  ||  varnum < 0  ||
+       kind < BDD_IMAGE_CONJ  ||  kind > BDD_IMAGE_EVENT)
+   {
+      bdd_error(BDD_RANGE);
+      return NULL;
+   }
+   for (n=0 ; n<varnum ; n++)
+      if (curvar[n] < 0  ||  curvar[n] >= bddvarnum  ||
+	  nextvar[n] < 0  ||  nextvar[n] >= bddvarnum)
+      {
+	 bdd_error(BDD_VAR);
+	 return NULL;
+      }
+
+   img = NEW(bddImage,1);
+   q = NEW(char,bddvarnum);
+   partner = NEW(int,bddvarnum);
+   if (img == NULL  ||  q == NULL  ||  partner == NULL)
+   {
+      free(img);
+      free(q);
+      free(partner);
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+   img->kind = kind;
+   img->tocur = bdd_newpair();
+   img->tonext = bdd_newpair();
+   if (img->tocur == NULL  ||  img->tonext == NULL  ||
+       bdd_setpairs(img->tocur, nextvar, curvar, varnum) < 0  ||
+       bdd_setpairs(img->tonext, curvar, nextvar, varnum) < 0)
+   {
+      if (img->tocur != NULL)
+	 bdd_freepair(img->tocur);
+      if (img->tonext != NULL)
+	 bdd_freepair(img->tonext);
+      free(img);
+      free(q);
+      free(partner);
+      return NULL;
+   }
+
+      /* Variables outside the state map to a variable never quantified */
+   for (n=0 ; n<bddvarnum ; n++)
+      partner[n] = n;
+   for (n=0 ; n<varnum ; n++)
+   {
+      partner[curvar[n]] = nextvar[n];
+      partner[nextvar[n]] = curvar[n];
+   }
+   
+   memset(q, 0, bddvarnum);
+   for (n=0 ; n<varnum ; n++)
+      q[curvar[n]] = 1;
+   if (image_schedule(&img->dir[0], part, num, kind, q, partner,
+		      threshold) < 0)
+   {
+      img->dir[1].num = 0;
+      img->dir[1].cluster = img->dir[1].quant = NULL;
+      img->dir[1].first = bddtrue;
+      bdd_freeimage(img);
+      free(q);
+      free(partner);
+      return NULL;
+   }
+   
+   memset(q, 0, bddvarnum);
+   for (n=0 ; n<varnum ; n++)
+      q[nextvar[n]] = 1;
+   if (image_schedule(&img->dir[1], part, num, kind, q, partner,
+		      threshold) < 0)
+   {
+      bdd_freeimage(img);
+      free(q);
+      free(partner);
+      return NULL;
+   }
+
+   free(q);
+   free(partner);
+   return img;
+}
+
+
+void bdd_freeimage(bddImage *img)
+{
+   if (img == NULL)
+      return;
+   
+   image_unschedule(&img->dir[0]);
+   image_unschedule(&img->dir[1]);
+   bdd_freepair(img->tocur);
+   bdd_freepair(img->tonext);
+   free(img);
+}
+
+
+int bdd_imageclusters(bddImage *img, int dir)
+{
+   if (img == NULL  ||  dir < 0  ||  dir > 1)
+      return bdd_error(BDD_RANGE);
+   return img->dir[dir].num;
+}
+
+
+   /* Conjoins s with the clusters of sch and quantifies by the schedule,
+      or for a disjunctive relation joins the quantified conjunctions of
+      s with each cluster. The result is referenced and for events it is
+      already in current state variables. */
+static BDD image_apply(bddImage *img, ImageSchedule *sch, BDD s)
+{
+   BDD res, tmp;
+   int n;
+
+   if (img->kind != BDD_IMAGE_CONJ)
+   {
+      res = bdd_addref(bddfalse);
+      for (n=0 ; n<sch->num ; n++)
+      {
+	 BDD part = bdd_addref(bdd_appex(s, sch->cluster[n], bddop_and,
+					 sch->quant[n]));
+
+	    /* An event leaves next state variables of its own support,
+	       which may be current state variables of other events */
+	 if (img->kind == BDD_IMAGE_EVENT)
+	 {
+	    tmp = bdd_addref(bdd_replace(part, img->tocur));
+	    bdd_delref(part);
+	    part = tmp;
+	 }
+	 tmp = bdd_addref(bdd_or(res, part));
+	 bdd_delref(part);
+	 bdd_delref(res);
+	 res = tmp;
+      }
+      return res;
+   }
+   
+   res = bdd_addref(bdd_exist(s, sch->first));
+   for (n=0 ; n<sch->num ; n++)
+   {
+      tmp = bdd_addref(bdd_appex(res, sch->cluster[n], bddop_and,
+				 sch->quant[n]));
+      bdd_delref(res);
+      res = tmp;
+   }
+   return res;
+}
+
+
+BDD bdd_image(bddImage *img, BDD s)
+{
+   BDD tmp, res;
+   
+   CHECKa(s, bddfalse);
+   if (img == NULL)
+   {
+      bdd_error(BDD_RANGE);
+      return bddfalse;
+   }
+
+   tmp = image_apply(img, &img->dir[0], s);
+   if (img->kind == BDD_IMAGE_EVENT)
+   {
+      bdd_delref(tmp);
+      return tmp;
+   }
+   res = bdd_replace(tmp, img->tocur);
+   bdd_delref(tmp);
+   return res;
+}
+
+
+BDD bdd_preimage(bddImage *img, BDD s)
+{
+   BDD next, res;
+   
+   CHECKa(s, bddfalse);
+   if (img == NULL)
+   {
+      bdd_error(BDD_RANGE);
+      return bddfalse;
+   }
+
+   next = bdd_addref(bdd_replace(s, img->tonext));
+   res = image_apply(img, &img->dir[1], next);
+   bdd_delref(next);
+   bdd_delref(res);
+   return res;
+}
+
+
+/*************************************************************************
+  Reachability
+*************************************************************************/
+
+   /* State of one call to bdd_reachable */
+typedef struct s_ReachState
+{
+   bddImage *img;
+   int evnum;                /* Number of events */
+   int *order;               /* Events sorted with the lowest level first */
+   BDD *seen;                /* The set each event was last applied to */
+   bddreachhandler handler;
+   bddReachStat stat;
+} ReachState;
+
+
+   /* The image of s by event n alone, or by the whole relation if it is
+      conjunctive. The result is referenced. */
+static BDD reach_image(ReachState *rs, int n, BDD s)
+{
+   ImageSchedule *sch = &rs->img->dir[0];
+   BDD tmp, res, size;
+
+   if (rs->img->kind == BDD_IMAGE_CONJ)
+      tmp = image_apply(rs->img, sch, s);
+   else
+      tmp = bdd_addref(bdd_appex(s, sch->cluster[n], bddop_and,
+				 sch->quant[n]));
+   res = bdd_addref(bdd_replace(tmp, rs->img->tocur));
+   bdd_delref(tmp);
+
+   rs->stat.images++;
+   if (rs->handler != NULL  &&  (size=bdd_nodecount(res)) > rs->stat.peaksize)
+      rs->stat.peaksize = size;
+   return res;
+}
+
+
+   /* Applies the events order[first..last-1] one at a time to the set r
+      and returns the grown set, referenced. An event is only applied to
+      the states added since it was last applied, as the images of the
+      others are already in the set. */
+static BDD reach_chain(ReachState *rs, int first, int last, BDD r)
+{
+   BDD res = bdd_addref(r);
+   BDD from, next, tmp;
+   int n, e;
+
+   for (n=first ; n<last ; n++)
+   {
+      e = rs->order[n];
+      if (rs->seen[e] == res)
+	 continue;
+      
+      from = bdd_addref(bdd_apply(res, rs->seen[e], bddop_diff));
+      bdd_delref(rs->seen[e]);
+      rs->seen[e] = bdd_addref(res);
+      
+      next = reach_image(rs, e, from);
+      bdd_delref(from);
+      tmp = bdd_addref(bdd_or(res, next));
+      bdd_delref(next);
+      bdd_delref(res);
+      res = tmp;
+   }
+
+   return res;
+}
+
+
+static void reach_begin(ReachState *rs, int level)
+{
+   rs->stat.iteration++;
+   rs->stat.level = level;
+   rs->stat.images = 0;
+   rs->stat.peaksize = 0;
+}
+
+
+static void reach_end(ReachState *rs, BDD r)
+{
+   if (rs->handler == NULL)
+      return;
+   rs->stat.setsize = bdd_nodecount(r);
+   rs->stat.nodenum = bdd_getnodenum();
+   rs->handler(&rs->stat);
+}
+
+
+static BDD reach_bfs(ReachState *rs, BDD init)
+{
+   BDD reached = bdd_addref(init);
+   BDD front = bdd_addref(init);
+   BDD next, tmp;
+   int n;
+
+   while (front != bddfalse)
+   {
+      reach_begin(rs, -1);
+      next = bdd_addref(bddfalse);
+      for (n=0 ; n<rs->evnum ; n++)
+      {
+	 BDD im = reach_image(rs, rs->order[n], front);
+	 tmp = bdd_addref(bdd_or(next, im));
+	 bdd_delref(im);
+	 bdd_delref(next);
+	 next = tmp;
+      }
+
+      bdd_delref(front);
+      front = bdd_addref(bdd_apply(next, reached, bddop_diff));
+      bdd_delref(next);
+      tmp = bdd_addref(bdd_or(reached, front));
+      bdd_delref(reached);
+      reached = tmp;
+      reach_end(rs, reached);
+   }
+
+   bdd_delref(front);
+   return reached;
+}
+
+
+static BDD reach_chaining(ReachState *rs, BDD init)
+{
+   BDD reached = bdd_addref(init);
+   BDD prev;
+
+   do
+   {
+      reach_begin(rs, -1);
+      prev = reached;
+      reached = reach_chain(rs, 0, rs->evnum, prev);
+      bdd_delref(prev);
+      reach_end(rs, reached);
+   }
+   while (reached != prev);
+
+   return reached;
+}
+
+
+   /* Group g of events is order[start[g]..start[g+1]-1], all with the
+      same top level */
+static BDD reach_saturate(ReachState *rs, BDD init)
+{
+   ImageSchedule *sch = &rs->img->dir[0];
+   BDD reached = bdd_addref(init);
+   BDD prev;
+   int *start = NEW(int, rs->evnum+1);
+   int groupnum, g, n;
+
+   if (start == NULL)
+   {
+      bdd_delref(reached);
+      bdd_error(BDD_MEMORY);
+      return bddfalse;
+   }
+
+   for (n=groupnum=0 ; n<rs->evnum ; n++)
+      if (n == 0  ||  LEVEL(sch->cluster[rs->order[n]]) !=
+	  LEVEL(sch->cluster[rs->order[n-1]]))
+	 start[groupnum++] = n;
+   start[groupnum] = rs->evnum;
+
+   g = 0;
+   while (g < groupnum)
+   {
+      reach_begin(rs, LEVEL(sch->cluster[rs->order[start[g]]]));
+      prev = reached;
+      reached = reach_chain(rs, start[g], start[g+1], prev);
+      bdd_delref(prev);
+      reach_end(rs, reached);
+
+	 /* New states may enable the events below this group again */
+      if (reached == prev)
+	 g++;
+      else
+	 g = 0;
+   }
+
+   free(start);
+   return reached;
+}
+
+
+BDD bdd_reachable(bddImage *img, BDD init, int method,
+		  bddreachhandler handler)
+{
+   ImageSchedule *sch;
+   ReachState rs;
+   BDD res;
+   int n, m;
+
+   CHECKa(init, bddfalse);
+   if (img == NULL  ||  method < BDD_REACH_BFS  ||  method > BDD_REACH_SAT)
+   {
+      bdd_error(BDD_RANGE);
+      return bddfalse;
+   }
+
+   sch = &img->dir[0];
+   memset(&rs, 0, sizeof(ReachState));
+   rs.img = img;
+   rs.handler = handler;
+   rs.evnum = (img->kind == BDD_IMAGE_CONJ ? 1 : sch->num);
+   rs.order = NEW(int, rs.evnum+1);
+   rs.seen = NEW(BDD, rs.evnum+1);
+   if (rs.order == NULL  ||  rs.seen == NULL)
+   {
+      free(rs.order);
+      free(rs.seen);
+      bdd_error(BDD_MEMORY);
+      return bddfalse;
+   }
+
+      /* Lowest level first, that is the deepest top variable first */
+   for (n=0 ; n<rs.evnum ; n++)
+   {
+      for (m=n ; m>0 && img->kind != BDD_IMAGE_CONJ ; m--)
+      {
+	 if (LEVEL(sch->cluster[rs.order[m-1]]) >= LEVEL(sch->cluster[n]))
+	    break;
+	 rs.order[m] = rs.order[m-1];
+      }
+      rs.order[m] = n;
+      rs.seen[n] = bddfalse;
+   }
+
+   if (method == BDD_REACH_BFS  ||  img->kind == BDD_IMAGE_CONJ)
+      res = reach_bfs(&rs, init);
+   else if (method == BDD_REACH_CHAIN)
+      res = reach_chaining(&rs, init);
+   else
+      res = reach_saturate(&rs, init);
+
+   for (n=0 ; n<rs.evnum ; n++)
+      bdd_delref(rs.seen[n]);
+   free(rs.order);
+   free(rs.seen);
+   bdd_delref(res);
+   return res;
+}
+
+
+/* EOF */
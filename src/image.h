@@ -0,0 +1,243 @@
+/*========================================================================
+              Copyright (C) 2026 by the BuDDy contributors
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  $Header$
+  FILE:  image.h
+  DESCR: Image computation with partitioned transition relations
+  DATE:  (C) 2026
+*************************************************************************/
+
+/** \file image.h
+ */
+
+#ifndef _IMAGE_H
+#define _IMAGE_H
+
+#include "bdd.h"
+
+   /* How the partitions of a transition relation are combined */
+#define BDD_IMAGE_CONJ 0
+#define BDD_IMAGE_DISJ 1
+#define BDD_IMAGE_EVENT 2
+
+   /* Search orders for bdd_reachable */
+#define BDD_REACH_BFS 0
+#define BDD_REACH_CHAIN 1
+#define BDD_REACH_SAT 2
+
+/**
+ * \ingroup image
+ * \brief A partitioned transition relation.
+ *
+ * Made by ::bdd_newimage and released with ::bdd_freeimage.
+ */
+typedef struct s_bddImage bddImage;
+
+/**
+ * \ingroup image
+ *
+ * Statistics of one iteration of ::bdd_reachable.
+ */
+typedef struct s_bddReachStat
+{
+   int iteration;	/**< Number of the iteration, counted from one. */
+   int level;		/**< Top level of the events applied, or -1 for all events. */
+   int images;		/**< Number of images calculated in the iteration. */
+   BDD peaksize;	/**< Nodes in the largest of these images. */
+   BDD setsize;		/**< Nodes in the reached set after the iteration. */
+   BDD nodenum;		/**< Nodes in use after the iteration, as from ::bdd_getnodenum. */
+} bddReachStat;
+
+/**
+ * \ingroup image
+ * Data type for iteration handlers for use with ::bdd_reachable.
+ */
+typedef void (*bddreachhandler)(bddReachStat*);
+
+
+#ifdef CPLUSPLUS
+extern "C" {
+#endif
+
+/* In file image.c */
+
+/**
+ * \ingroup image
+ * \brief Makes a partitioned transition relation for image computation.
+ *
+ * The transition relation is given by the \a num partitions in \a part over the
+ * current state variables \a curvar and the next state variables \a nextvar, both
+ * arrays of \a varnum variables where \a nextvar[i] is the next state copy of
+ * \a curvar[i]. With \c BDD_IMAGE_CONJ as \a kind the relation is the conjunction of
+ * the partitions and with \c BDD_IMAGE_DISJ it is their disjunction.
+ *
+ * With \c BDD_IMAGE_EVENT the relation is also the disjunction of the partitions,
+ * but each partition is an event that only constrains the state variables it
+ * depends on. A state variable is in the support of an event when its current or
+ * its next state copy occurs in the partition, and all other state variables keep
+ * their value without any frame condition in the partition. The events are kept
+ * as they are and \a threshold is not used.
+ *
+ * The partitions are first ordered, one direction at a time, so that variables
+ * can be quantified as early as possible (after the IWLS95 heuristic by Ranjan et
+ * al). Neighbouring partitions are then merged into clusters as long as a cluster
+ * has no more than \a threshold nodes. A \a threshold of zero keeps each partition
+ * as it is. Finally each variable to quantify is scheduled right after the last
+ * cluster that depends on it. Disjunctive partitions are clustered in the given
+ * order and each cluster is quantified on its own.
+ *
+ * The relation keeps references to its clusters and must be freed with
+ * ::bdd_freeimage before ::bdd_done is called.
+ * 
+ * \return The new relation or NULL on error.
+ * \see bdd_image, bdd_preimage, bdd_appex
+ */
+extern bddImage *bdd_newimage(BDD *part, int num, int kind, int *curvar,
+			      int *nextvar, int varnum, int threshold);
+
+
+/**
+ * \ingroup image
+ * \brief Frees a partitioned transition relation.
+ *
+ * Releases \a img and the references it holds.
+ * 
+ * \see bdd_newimage
+ */
+extern void      bdd_freeimage(bddImage *img);
+
+
+/**
+ * \ingroup image
+ * \brief The states reachable in one step.
+ *
+ * Calculates the image of the set \a s of current states, that is
+ * \f$(\exists x . s(x) \wedge T(x,y))[y/x]\f$, with one ::bdd_appex for each cluster of
+ * \a img. The result is a set of current states.
+ * 
+ * \return The image of \a s.
+ * \see bdd_preimage, bdd_newimage
+ */
+extern BDD       bdd_image(bddImage *img, BDD s);
+
+
+/**
+ * \ingroup image
+ * \brief The states that reach a set in one step.
+ *
+ * Calculates the preimage of the set \a s of current states, that is
+ * \f$\exists y . s[x/y](y) \wedge T(x,y)\f$, with one ::bdd_appex for each cluster of
+ * \a img.
+ * 
+ * \return The preimage of \a s.
+ * \see bdd_image, bdd_newimage
+ */
+extern BDD       bdd_preimage(bddImage *img, BDD s);
+
+
+/**
+ * \ingroup image
+ * \brief Number of clusters of a partitioned transition relation.
+ *
+ * \return The number of clusters used by ::bdd_image (\a dir = 0) or by
+ * ::bdd_preimage (\a dir = 1) or a negative number on error.
+ * \see bdd_newimage
+ */
+extern int       bdd_imageclusters(bddImage *img, int dir);
+
+
+/**
+ * \ingroup image
+ * \brief The states reachable from a set.
+ *
+ * Calculates the least fixed point of the states reachable from \a init with the
+ * relation \a img. The \a method is one of
+ *
+ * <DL>
+ * <DT>\c BDD_REACH_BFS</DT>
+ * <DD>Breadth-first search. Each iteration joins the images of the frontier by
+ *     all clusters.</DD>
+ * <DT>\c BDD_REACH_CHAIN</DT>
+ * <DD>Chaining. Each iteration applies the clusters one at a time to the reached
+ *     set, which grows in between, until an iteration adds no states.</DD>
+ * <DT>\c BDD_REACH_SAT</DT>
+ * <DD>Saturation order. The clusters are grouped by the top level of their
+ *     relation and the groups are applied from the lowest level in the BDD and
+ *     up. A group is applied until it adds no states, and whenever it has added
+ *     states all groups below it are saturated again before moving up.</DD>
+ * </DL>
+ *
+ * Chaining and saturation need a disjunctive relation or a relation of events and
+ * work best with events that have small supports. A conjunctive relation has
+ * only one event and with it all methods are breadth-first.
+ *
+ * If \a handler is not NULL then it is called after each iteration with the
+ * statistics of that iteration.
+ * 
+ * \return The reachable states or ::bddfalse on errors.
+ * \see bdd_image, bdd_newimage
+ */
+extern BDD       bdd_reachable(bddImage *img, BDD init, int method,
+			       bddreachhandler handler);
+
+#ifdef CPLUSPLUS
+}
+#endif
+
+
+/*************************************************************************
+   If this file is included from a C++ compiler then the following
+   wrappers are supplied.
+*************************************************************************/
+#ifdef CPLUSPLUS
+
+extern bddImage *bdd_newimagepp(const bdd *part, int num, int kind,
+				int *curvar, int *nextvar, int varnum,
+				int threshold);
+
+inline bdd bdd_image(bddImage *img, const bdd &s)
+{ return bdd_image(img, s.root); }
+
+inline bdd bdd_preimage(bddImage *img, const bdd &s)
+{ return bdd_preimage(img, s.root); }
+
+inline bdd bdd_reachable(bddImage *img, const bdd &init, int method,
+			 bddreachhandler handler)
+{ return bdd_reachable(img, init.root, method, handler); }
+
+   /* Hack to allow for overloading */
+#define bdd_newimage bdd_newimagepp
+
+#endif /* CPLUSPLUS */
+
+#endif /* _IMAGE_H */
+
+
+/* EOF */
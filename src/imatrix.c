@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include "config.h"
 #include "kernel.h"
 #include "imatrix.h"
 
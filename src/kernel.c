@@ -49,6 +49,7 @@
 #include "kernel.h"
 #include "cache.h"
 #include "prime.h"
+#include "parallel.h"
 
 /*************************************************************************
   Various definitions and global variables
@@ -63,41 +64,57 @@ const BDD bddfalse=0;                    /* The constant false bdd */
 
 /* Min. number of nodes (%) that has to be left after a garbage collect
    unless a resize should be done. */
-static int minfreenodes=20;
+#define bddminfreenodes       (bddmanager->bddminfreenodes)
 
 
-/*=== GLOBAL KERNEL VARIABLES ==========================================*/
-
-int          bddrunning;            /* Flag - package initialized */
-int          bdderrorcond;          /* Some error condition */
-int          bddnodesize;           /* Number of allocated nodes */
-int          bddmaxnodesize;        /* Maximum allowed number of nodes */
-int          bddmaxnodeincrease;    /* Max. # of nodes used to inc. table */
-BddNode*     bddnodes;          /* All of the bdd nodes */
-int          bddfreepos;        /* First free node */
-int          bddfreenum;        /* Number of free nodes */
-long int     bddproduced;       /* Number of new nodes ever produced */
-int          bddvarnum;         /* Number of defined BDD variables */
-int*         bddrefstack;       /* Internal node reference stack */
-int*         bddrefstacktop;    /* Internal node reference stack top */
-int*         bddvar2level;      /* Variable -> level table */
-int*         bddlevel2var;      /* Level -> variable table */
-jmp_buf      bddexception;      /* Long-jump point for interrupting calc. */
-int          bddresized;        /* Flag indicating a resize of the nodetable */
-
-bddCacheStat bddcachestats;
+/*=== PRIVATE KERNEL VARIABLES =========================================*/
 
+   /* Fields of the current manager - see manager.h */
+#define bddvarset             (bddmanager->bddvarset)
+#define gbcollectnum          (bddmanager->gbcollectnum)
+#define bddcachesize          (bddmanager->bddcachesize)
+#define gbcclock              (bddmanager->gbcclock)
+#define usednodes_nextreorder (bddmanager->usednodes_nextreorder)
+#define err_handler           (bddmanager->err_handler)
+#define gbc_handler           (bddmanager->gbc_handler)
+#define resize_handler        (bddmanager->resize_handler)
+#define itermaxdepth          (bddmanager->itermaxdepth)
+
+
+#ifdef COMPACT_NODES
+   /* The node table is kept on a cache line boundary so that four nodes
+      share a line. The raw block (bddnodesmem) is over-allocated by one
+      line and grown with realloc, which lets large tables grow in place;
+      if the alignment offset changes the old nodes are moved down. */
+#define NODEALIGN 64
+
+static BddNode *nodetable_realloc(BddNode *old, BDD oldsize, BDD size)
+{
+   int oldoffset = old ? (char*)old - (char*)bddnodesmem : 0;
+   char *mem, *p;
 
-/*=== PRIVATE KERNEL VARIABLES =========================================*/
+   mem = (char*)realloc(bddnodesmem, sizeof(BddNode)*size + NODEALIGN);
+   if (mem == NULL)
+      return NULL;
+   bddnodesmem = mem;
+   
+   p = mem + (-(size_t)mem & (NODEALIGN-1));
+   if (old != NULL  &&  p != mem+oldoffset)
+      memmove(p, mem+oldoffset, sizeof(BddNode)*oldsize);
+   
+   return (BddNode*)p;
+}
 
-static BDD*     bddvarset;             /* Set of defined BDD variables */
-static int      gbcollectnum;          /* Number of garbage collections */
-static int      cachesize;             /* Size of the operator caches */
-static long int gbcclock;              /* Clock ticks used in GBC */
-static int      usednodes_nextreorder; /* When to do reorder next time */
-static bddinthandler  err_handler;     /* Error handler */
-static bddgbchandler  gbc_handler;     /* Garbage collection handler */
-static bdd2inthandler resize_handler;  /* Node-table-resize handler */
+static void nodetable_free(void)
+{
+   free(bddnodesmem);
+   bddnodesmem = NULL;
+}
+#else
+#define nodetable_realloc(old,oldsize,size) \
+   ((BddNode*)realloc(old, sizeof(BddNode)*(size)))
+#define nodetable_free() free(bddnodes)
+#endif
 
 
    /* Strings for all error mesages */
@@ -132,7 +149,8 @@ static char *errorstrings[BDD_ERRNUM] =
 
 int bdd_init(int initnodesize, int cs)
 {
-   int n, err;
+   BDD n;
+   int err;
    
    srand48( SRAND48SEED ) ;
 
@@ -141,24 +159,34 @@ int bdd_init(int initnodesize, int cs)
    
    bddnodesize = bdd_prime_gte(initnodesize);
    
-   if ((bddnodes=(BddNode*)malloc(sizeof(BddNode)*bddnodesize)) == NULL)
+   if ((bddnodes=nodetable_realloc(NULL, 0, bddnodesize)) == NULL)
       return bdd_error(BDD_MEMORY);
+#ifdef COMPACT_NODES
+   if ((bddhash=NEW(BDD,bddnodesize)) == NULL)
+   {
+      nodetable_free();
+      bddnodes = NULL;
+      return bdd_error(BDD_MEMORY);
+   }
+#endif
 
    bddresized = 0;
    
    for (n=0 ; n<bddnodesize ; n++)
    {
       bddnodes[n].refcou = 0;
-      LOW(n) = -1;
-      bddnodes[n].hash = 0;
-      LEVEL(n) = 0;
+      bddnodes[n].low = -1;
+      HASH(n) = 0;
+      bddnodes[n].level = 0;
       bddnodes[n].next = n+1;
    }
    bddnodes[bddnodesize-1].next = 0;
 
    bddnodes[0].refcou = bddnodes[1].refcou = MAXREF;
-   LOW(0) = HIGH(0) = 0;
-   LOW(1) = HIGH(1) = 1;
+   bddnodes[0].low = bddnodes[0].high = 0;
+#ifndef COMPLEMENT_EDGES
+   bddnodes[1].low = bddnodes[1].high = 1;
+#endif
    
    if ((err=bdd_operator_init(cs)) < 0)
    {
@@ -172,7 +200,7 @@ int bdd_init(int initnodesize, int cs)
    bddvarnum = 0;
    gbcollectnum = 0;
    gbcclock = 0;
-   cachesize = cs;
+   bddcachesize = cs;
    usednodes_nextreorder = bddnodesize;
    bddmaxnodeincrease = DEFAULTMAXNODEINC;
 
@@ -203,18 +231,26 @@ int bdd_init(int initnodesize, int cs)
 void bdd_done(void)
 {
    /*sanitycheck(); FIXME */
+   bdd_par_done();
    bdd_fdd_done();
    bdd_reorder_done();
    bdd_pairs_done();
    
-   free(bddnodes);
+   nodetable_free();
+#ifdef COMPACT_NODES
+   free(bddhash);
+   bddhash = NULL;
+#endif
    free(bddrefstack);
+   free(bddrefext);
    free(bddvarset);
    free(bddvar2level);
    free(bddlevel2var);
    
    bddnodes = NULL;
    bddrefstack = NULL;
+   bddrefext = NULL;
+   bddrefextsize = bddrefextnum = 0;
    bddvarset = NULL;
    bddvar2level = NULL;
    bddlevel2var = NULL;
@@ -287,7 +323,7 @@ int bdd_setvarnum(int num)
 
    if (bddrefstack != NULL)
       free(bddrefstack);
-   bddrefstack = bddrefstacktop = (int*)malloc(sizeof(int)*(num*2+4));
+   bddrefstack = bddrefstacktop = NEW(BDD,num*2+4);
 
    for(bdv=bddvarnum ; bddvarnum < num; bddvarnum++)
    {
@@ -301,8 +337,8 @@ int bdd_setvarnum(int num)
 	 return -bdderrorcond;
       }
       
-      bddnodes[bddvarset[bddvarnum*2]].refcou = MAXREF;
-      bddnodes[bddvarset[bddvarnum*2+1]].refcou = MAXREF;
+      bddnodes[NODE(bddvarset[bddvarnum*2])].refcou = MAXREF;
+      bddnodes[NODE(bddvarset[bddvarnum*2+1])].refcou = MAXREF;
       bddlevel2var[bddvarnum] = bddvarnum;
       bddvar2level[bddvarnum] = bddvarnum;
    }
@@ -364,9 +400,9 @@ bdd2inthandler bdd_resize_hook(bdd2inthandler handler)
 }
 
 
-int bdd_setmaxincrease(int size)
+BDD bdd_setmaxincrease(BDD size)
 {
-   int old = bddmaxnodeincrease;
+   BDD old = bddmaxnodeincrease;
    
    if (size < 0)
       return bdd_error(BDD_SIZE);
@@ -376,11 +412,11 @@ int bdd_setmaxincrease(int size)
 }
 
 
-int bdd_setmaxnodenum(int size)
+BDD bdd_setmaxnodenum(BDD size)
 {
    if (size > bddnodesize  ||  size == 0)
    {
-      int old = bddmaxnodesize;
+      BDD old = bddmaxnodesize;
       bddmaxnodesize = size;
       return old;
    }
@@ -391,23 +427,23 @@ int bdd_setmaxnodenum(int size)
 
 int bdd_setminfreenodes(int mf)
 {
-   int old = minfreenodes;
+   int old = bddminfreenodes;
    
    if (mf<0 || mf>100)
       return bdd_error(BDD_RANGE);
 
-   minfreenodes = mf;
+   bddminfreenodes = mf;
    return old;
 }
 
 
-int bdd_getnodenum(void)
+BDD bdd_getnodenum(void)
 {
    return bddnodesize - bddfreenum;
 }
 
 
-int bdd_getallocnum(void)
+BDD bdd_getallocnum(void)
 {
    return bddnodesize;
 }
@@ -438,23 +474,41 @@ void bdd_stats(bddStat *s)
    s->nodenum = bddnodesize;
    s->maxnodenum = bddmaxnodesize;
    s->freenodes = bddfreenum;
-   s->minfreenodes = minfreenodes;
+   s->minfreenodes = bddminfreenodes;
    s->varnum = bddvarnum;
-   s->cachesize = cachesize;
+   s->cachesize = bddcachesize;
    s->gbcnum = gbcollectnum;
+   s->opdepth = itermaxdepth;
 }
 
 
 
 void bdd_cachestats(bddCacheStat *s)
 {
+   bddCacheUsage usage[BDD_CACHENUM];
+   bddOpStat op[BDD_OPSTATNUM];
+   int n;
+   
    *s = bddcachestats;
+
+      /* The operator caches count their own lookups */
+   bdd_operator_stats(usage, op);
+   s->opHit = s->opMiss = 0;
+   for (n=0 ; n<BDD_CACHENUM ; n++)
+   {
+      s->opHit += usage[n].hits;
+      s->opMiss += usage[n].lookups - usage[n].hits;
+   }
 }
 
 
 void bdd_fprintstat(FILE *ofile)
 {
    bddCacheStat s;
+   bddCacheUsage usage[BDD_CACHENUM];
+   bddOpStat op[BDD_OPSTATNUM];
+   int n;
+   
    bdd_cachestats(&s);
    
    fprintf(ofile, "\nCache statistics\n");
@@ -473,6 +527,25 @@ void bdd_fprintstat(FILE *ofile)
 	   (s.opHit+s.opMiss > 0) ? 
 	   ((float)s.opHit)/((float)s.opHit+s.opMiss) : 0);
    fprintf(ofile, "Swap count =    %ld\n", s.swapCount);
+   
+   bdd_operator_stats(usage, op);
+   fprintf(ofile, "\nOperator caches\n");
+   fprintf(ofile, "---------------\n");
+   fprintf(ofile, "%-8s %10s %12s %6s %12s %7s\n",
+	   "Cache", "Size", "Lookups", "Hit", "Overwrites", "Resizes");
+   for (n=0 ; n<BDD_CACHENUM ; n++)
+      fprintf(ofile, "%-8s %10d %12lu %6.2f %12lu %7lu\n",
+	      usage[n].name, usage[n].size, usage[n].lookups,
+	      usage[n].lookups > 0 ?
+	      ((float)usage[n].hits)/((float)usage[n].lookups) : 0,
+	      usage[n].overwrites, usage[n].resizes);
+   
+   fprintf(ofile, "\nOperator calls\n");
+   fprintf(ofile, "--------------\n");
+   for (n=0 ; n<BDD_OPSTATNUM ; n++)
+      if (op[n].calls > 0)
+	 fprintf(ofile, "%-11s %10lu %10.2f s\n", op[n].name, op[n].calls,
+		 (float)op[n].time/(float)CLOCKS_PER_SEC);
 }
 
 
@@ -482,6 +555,54 @@ void bdd_printstat(void)
 }
 
 
+void bdd_statsnapshot(bddStatSnapshot *s)
+{
+   bdd_stats(&s->kernel);
+   bdd_cachestats(&s->cache);
+   s->gbctime = gbcclock;
+   bdd_operator_stats(s->opcache, s->op);
+}
+
+
+void bdd_fdumpstat(FILE *ofile)
+{
+   bddStatSnapshot s;
+   int n;
+   
+   bdd_statsnapshot(&s);
+
+   fprintf(ofile, "{\"produced\": %ld, \"nodenum\": %lld, "
+	   "\"freenodes\": %lld, \"varnum\": %d, \"gbcnum\": %d, "
+	   "\"gbctime\": %.3f,\n",
+	   s.kernel.produced, (long long)s.kernel.nodenum,
+	   (long long)s.kernel.freenodes, s.kernel.varnum, s.kernel.gbcnum,
+	   (double)s.gbctime/CLOCKS_PER_SEC);
+   fprintf(ofile, " \"unique\": {\"access\": %lu, \"chain\": %lu, "
+	   "\"hit\": %lu, \"miss\": %lu},\n",
+	   s.cache.uniqueAccess, s.cache.uniqueChain,
+	   s.cache.uniqueHit, s.cache.uniqueMiss);
+   fprintf(ofile, " \"swapcount\": %lu,\n", s.cache.swapCount);
+   
+   fprintf(ofile, " \"caches\": [");
+   for (n=0 ; n<BDD_CACHENUM ; n++)
+      fprintf(ofile, "%s\n  {\"name\": \"%s\", \"size\": %d, "
+	      "\"lookups\": %lu, \"hits\": %lu, \"overwrites\": %lu, "
+	      "\"resizes\": %lu}", n > 0 ? "," : "",
+	      s.opcache[n].name, s.opcache[n].size, s.opcache[n].lookups,
+	      s.opcache[n].hits, s.opcache[n].overwrites,
+	      s.opcache[n].resizes);
+   fprintf(ofile, "],\n");
+   
+   fprintf(ofile, " \"operators\": [");
+   for (n=0 ; n<BDD_OPSTATNUM ; n++)
+      fprintf(ofile, "%s\n  {\"name\": \"%s\", \"calls\": %lu, "
+	      "\"time\": %.3f}", n > 0 ? "," : "",
+	      s.op[n].name, s.op[n].calls,
+	      (double)s.op[n].time/CLOCKS_PER_SEC);
+   fprintf(ofile, "]}\n");
+}
+
+
 /*************************************************************************
   Error handler
 *************************************************************************/
@@ -596,8 +717,8 @@ void bdd_default_gbchandler(int pre, bddGbcStat *s)
 {
    if (!pre)
    {
-      printf("Garbage collection #%d: %d nodes / %d free",
-	     s->num, s->nodes, s->freenodes);
+      printf("Garbage collection #%d: %ld nodes / %ld free",
+	     s->num, (long)s->nodes, (long)s->freenodes);
       printf(" / %.1fs / %.1fs total\n",
 	     (float)s->time/(float)(CLOCKS_PER_SEC),
 	     (float)s->sumtime/(float)CLOCKS_PER_SEC);
@@ -607,7 +728,7 @@ void bdd_default_gbchandler(int pre, bddGbcStat *s)
 
 static void bdd_gbc_rehash(void)
 {
-   int n;
+   BDD n;
 
    bddfreepos = 0;
    bddfreenum = 0;
@@ -618,11 +739,11 @@ static void bdd_gbc_rehash(void)
 
       if (LOWp(node) != -1)
       {
-	 register unsigned int hash;
+	 register bddhashval hash;
 
 	 hash = NODEHASH(LEVELp(node), LOWp(node), HIGHp(node));
-	 node->next = bddnodes[hash].hash;
-	 bddnodes[hash].hash = n;
+	 node->next = HASH(hash);
+	 HASH(hash) = n;
       }
       else
       {
@@ -634,10 +755,149 @@ static void bdd_gbc_rehash(void)
 }
 
 
+/*=== REFERENCE COUNT OVERFLOW =========================================*/
+
+/* A node that is referenced MAXREF or more times by INCREF gets an entry
+   in bddrefext with its exact count and refcou stays at MAXREF until the
+   count drops below MAXREF again. bddrefext is an open addressing table
+   indexed by node number. Entries with a zero count are unused but are
+   only removed by the garbage collector. If the table cannot grow the
+   node is pinned as the constants are. */
+
+#define REFEXTMINSIZE 64
+
+static int refext_resize(BDD size)
+{
+   BddRefExt *old = bddrefext;
+   BDD oldsize = bddrefextsize;
+   BDD n;
+
+   if ((bddrefext=NEW(BddRefExt,size)) == NULL)
+   {
+      bddrefext = old;
+      return -1;
+   }
+   memset(bddrefext, 0, sizeof(BddRefExt)*size);
+   bddrefextsize = size;
+   bddrefextnum = 0;
+
+   for (n=0 ; n<oldsize ; n++)
+      if (old[n].count > 0)
+      {
+	 BDD pos = old[n].node & (size-1);
+	 while (bddrefext[pos].node != 0)
+	    pos = (pos+1) & (size-1);
+	 bddrefext[pos] = old[n];
+	 bddrefextnum++;
+      }
+
+   free(old);
+   return 0;
+}
+
+
+static BddRefExt *refext_find(BDD n, int insert)
+{
+   BDD pos = 0;
+
+   if (bddrefextsize > 0)
+   {
+      for (pos = n & (bddrefextsize-1) ; bddrefext[pos].node != 0 ;
+	   pos = (pos+1) & (bddrefextsize-1))
+	 if (bddrefext[pos].node == n)
+	    return &bddrefext[pos];
+   }
+
+   if (!insert)
+      return NULL;
+
+   if (2*(bddrefextnum+1) > bddrefextsize)
+   {
+      if (refext_resize(bddrefextsize == 0 ?
+			REFEXTMINSIZE : 2*bddrefextsize) < 0)
+	 return NULL;
+      for (pos = n & (bddrefextsize-1) ; bddrefext[pos].node != 0 ;
+	   pos = (pos+1) & (bddrefextsize-1))
+	 ;
+   }
+
+   bddrefext[pos].node = n;
+   bddrefext[pos].count = 0;
+   bddrefextnum++;
+   return &bddrefext[pos];
+}
+
+
+   /* Called by INCREF when refcou is MAXREF-1 or MAXREF */
+void bdd_refext_inc(BDD n)
+{
+   BddNode *node = &bddnodes[n];
+   BddRefExt *e;
+
+   if (node->refcou < MAXREF)
+   {
+      if ((e=refext_find(n,1)) != NULL)
+	 e->count = MAXREF;
+      node->refcou = MAXREF;
+   }
+   else if (n >= 2  &&  (e=refext_find(n,0)) != NULL  &&  e->count > 0)
+      e->count++;
+}
+
+
+   /* Called by DECREF when refcou is MAXREF */
+void bdd_refext_dec(BDD n)
+{
+   BddRefExt *e;
+
+   if (n < 2  ||  (e=refext_find(n,0)) == NULL  ||  e->count == 0)
+      return;
+
+   if (--e->count < MAXREF)
+   {
+      bddnodes[n].refcou = (unsigned int)e->count;
+      e->count = 0;
+   }
+}
+
+
+   /* Drop entries of nodes that are no longer saturated - either by
+      DECREF or because the reordering reset their reference counts - and
+      shrink the table to fit the rest. Done after the sweep of bdd_gbc. */
+static void refext_gbc(void)
+{
+   BDD n, live = 0, size = REFEXTMINSIZE;
+
+   for (n=0 ; n<bddrefextsize ; n++)
+   {
+      BddRefExt *e = &bddrefext[n];
+
+      if (e->count > 0  &&  (bddnodes[e->node].refcou != MAXREF  ||
+			    bddnodes[e->node].low == -1))
+	 e->count = 0;
+      if (e->count > 0)
+	 live++;
+   }
+
+   if (live == 0)
+   {
+      free(bddrefext);
+      bddrefext = NULL;
+      bddrefextsize = bddrefextnum = 0;
+      return;
+   }
+
+   while (size < 4*live)
+      size *= 2;
+   if (size < bddrefextsize  ||  bddrefextnum > live)
+      refext_resize(size);
+}
+
+
 void bdd_gbc(void)
 {
-   int *r;
-   int n;
+   BDD *r;
+   BDD n;
    long int c2, c1 = clock();
 
    if (gbc_handler != NULL)
@@ -657,8 +917,8 @@ void bdd_gbc(void)
    for (n=0 ; n<bddnodesize ; n++)
    {
       if (bddnodes[n].refcou > 0)
-	 bdd_mark(n);
-      bddnodes[n].hash = 0;
+	 bdd_mark(EDGE(n));
+      HASH(n) = 0;
    }
    
    bddfreepos = 0;
@@ -670,12 +930,12 @@ void bdd_gbc(void)
 
       if ((LEVELp(node) & MARKON)  &&  LOWp(node) != -1)
       {
-	 register unsigned int hash;
+	 register bddhashval hash;
 
 	 LEVELp(node) &= MARKOFF;
 	 hash = NODEHASH(LEVELp(node), LOWp(node), HIGHp(node));
-	 node->next = bddnodes[hash].hash;
-	 bddnodes[hash].hash = n;
+	 node->next = HASH(hash);
+	 HASH(hash) = n;
       }
       else
       {
@@ -686,7 +946,8 @@ void bdd_gbc(void)
       }
    }
 
-   bdd_operator_reset();
+   refext_gbc();
+   bdd_operator_gbc();
 
    c2 = clock();
    gbcclock += c2-c1;
@@ -705,13 +966,223 @@ void bdd_gbc(void)
 }
 
 
+/* Garbage collect and resize the node table if too few nodes are left
+   free. Used outside of makenode when a parallel operation ran out of
+   free nodes. */
+void bdd_gbc_resize(void)
+{
+   bdd_gbc();
+   
+   if ((bddfreenum*100) / bddnodesize <= bddminfreenodes)
+      bdd_noderesize(1);
+}
+
+
+/*=== COMPACTION =======================================================*/
+
+/* bdd_compact renumbers the live nodes through the forwarding table fwd
+   so that they form a dense prefix of the node table in depth first order
+   from the roots. Nodes with references from outside the roots given by
+   the user keep their numbers (they are pinned) since those references
+   cannot be updated, and the other nodes are placed around them. The
+   nodes are then moved in place by following the cycles of the
+   permutation and the table is shrunk. Live nodes are MARKED while this
+   goes on. */
+
+   /* Next free slot for a node that is moved - skips pinned nodes */
+static BDD compact_slot(BDD *fwd, BDD *pos)
+{
+   while (fwd[*pos] == *pos)
+      (*pos)++;
+   return (*pos)++;
+}
+
+
+   /* Assigns slots to the unassigned nodes below r in depth first order */
+static BDD compact_dfs(BDD r, BDD *fwd, BDD *stack, BDD *pos)
+{
+   BDD *sp = stack;
+   BDD num = 0;
+
+   *sp++ = r;
+   while (sp > stack)
+   {
+      BDD n = *--sp;
+      BddNode *node = &bddnodes[n];
+
+      if (MARKEDp(node))
+	 continue;
+      SETMARKp(node);
+      num++;
+      
+      if (fwd[n] < 0)
+	 fwd[n] = compact_slot(fwd, pos);
+      if (NODE(HIGHp(node)) >= 2  &&  !MARKED(HIGHp(node)))
+	 *sp++ = NODE(HIGHp(node));
+      if (NODE(LOWp(node)) >= 2  &&  !MARKED(LOWp(node)))
+	 *sp++ = NODE(LOWp(node));
+   }
+
+   return num;
+}
+
+
+#define FORWARD(e) (EDGE(fwd[NODE(e)]) | ISCOMPL(e))
+
+int bdd_compact(BDD *roots, int num)
+{
+   BDD *fwd, *stack;
+   BDD n, pos = 2, live = 2, used, newsize, oldsize = bddnodesize;
+   int k, freepct;
+   
+   if (!bddrunning)
+      return bdd_error(BDD_RUNNING);
+   for (k=0 ; k<num ; k++)
+      if (roots[k] >= 2  &&
+	  (NODE(roots[k]) >= bddnodesize  ||  ISFREE(roots[k])))
+	 return bdd_error(BDD_ILLBDD);
+
+   if ((fwd=NEW(BDD,bddnodesize)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   if ((stack=NEW(BDD,bddnodesize-bddfreenum+1)) == NULL)
+   {
+      free(fwd);
+      return bdd_error(BDD_MEMORY);
+   }
+   
+      /* Nodes with more references than given in roots are pinned. So is
+	 a node with a saturated reference count. */
+   memset(fwd, 0, sizeof(BDD)*bddnodesize);
+   for (k=0 ; k<num ; k++)
+      if (roots[k] >= 2)
+	 fwd[NODE(roots[k])]++;
+   for (n=2 ; n<bddnodesize ; n++)
+   {
+      BddNode *node = &bddnodes[n];
+      if (LOWp(node) != -1  &&  node->refcou > 0  &&
+	  (node->refcou == MAXREF  ||  (BDD)node->refcou > fwd[n]))
+	 fwd[n] = n;
+      else
+	 fwd[n] = -1;
+   }
+   fwd[0] = 0;
+   fwd[1] = 1;
+
+      /* Place the nodes reachable from the given roots first and then
+	 those only reachable from the other referenced nodes */
+   for (k=0 ; k<num ; k++)
+      if (roots[k] >= 2  &&  !MARKED(roots[k]))
+	 live += compact_dfs(NODE(roots[k]), fwd, stack, &pos);
+   for (n=2 ; n<bddnodesize ; n++)
+      if (LOWp(&bddnodes[n]) != -1  &&  bddnodes[n].refcou > 0  &&
+	  !MARKED(EDGE(n)))
+	 live += compact_dfs(n, fwd, stack, &pos);
+   free(stack);
+   
+      /* The new table must hold the pinned nodes and should leave twice
+	 the minimum of free nodes */
+   used = pos;
+   for (n=pos ; n<bddnodesize ; n++)
+      if (fwd[n] == n  &&  MARKED(EDGE(n)))
+	 used = n+1;
+   freepct = MIN(2*bddminfreenodes, 90);
+   newsize = bdd_prime_gte(MAX(used, live + (BDD)((double)live*freepct/(100-freepct)) + 1));
+   if (newsize > oldsize)
+      newsize = oldsize;
+
+      /* The dead nodes take the remaining slots to complete the
+	 permutation */
+   for (n=2 ; n<oldsize ; n++)
+      if (!MARKED(EDGE(n)))
+	 fwd[n] = compact_slot(fwd, &pos);
+
+   for (n=2 ; n<oldsize ; n++)
+      if (MARKED(EDGE(n)))
+      {
+	 bddnodes[n].low = FORWARD(bddnodes[n].low);
+	 bddnodes[n].high = FORWARD(bddnodes[n].high);
+      }
+   for (k=0 ; k<num ; k++)
+      roots[k] = FORWARD(roots[k]);
+
+   for (n=2 ; n<oldsize ; n++)
+      while (fwd[n] != n)
+      {
+	 BDD m = fwd[n];
+	 BddNode tmp = bddnodes[m];
+	 bddnodes[m] = bddnodes[n];
+	 bddnodes[n] = tmp;
+	 fwd[n] = fwd[m];
+	 fwd[m] = m;
+      }
+   free(fwd);
+
+   if (newsize < oldsize)
+   {
+      BddNode *newnodes;
+      
+      if (resize_handler != NULL)
+	 resize_handler((int)MIN(oldsize,INT_MAX), (int)MIN(newsize,INT_MAX));
+      
+      if ((newnodes=nodetable_realloc(bddnodes, newsize, newsize)) != NULL)
+      {
+	 bddnodes = newnodes;
+	 bddnodesize = newsize;
+#ifdef COMPACT_NODES
+	 {
+	    BDD *newhash = (BDD*)realloc(bddhash, sizeof(BDD)*newsize);
+	    if (newhash != NULL)
+	       bddhash = newhash;
+	 }
+#endif
+      }
+   }
+
+      /* Rebuild the hash chains and the free list */
+   for (n=0 ; n<bddnodesize ; n++)
+      HASH(n) = 0;
+   bddfreepos = 0;
+   bddfreenum = 0;
+   
+   for (n=bddnodesize-1 ; n>=2 ; n--)
+   {
+      register BddNode *node = &bddnodes[n];
+
+      if (MARKEDp(node))
+      {
+	 register bddhashval hash;
+
+	 UNMARKp(node);
+	 hash = NODEHASH(LEVELp(node), LOWp(node), HIGHp(node));
+	 node->next = HASH(hash);
+	 HASH(hash) = n;
+      }
+      else
+      {
+	 node->refcou = 0;
+	 node->level = 0;
+	 LOWp(node) = -1;
+	 node->next = bddfreepos;
+	 bddfreepos = n;
+	 bddfreenum++;
+      }
+   }
+
+   refext_gbc();
+   bdd_operator_reset();
+   bddresized = 1;
+   
+   return 0;
+}
+
+
 BDD bdd_addref(BDD root)
 {
    if (root < 2  ||  !bddrunning)
       return root;
-   if (root >= bddnodesize)
+   if (NODE(root) >= bddnodesize)
       return bdd_error(BDD_ILLBDD);
-   if (LOW(root) == -1)
+   if (ISFREE(root))
       return bdd_error(BDD_ILLBDD);
 
    INCREF(root);
@@ -723,9 +1194,9 @@ BDD bdd_delref(BDD root)
 {
    if (root < 2  ||  !bddrunning)
       return root;
-   if (root >= bddnodesize)
+   if (NODE(root) >= bddnodesize)
       return bdd_error(BDD_ILLBDD);
-   if (LOW(root) == -1)
+   if (ISFREE(root))
       return bdd_error(BDD_ILLBDD);
 
    /* if the following line is present, fails there much earlier */ 
@@ -738,14 +1209,14 @@ BDD bdd_delref(BDD root)
 
 /*=== RECURSIVE MARK / UNMARK ==========================================*/
 
-void bdd_mark(int i)
+void bdd_mark(BDD i)
 {
    BddNode *node;
    
    if (i < 2)
       return;
 
-   node = &bddnodes[i];
+   node = &bddnodes[NODE(i)];
    if (LEVELp(node) & MARKON  ||  LOWp(node) == -1)
       return;
    
@@ -756,9 +1227,9 @@ void bdd_mark(int i)
 }
 
 
-void bdd_mark_upto(int i, int level)
+void bdd_mark_upto(BDD i, int level)
 {
-   BddNode *node = &bddnodes[i];
+   BddNode *node = &bddnodes[NODE(i)];
    
    if (i < 2)
       return;
@@ -776,14 +1247,14 @@ void bdd_mark_upto(int i, int level)
 }
 
 
-void bdd_markcount(int i, int *cou)
+void bdd_markcount(BDD i, BDD *cou)
 {
    BddNode *node;
    
    if (i < 2)
       return;
 
-   node = &bddnodes[i];
+   node = &bddnodes[NODE(i)];
    if (MARKEDp(node)  ||  LOWp(node) == -1)
       return;
    
@@ -795,14 +1266,14 @@ void bdd_markcount(int i, int *cou)
 }
 
 
-void bdd_unmark(int i)
+void bdd_unmark(BDD i)
 {
    BddNode *node;
    
    if (i < 2)
       return;
 
-   node = &bddnodes[i];
+   node = &bddnodes[NODE(i)];
 
    if (!MARKEDp(node)  ||  LOWp(node) == -1)
       return;
@@ -813,9 +1284,9 @@ void bdd_unmark(int i)
 }
 
 
-void bdd_unmark_upto(int i, int level)
+void bdd_unmark_upto(BDD i, int level)
 {
-   BddNode *node = &bddnodes[i];
+   BddNode *node = &bddnodes[NODE(i)];
 
    if (i < 2)
       return;
@@ -837,12 +1308,18 @@ void bdd_unmark_upto(int i, int level)
   Unique node table functions
 *************************************************************************/
 
-int bdd_makenode(unsigned int level, int low, int high)
+BDD bdd_makenode(unsigned int level, BDD low, BDD high)
 {
    register BddNode *node;
-   register unsigned int hash;
-   register int res;
+   register bddhashval hash;
+   register BDD res;
 
+#ifdef COMPLEMENT_EDGES
+      /* Keep the low edge regular by moving the negation to the result */
+   if (ISCOMPL(low))
+      return NOT(bdd_makenode(level, NOT(low), NOT(high)));
+#endif
+   
 #ifdef CACHESTATS
    bddcachestats.uniqueAccess++;
 #endif
@@ -853,16 +1330,17 @@ int bdd_makenode(unsigned int level, int low, int high)
 
       /* Try to find an existing node of this kind */
    hash = NODEHASH(level, low, high);
-   res = bddnodes[hash].hash;
+   res = HASH(hash);
 
    while(res != 0)
    {
-      if (LEVEL(res) == level  &&  LOW(res) == low  &&  HIGH(res) == high)
+      node = &bddnodes[res];
+      if (LEVELp(node) == level  &&  LOWp(node) == low  &&  HIGHp(node) == high)
       {
 #ifdef CACHESTATS
 	 bddcachestats.uniqueHit++;
 #endif
-	 return res;
+	 return EDGE(res);
       }
 
       res = bddnodes[res].next;
@@ -891,7 +1369,7 @@ int bdd_makenode(unsigned int level, int low, int high)
 	 longjmp(bddexception,1);
       }
 
-      if ((bddfreenum*100) / bddnodesize <= minfreenodes)
+      if ((bddfreenum*100) / bddnodesize <= bddminfreenodes)
       {
 	 bdd_noderesize(1);
 	 hash = NODEHASH(level, low, high);
@@ -918,18 +1396,18 @@ int bdd_makenode(unsigned int level, int low, int high)
    HIGHp(node) = high;
    
       /* Insert node */
-   node->next = bddnodes[hash].hash;
-   bddnodes[hash].hash = res;
+   node->next = HASH(hash);
+   HASH(hash) = res;
 
-   return res;
+   return EDGE(res);
 }
 
 
 int bdd_noderesize(int doRehash)
 {
    BddNode *newnodes;
-   int oldsize = bddnodesize;
-   int n;
+   BDD oldsize = bddnodesize;
+   BDD n;
 
    if (bddnodesize >= bddmaxnodesize  &&  bddmaxnodesize > 0)
       return -1;
@@ -944,24 +1422,33 @@ int bdd_noderesize(int doRehash)
 
    bddnodesize = bdd_prime_lte(bddnodesize);
    
+      /* The handler takes ints, so huge sizes are reported as INT_MAX */
    if (resize_handler != NULL)
-      resize_handler(oldsize, bddnodesize);
+      resize_handler((int)MIN(oldsize,INT_MAX), (int)MIN(bddnodesize,INT_MAX));
 
-   newnodes = (BddNode*)realloc(bddnodes, sizeof(BddNode)*bddnodesize);
+   newnodes = nodetable_realloc(bddnodes, oldsize, bddnodesize);
    if (newnodes == NULL)
       return bdd_error(BDD_MEMORY);
    bddnodes = newnodes;
+#ifdef COMPACT_NODES
+   {
+      BDD *newhash = (BDD*)realloc(bddhash, sizeof(BDD)*bddnodesize);
+      if (newhash == NULL)
+	 return bdd_error(BDD_MEMORY);
+      bddhash = newhash;
+   }
+#endif
 
    if (doRehash)
       for (n=0 ; n<oldsize ; n++)
-	 bddnodes[n].hash = 0;
+	 HASH(n) = 0;
    
    for (n=oldsize ; n<bddnodesize ; n++)
    {
       bddnodes[n].refcou = 0;
-      bddnodes[n].hash = 0;
-      LEVEL(n) = 0;
-      LOW(n) = -1;
+      HASH(n) = 0;
+      bddnodes[n].level = 0;
+      bddnodes[n].low = -1;
       bddnodes[n].next = n+1;
    }
    bddnodes[bddnodesize-1].next = bddfreepos;
@@ -998,7 +1485,8 @@ void bdd_checkreorder(void)
 
 int bdd_scanset(BDD r, int **varset, int *varnum)
 {
-   int n, num;
+   BDD n;
+   int num;
 
    CHECK(r);
    if (r < 2)
@@ -1025,7 +1513,8 @@ int bdd_scanset(BDD r, int **varset, int *varnum)
 
 BDD bdd_makeset(int *varset, int varnum)
 {
-   int v, res=1;
+   int v;
+   BDD res=1;
    
    for (v=varnum-1 ; v>=0 ; v--)
    {
@@ -55,63 +55,70 @@
    /* Sanity check argument and return eventual error code */
 #define CHECK(r)\
    if (!bddrunning) return bdd_error(BDD_RUNNING);\
-   else if ((r) < 0  ||  (r) >= bddnodesize) return bdd_error(BDD_ILLBDD);\
-   else if (r >= 2 && LOW(r) == -1) return bdd_error(BDD_ILLBDD)\
+   else if ((r) < 0  ||  NODE(r) >= bddnodesize) return bdd_error(BDD_ILLBDD);\
+   else if (r >= 2 && ISFREE(r)) return bdd_error(BDD_ILLBDD)\
 
    /* Sanity check argument and return eventually the argument 'a' */
 #define CHECKa(r,a)\
    if (!bddrunning) { bdd_error(BDD_RUNNING); return (a); }\
-   else if ((r) < 0  ||  (r) >= bddnodesize)\
+   else if ((r) < 0  ||  NODE(r) >= bddnodesize)\
      { bdd_error(BDD_ILLBDD); return (a); }\
-   else if (r >= 2 && LOW(r) == -1)\
+   else if (r >= 2 && ISFREE(r))\
      { bdd_error(BDD_ILLBDD); return (a); }
 
 #define CHECKn(r)\
    if (!bddrunning) { bdd_error(BDD_RUNNING); return; }\
-   else if ((r) < 0  ||  (r) >= bddnodesize)\
+   else if ((r) < 0  ||  NODE(r) >= bddnodesize)\
      { bdd_error(BDD_ILLBDD); return; }\
-   else if (r >= 2 && LOW(r) == -1)\
+   else if (r >= 2 && ISFREE(r))\
      { bdd_error(BDD_ILLBDD); return; }
 
 
 /*=== SEMI-INTERNAL TYPES ==============================================*/
 
+   /* Hash values. With 64 bit node indices the hashing is done in 64 bits
+      as well, so that the products do not wrap long before the modulo with
+      the table size. */
+#ifdef BDD_INDEX64
+typedef unsigned long long bddhashval;
+#else
+typedef unsigned int bddhashval;
+#endif
+
+   /* printf/scanf conversion for a BDD, used as in "%" PRIbdd */
+#ifdef BDD_INDEX64
+#define PRIbdd "lld"
+#else
+#define PRIbdd "d"
+#endif
+
+   /* With COMPACT_NODES the hash chain heads are kept in the separate
+      array bddhash, so a node is 16 bytes and the table is aligned such
+      that four nodes fit in a cache line. */
 typedef struct s_BddNode /* Node table entry */
 {
    unsigned int refcou : 10;
    unsigned int level  : 22;
-   int low;
-   int high;
-   int hash;
-   int next;
+   BDD low;
+   BDD high;
+#ifndef COMPACT_NODES
+   BDD hash;
+#endif
+   BDD next;
 } BddNode;
 
+   /* Exact reference count of a node whose refcou field has saturated */
+typedef struct s_BddRefExt
+{
+   BDD node;
+   BDD count;
+} BddRefExt;
 
-/*=== KERNEL VARIABLES =================================================*/
-
-#ifdef CPLUSPLUS
-extern "C" {
-#endif
 
-extern int       bddrunning;         /* Flag - package initialized */
-extern int       bdderrorcond;       /* Some error condition was met */
-extern int       bddnodesize;        /* Number of allocated nodes */
-extern int       bddmaxnodesize;     /* Maximum allowed number of nodes */
-extern int       bddmaxnodeincrease; /* Max. # of nodes used to inc. table */
-extern BddNode*  bddnodes;           /* All of the bdd nodes */
-extern int       bddvarnum;          /* Number of defined BDD variables */
-extern int*      bddrefstack;        /* Internal node reference stack */
-extern int*      bddrefstacktop;     /* Internal node reference stack top */
-extern int*      bddvar2level;
-extern int*      bddlevel2var;
-extern jmp_buf   bddexception;
-extern int       bddreorderdisabled;
-extern int       bddresized;
-extern bddCacheStat bddcachestats;
+/*=== KERNEL VARIABLES =================================================*/
 
-#ifdef CPLUSPLUS
-}
-#endif
+   /* The kernel variables are fields of the current manager */
+#include "manager.h"
 
 
 /*=== KERNEL DEFINITIONS ===============================================*/
@@ -120,46 +127,85 @@ extern bddCacheStat bddcachestats;
 #define MAXREF 0x3FF
 #define SRAND48SEED 0xbeef
 
-   /* Reference counting */
-#define DECREF(n) if (bddnodes[n].refcou!=MAXREF && bddnodes[n].refcou>0) bddnodes[n].refcou--
-#define INCREF(n) if (bddnodes[n].refcou<MAXREF) bddnodes[n].refcou++
-#define DECREFp(n) if (n->refcou!=MAXREF && n->refcou>0) n->refcou--
-#define INCREFp(n) if (n->refcou<MAXREF) n->refcou++
-#define HASREF(n) (bddnodes[n].refcou > 0)
+   /* Complement edges.
+    * With COMPLEMENT_EDGES defined a BDD is an edge: the node index shifted
+    * one bit left with the lowest bit telling whether the edge is negated.
+    * Node 0 is the only terminal (false) and node 1 is never used, so the
+    * constants are still 0 (false) and 1 (true = negated false). The low
+    * edge stored in a node is never negated.
+    * Without COMPLEMENT_EDGES edges and node indices are the same thing. */
+#ifdef COMPLEMENT_EDGES
+#define NODE(a)    ((a) >> 1)
+#define EDGE(n)    ((n) << 1)
+#define ISCOMPL(a) ((a) & 0x1)
+#define REGULAR(a) ((a) & ~0x1)
+#define NOT(a)     ((a) ^ 0x1)
+#else
+#define NODE(a)    (a)
+#define EDGE(n)    (n)
+#define ISCOMPL(a) 0
+#define REGULAR(a) (a)
+#endif
+
+   /* Reference counting.
+    * The refcou field saturates at MAXREF. A node that gets there by
+    * INCREF has its exact count kept in the overflow table bddrefext
+    * while nodes set to MAXREF directly (constants and variables) have
+    * no entry there and stay pinned. */
+#define DECREF(n) if (bddnodes[NODE(n)].refcou==MAXREF) bdd_refext_dec(NODE(n)); else if (bddnodes[NODE(n)].refcou>0) bddnodes[NODE(n)].refcou--
+#define INCREF(n) if (bddnodes[NODE(n)].refcou<MAXREF-1) bddnodes[NODE(n)].refcou++; else bdd_refext_inc(NODE(n))
+#define DECREFp(n) if (n->refcou==MAXREF) bdd_refext_dec((BDD)(n-bddnodes)); else if (n->refcou>0) n->refcou--
+#define INCREFp(n) if (n->refcou<MAXREF-1) n->refcou++; else bdd_refext_inc((BDD)(n-bddnodes))
+#define HASREF(n) (bddnodes[NODE(n)].refcou > 0)
 
    /* Marking BDD nodes */
 #define MARKON   0x200000    /* Bit used to mark a node (1) */
 #define MARKOFF  0x1FFFFF    /* - unmark */
 #define MARKHIDE 0x1FFFFF
-#define SETMARK(n)  (bddnodes[n].level |= MARKON)
-#define UNMARK(n)   (bddnodes[n].level &= MARKOFF)
-#define MARKED(n)   (bddnodes[n].level & MARKON)
+#define SETMARK(n)  (bddnodes[NODE(n)].level |= MARKON)
+#define UNMARK(n)   (bddnodes[NODE(n)].level &= MARKOFF)
+#define MARKED(n)   (bddnodes[NODE(n)].level & MARKON)
 #define SETMARKp(p) (node->level |= MARKON)
 #define UNMARKp(p)  (node->level &= MARKOFF)
 #define MARKEDp(p)  (node->level & MARKON)
 
    /* Hashfunctions */
 
-#define PAIR(a,b)      ((unsigned int)((((unsigned int)a)+((unsigned int)b))*(((unsigned int)a)+((unsigned int)b)+((unsigned int)1))/((unsigned int)2)+((unsigned int)a)))
-#define TRIPLE(a,b,c)  ((unsigned int)(PAIR((unsigned int)c,PAIR(a,b))))
+#define PAIR(a,b)      ((bddhashval)((((bddhashval)a)+((bddhashval)b))*(((bddhashval)a)+((bddhashval)b)+((bddhashval)1))/((bddhashval)2)+((bddhashval)a)))
+#define TRIPLE(a,b,c)  ((bddhashval)(PAIR((bddhashval)c,PAIR(a,b))))
 
 
-   /* Inspection of BDD nodes */
+   /* Inspection of BDD nodes.
+    * LEVEL, LOW and HIGH take an edge and take care of complement bits. The
+    * "p" versions read the raw fields of a node pointer. */
 #define ISCONST(a) ((a) < 2)
 #define ISNONCONST(a) ((a) >= 2)
 #define ISONE(a)   ((a) == 1)
 #define ISZERO(a)  ((a) == 0)
-#define LEVEL(a)   (bddnodes[a].level)
+#define ISFREE(a)  (bddnodes[NODE(a)].low == -1)
+#define LEVEL(a)   (bddnodes[NODE(a)].level)
+#ifdef COMPLEMENT_EDGES
+#define LOW(a)     (bddnodes[NODE(a)].low ^ ISCOMPL(a))
+#define HIGH(a)    (bddnodes[NODE(a)].high ^ ISCOMPL(a))
+#else
 #define LOW(a)     (bddnodes[a].low)
 #define HIGH(a)    (bddnodes[a].high)
+#endif
 #define LEVELp(p)   ((p)->level)
 #define LOWp(p)     ((p)->low)
 #define HIGHp(p)    ((p)->high)
 
+   /* Head of hash chain n */
+#ifdef COMPACT_NODES
+#define HASH(n)     (bddhash[n])
+#else
+#define HASH(n)     (bddnodes[n].hash)
+#endif
+
    /* Stacking for garbage collector */
 #define INITREF    bddrefstacktop = bddrefstack
 /* #define PUSHREF(a) *(bddrefstacktop++) = (a) */
-static inline int PUSHREF(int a) { return *(bddrefstacktop++) = a; }
+static inline BDD PUSHREF(BDD a) { return *(bddrefstacktop++) = a; }
 #define READREF(a) *(bddrefstacktop-(a))
 #define POPREF(a)  bddrefstacktop -= (a)
 
@@ -189,14 +235,17 @@ extern "C" {
 #endif
 
 extern int    bdd_error(int);
-extern int    bdd_makenode(unsigned int, int, int);
+extern BDD    bdd_makenode(unsigned int, BDD, BDD);
 extern int    bdd_noderesize(int);
+extern void   bdd_gbc_resize(void);
+extern void   bdd_refext_inc(BDD);
+extern void   bdd_refext_dec(BDD);
 extern void   bdd_checkreorder(void);
-extern void   bdd_mark(int);
-extern void   bdd_mark_upto(int, int);
-extern void   bdd_markcount(int, int*);
-extern void   bdd_unmark(int);
-extern void   bdd_unmark_upto(int, int);
+extern void   bdd_mark(BDD);
+extern void   bdd_mark_upto(BDD, int);
+extern void   bdd_markcount(BDD, BDD*);
+extern void   bdd_unmark(BDD);
+extern void   bdd_unmark_upto(BDD, int);
 extern void   bdd_register_pair(bddPair*);
 extern int   *fdddec2bin(int, int);
 
@@ -204,6 +253,8 @@ extern int    bdd_operator_init(int);
 extern void   bdd_operator_done(void);
 extern void   bdd_operator_varresize(void);
 extern void   bdd_operator_reset(void);
+extern void   bdd_operator_gbc(void);
+extern void   bdd_operator_stats(bddCacheUsage *, bddOpStat *);
 
 extern void   bdd_pairs_init(void);
 extern void   bdd_pairs_done(void);
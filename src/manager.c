@@ -0,0 +1,114 @@
+/*========================================================================
+              Copyright (C) 2026 by the BuDDy contributors
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+
+/*************************************************************************
+  $Header$
+  FILE:  manager.c
+  DESCR: Creation and selection of BDD managers
+  DATE:  (C) 2026
+
+  A manager holds a complete BDD universe: the node table, the operator
+  caches, the variable order, pairs, domains and so on. The package
+  always works on the current manager of the calling thread. A thread
+  starts out with the main manager, so programs that never touch the
+  managers work as before.
+*************************************************************************/
+#include <stdlib.h>
+#include "config.h"
+#include "kernel.h"
+
+   /* Initial values for a new manager. The field names of the kernel
+      variables are hidden by their macros, so undefine the ones needed. */
+#undef bddthreadnum
+
+#define MANAGERDEFAULTS                        \
+   { .bddminfreenodes = 20,                     \
+     .bddthreadnum = 1,                        \
+     .parunique = BDD_UNIQUE_CHAINED }
+
+static BddManager bddmainmanager = MANAGERDEFAULTS;
+
+BDD_TLS BddManager *bddmanager = &bddmainmanager;
+
+
+/*************************************************************************
+  Manager handling
+*************************************************************************/
+
+bddManager *bdd_newmanager(void)
+{
+   static const BddManager defaults = MANAGERDEFAULTS;
+   BddManager *m;
+
+   if ((m=NEW(BddManager,1)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   *m = defaults;
+   return m;
+}
+
+
+int bdd_deletemanager(bddManager *m)
+{
+   BddManager *old;
+   
+   if (m == NULL  ||  m == &bddmainmanager)
+      return bdd_error(BDD_RANGE);
+
+   old = bddmanager;
+   bddmanager = m;
+   if (bddrunning)
+      bdd_done();
+   bddmanager = (old == m ? &bddmainmanager : old);
+
+   free(m);
+   return 0;
+}
+
+
+bddManager *bdd_setmanager(bddManager *m)
+{
+   BddManager *old = bddmanager;
+
+   bddmanager = (m == NULL ? &bddmainmanager : m);
+   return old;
+}
+
+
+bddManager *bdd_getmanager(void)
+{
+   return bddmanager;
+}
+
+
+/* EOF */
@@ -0,0 +1,264 @@
+/*========================================================================
+              Copyright (C) 2026 by the BuDDy contributors
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  $Header$
+  FILE:  manager.h
+  DESCR: The state of a BDD universe
+  DATE:  (C) 2026
+*************************************************************************/
+
+#ifndef _MANAGER_H
+#define _MANAGER_H
+
+#include <setjmp.h>
+#include "cache.h"
+#include "parallel.h"
+
+   /* Thread local storage for the current manager. The initial-exec
+      model is only safe when linked statically, a shared library that
+      uses it may fail to load with dlopen(). Libtool defines PIC for
+      the shared build. Other compilers must provide thread local
+      storage, a plain global would let threads change each other's
+      manager. */
+#if defined(__GNUC__)  &&  !defined(PIC)
+#define BDD_TLS __thread __attribute__((tls_model("initial-exec")))
+#elif defined(__GNUC__)
+#define BDD_TLS __thread
+#elif defined(__cplusplus)  &&  __cplusplus >= 201103L
+#define BDD_TLS thread_local
+#elif defined(__STDC_VERSION__)  &&  __STDC_VERSION__ >= 201112L
+#define BDD_TLS _Thread_local
+#elif defined(_MSC_VER)
+#define BDD_TLS __declspec(thread)
+#else
+#error "No thread local storage for the current manager with this compiler"
+#endif
+
+
+/*=== MANAGER ==========================================================*/
+
+   /* All of the package state lives in a manager. Each thread works on
+      its own current manager (see bdd_setmanager). The fields keep the
+      names of the old global variables and each module defines these
+      names as macros for the fields of the current manager. */
+struct s_BddManager
+{
+      /* Kernel (kernel.c) */
+   int          bddrunning;         /* Flag - package initialized */
+   int          bdderrorcond;       /* Some error condition */
+   BDD          bddnodesize;        /* Number of allocated nodes */
+   BDD          bddmaxnodesize;     /* Maximum allowed number of nodes */
+   BDD          bddmaxnodeincrease; /* Max. # of nodes used to inc. table */
+   BddNode*     bddnodes;           /* All of the bdd nodes */
+#ifdef COMPACT_NODES
+   void*        bddnodesmem;        /* Unaligned block holding bddnodes */
+   BDD*         bddhash;            /* Hash chain heads for bddnodes */
+#endif
+   BDD          bddfreepos;         /* First free node */
+   BDD          bddfreenum;         /* Number of free nodes */
+   long int     bddproduced;        /* Number of new nodes ever produced */
+   int          bddvarnum;          /* Number of defined BDD variables */
+   BDD*         bddrefstack;        /* Internal node reference stack */
+   BDD*         bddrefstacktop;     /* Internal node reference stack top */
+   BddRefExt*   bddrefext;          /* Counts of saturated nodes */
+   BDD          bddrefextsize;      /* Size of bddrefext (power of two) */
+   BDD          bddrefextnum;       /* Number of used entries in bddrefext */
+   int*         bddvar2level;       /* Variable -> level table */
+   int*         bddlevel2var;       /* Level -> variable table */
+   jmp_buf      bddexception;       /* Long-jump point for interrupting calc. */
+   int          bddresized;         /* Flag indicating a resize of the nodetable */
+   bddCacheStat bddcachestats;
+   int          bddminfreenodes;    /* Min. % of free nodes after a gbc */
+   BDD*         bddvarset;          /* Set of defined BDD variables */
+   int          gbcollectnum;       /* Number of garbage collections */
+   int          bddcachesize;       /* Size of the operator caches */
+   long int     gbcclock;           /* Clock ticks used in GBC */
+   BDD          usednodes_nextreorder; /* When to do reorder next time */
+   bddinthandler  err_handler;      /* Error handler */
+   bddgbchandler  gbc_handler;      /* Garbage collection handler */
+   bdd2inthandler resize_handler;   /* Node-table-resize handler */
+
+      /* Operators (bddop.c) */
+   int applyop;                     /* Current operator for apply */
+   int appexop;                     /* Current operator for appex */
+   BDD appexid;                     /* Current cache id for appex */
+   BDD quantid;                     /* Current cache id for quantifications */
+   int *quantvarset;                /* Current variable set for quant. */
+   int quantvarsetID;               /* Current id used in quantvarset */
+   int quantlast;                   /* Current last variable to be quant. */
+   int replaceid;                   /* Current cache id for replace */
+   BDD *replacepair;                /* Current replace pair */
+   int replacelast;                 /* Current last var. level to replace */
+   int composelevel;                /* Current variable used for compose */
+   BDD miscid;                      /* Current cache id for other results */
+   int *varprofile;                 /* Current variable profile */
+   int supportID;                   /* Current ID (true value) for support */
+   int supportMin;                  /* Min. used level in support calc. */
+   int supportMax;                  /* Max. used level in support calc. */
+   int *supportSet;                 /* The found support set */
+   int supportSize;                 /* Allocated size of supportSet */
+   BddCache applycache;             /* Cache for apply results */
+   BddCache itecache;               /* Cache for ITE results */
+   BddCache quantcache;             /* Cache for exist/forall results */
+   BddCache appexcache;             /* Cache for appex/appall results */
+   BddCache replacecache;           /* Cache for replace results */
+   BddCache misccache;              /* Cache for other results */
+   BddCache testcache;              /* Cache for leq/disjoint/equal_under */
+   int cacheratio;
+   int cachemode;                   /* Cache invalidation at gbc */
+   int cachebudget;                 /* Max. entries of adaptive caches */
+   bddcachehandler cache_handler;   /* Adaptive cache sizing handler */
+   long unsigned int opcalls[BDD_OPSTATNUM]; /* Calls of the operators */
+   long optime[BDD_OPSTATNUM];      /* Clock ticks used by the operators */
+   int optiming;                    /* Flag - measure optime */
+   BDD satPolarity;
+   int firstReorder;                /* Reorder retry flag for the operators */
+   char *allsatProfile;             /* Variable profile for bdd_allsat() */
+   bddallsathandler allsatHandler;  /* Callback handler for bdd_allsat() */
+   int opengine;                    /* Recursive or iterative operators */
+   struct s_BddFrame *iterstack;    /* Frames of the iterative operators */
+   int iterstacktop;                /* Number of frames in use */
+   int itermaxdepth;                /* Largest number of frames used */
+   struct s_BddCount *countmemo;    /* Counts per node (bdd_setcountmemo) */
+   BDD countmemosize;               /* Number of nodes in countmemo */
+   int countmemoon;                 /* Flag - count with countmemo */
+   struct s_BddBigInt **countexact; /* Exact counts per node */
+   BDD countexactsize;              /* Number of nodes in countexact */
+   BDD *narystack;                  /* Operand lists of bdd_apply_n */
+   int narystacksize;               /* Allocated size of narystack */
+   struct s_BddNaryEntry *narycache; /* Cache of the n-ary recursion */
+   int narycachesize;               /* Number of entries in narycache */
+   int naryschedule;                /* Merge order of bdd_apply_n */
+
+      /* Reordering (reorder.c) */
+   int bddreordermethod;            /* Current auto reord. method */
+   int bddreordertimes;             /* Number of automatic reorderings left */
+   int reorderdisabled;             /* Flag for disabling reordering */
+   struct s_BddTree *vartree;       /* Store for the variable relationships */
+   int blockid;
+   BDD *extroots;                   /* Store for the ref.cou. of the ext. roots */
+   int extrootsize;
+   struct _levelData *levels;       /* Level data indexed by variable */
+   struct _imatrix *iactmtx;        /* Interaction matrix */
+   int verbose;                     /* Reordering information for the user */
+   bddinthandler reorder_handler;
+   bddfilehandler reorder_filehandler;
+   bddsizehandler reorder_nodenum;
+   BDD usednum_before;              /* Live nodes before reordering */
+   BDD usednum_after;               /* Live nodes after reordering */
+   int resizedInMakenode;           /* Node table resized while reordering */
+   long reorderclock;               /* Start time of the current reordering */
+
+      /* Replacement pairs (pairs.c) */
+   int pairsid;                     /* Pair identifier */
+   bddPair *pairs;                  /* List of all replacement pairs in use */
+
+      /* Finite domains (fdd.c) */
+   int firstbddvar;
+   int fdvaralloc;                  /* Number of allocated domains */
+   int fdvarnum;                    /* Number of defined domains */
+   struct s_Domain *domain;         /* Table of domain sizes */
+   bddfilehandler fddfilehandler;   /* Printing of domain values */
+
+      /* Saving and loading (bddio.c) */
+   bddfilehandler filehandler;      /* Printing of variables */
+   struct s_LoadHash *lh_table;
+   int lh_freepos;
+   int lh_nodenum;
+   int *loadvar2level;
+   char *savemark;                  /* Saved edges (complement edges only) */
+
+      /* Parallel operators (parallel.c) */
+   int bddthreadnum;                /* Number of threads for operators */
+   int parunique;                   /* Unique table for new nodes */
+#ifdef BDD_THREADS
+   volatile int bddparabort;        /* Set when free nodes ran out */
+   BddWorker *parworkers;           /* Worker 0 is the calling thread */
+   pthread_t *parthreads;
+   pthread_mutex_t parlock;
+   pthread_cond_t parcond;
+   pthread_mutex_t parfreelock;
+   pthread_mutex_t parstripes[PARSTRIPES];
+   int parjob;                      /* Job counter, protected by parlock */
+   int parquit;                     /* Ask the threads to terminate */
+   volatile int paractive;          /* Set while a job is running */
+   volatile int paridle;            /* Threads done with the current job */
+   BDD *paropen;                    /* Open addressing table of new nodes */
+   bddhashval paropensize;          /* Size of paropen (a power of two) */
+   int paropenshift;                /* Bits in bddhashval - log2(paropensize) */
+#endif
+};
+
+typedef struct s_BddManager BddManager;
+
+#ifdef CPLUSPLUS
+extern "C" {
+#endif
+
+extern BDD_TLS BddManager *bddmanager;  /* The current manager */
+
+#ifdef CPLUSPLUS
+}
+#endif
+
+
+/*=== KERNEL VARIABLES =================================================*/
+
+#define bddrunning         (bddmanager->bddrunning)
+#define bdderrorcond       (bddmanager->bdderrorcond)
+#define bddnodesize        (bddmanager->bddnodesize)
+#define bddmaxnodesize     (bddmanager->bddmaxnodesize)
+#define bddmaxnodeincrease (bddmanager->bddmaxnodeincrease)
+#define bddnodes           (bddmanager->bddnodes)
+#define bddhash            (bddmanager->bddhash)
+#define bddnodesmem        (bddmanager->bddnodesmem)
+#define bddfreepos         (bddmanager->bddfreepos)
+#define bddfreenum         (bddmanager->bddfreenum)
+#define bddproduced        (bddmanager->bddproduced)
+#define bddvarnum          (bddmanager->bddvarnum)
+#define bddrefstack        (bddmanager->bddrefstack)
+#define bddrefstacktop     (bddmanager->bddrefstacktop)
+#define bddrefext          (bddmanager->bddrefext)
+#define bddrefextsize      (bddmanager->bddrefextsize)
+#define bddrefextnum       (bddmanager->bddrefextnum)
+#define bddvar2level       (bddmanager->bddvar2level)
+#define bddlevel2var       (bddmanager->bddlevel2var)
+#define bddexception       (bddmanager->bddexception)
+#define bddresized         (bddmanager->bddresized)
+#define bddcachestats      (bddmanager->bddcachestats)
+#define bddthreadnum       (bddmanager->bddthreadnum)
+#ifdef BDD_THREADS
+#define bddparabort        (bddmanager->bddparabort)
+#endif
+
+#endif /* _MANAGER_H */
+
+
+/* EOF */
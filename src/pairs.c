@@ -37,12 +37,13 @@
 
 #include <stdlib.h>
 #include <limits.h>
+#include "config.h"
 #include "kernel.h"
 
 /*======================================================================*/
 
-static int      pairsid;            /* Pair identifier */
-static bddPair* pairs;              /* List of all replacement pairs in use */
+#define pairsid (bddmanager->pairsid) /* Pair identifier */
+#define pairs   (bddmanager->pairs)   /* List of all replacement pairs in use */
 
 
 /*************************************************************************
@@ -102,7 +103,7 @@ void bdd_pairs_vardown(int level)
    
    for (p=pairs ; p!=NULL ; p=p->next)
    {
-      int tmp;
+      BDD tmp;
 
       tmp = p->result[level];
       p->result[level] = p->result[level+1];
@@ -0,0 +1,770 @@
+/*========================================================================
+              Copyright (C) 2026 by the BuDDy contributors
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  $Header$
+  FILE:  parallel.c
+  DESCR: Work-stealing thread pool for parallel bdd operators
+  DATE:  (C) 2026
+
+  The operators in bddop.c may split their recursion into tasks that are
+  spread over a pool of threads (see bdd_setthreads). Each thread owns a
+  deque of tasks: the owner pushes and pops at the top, idle threads steal
+  from the base (the THE protocol from Cilk-5).
+
+  While a parallel operation runs the node table is neither garbage
+  collected nor resized. New nodes are taken from small private chunks of
+  the free list and inserted into the unique table under a striped lock.
+  If the free nodes run out the operation is aborted, the node table is
+  cleaned up and the operation is tried once more before the caller falls
+  back to the sequential version.
+
+  As an alternative to the striped locks (see bdd_setuniquetable) new
+  nodes can be inserted into a lock-free open addressing table with
+  compare-and-swap. The ordinary hash chains are then left untouched
+  during the operation and the new nodes are moved into the chains
+  afterwards.
+*************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "kernel.h"
+#include "parallel.h"
+
+#ifdef BDD_THREADS
+#include <sched.h>
+#endif
+
+   /* Fields of the current manager - see manager.h */
+#define parunique    (bddmanager->parunique)
+
+#ifdef BDD_THREADS
+
+   /* Number of free nodes moved to a thread at a time */
+#define PARCHUNK 128
+
+   /* Max. number of probes in the open addressing table */
+#define PARPROBES 1024
+
+#define NODEHASH(lvl,l,h) (TRIPLE(lvl,l,h) % bddnodesize)
+#ifdef BDD_INDEX64
+#define OPENHASH(lvl,l,h) ((TRIPLE(lvl,l,h) * 11400714819323198485ULL) >> paropenshift)
+#else
+#define OPENHASH(lvl,l,h) ((TRIPLE(lvl,l,h) * 2654435769U) >> paropenshift)
+#endif
+#define FENCE()           __sync_synchronize()
+#define VOLATILE(x)       (*(volatile BDD *)&(x))
+
+#define parworkers   (bddmanager->parworkers)
+#define parthreads   (bddmanager->parthreads)
+#define parlock      (bddmanager->parlock)
+#define parcond      (bddmanager->parcond)
+#define parfreelock  (bddmanager->parfreelock)
+#define parstripes   (bddmanager->parstripes)
+#define parjob       (bddmanager->parjob)
+#define parquit      (bddmanager->parquit)
+#define paractive    (bddmanager->paractive)
+#define paridle      (bddmanager->paridle)
+#define paropen      (bddmanager->paropen)
+#define paropensize  (bddmanager->paropensize)
+#define paropenshift (bddmanager->paropenshift)
+
+static void *par_thread(void *);
+static int   par_steal_run(BddWorker *);
+static void  par_runtask(BddWorker *, BddTask *);
+static void  par_stop(void);
+
+
+/*************************************************************************
+  Thread pool
+*************************************************************************/
+
+static int par_start(int num)
+{
+   int n;
+
+   if ((parworkers=NEW(BddWorker,num)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   if ((parthreads=NEW(pthread_t,num)) == NULL)
+   {
+      free(parworkers);
+      parworkers = NULL;
+      return bdd_error(BDD_MEMORY);
+   }
+
+   memset(parworkers, 0, sizeof(BddWorker)*num);
+   for (n=0 ; n<num ; n++)
+   {
+      pthread_mutex_init(&parworkers[n].lock, NULL);
+      parworkers[n].manager = bddmanager;
+      parworkers[n].seed = n+1;
+   }
+   for (n=0 ; n<PARSTRIPES ; n++)
+      pthread_mutex_init(&parstripes[n], NULL);
+   pthread_mutex_init(&parlock, NULL);
+   pthread_mutex_init(&parfreelock, NULL);
+   pthread_cond_init(&parcond, NULL);
+
+   parjob = 0;
+   parquit = 0;
+   bddthreadnum = num;
+   
+   for (n=1 ; n<num ; n++)
+   {
+      if (pthread_create(&parthreads[n], NULL, par_thread, &parworkers[n]))
+      {
+	 bddthreadnum = n;
+	 par_stop();
+	 return bdd_error(BDD_MEMORY);
+      }
+   }
+
+   return 0;
+}
+
+
+static void par_stop(void)
+{
+   int n;
+
+   if (parworkers == NULL)
+      return;
+   
+   pthread_mutex_lock(&parlock);
+   parquit = 1;
+   pthread_cond_broadcast(&parcond);
+   pthread_mutex_unlock(&parlock);
+   
+   for (n=1 ; n<bddthreadnum ; n++)
+      pthread_join(parthreads[n], NULL);
+
+   for (n=0 ; n<bddthreadnum ; n++)
+   {
+      pthread_mutex_destroy(&parworkers[n].lock);
+      free(parworkers[n].tasks);
+      free(parworkers[n].visited);
+   }
+   for (n=0 ; n<PARSTRIPES ; n++)
+      pthread_mutex_destroy(&parstripes[n]);
+   pthread_mutex_destroy(&parlock);
+   pthread_mutex_destroy(&parfreelock);
+   pthread_cond_destroy(&parcond);
+   
+   free(parworkers);
+   free(parthreads);
+   free(paropen);
+   parworkers = NULL;
+   parthreads = NULL;
+   paropen = NULL;
+   paropensize = 0;
+   bddthreadnum = 1;
+}
+
+
+static void *par_thread(void *arg)
+{
+   BddWorker *w = (BddWorker*)arg;
+   int job = 0;
+
+   bddmanager = w->manager;
+   
+   pthread_mutex_lock(&parlock);
+   while (1)
+   {
+      while (job == parjob  &&  !parquit)
+	 pthread_cond_wait(&parcond, &parlock);
+      if (parquit)
+	 break;
+      job = parjob;
+      pthread_mutex_unlock(&parlock);
+
+      while (paractive)
+	 if (!par_steal_run(w))
+	    sched_yield();
+
+      __sync_fetch_and_add(&paridle, 1);
+      pthread_mutex_lock(&parlock);
+   }
+   pthread_mutex_unlock(&parlock);
+
+   return NULL;
+}
+
+
+   /* Move the private free nodes back to the global free list */
+static void par_returnnodes(void)
+{
+   int n;
+
+   for (n=0 ; n<bddthreadnum ; n++)
+   {
+      BddWorker *w = &parworkers[n];
+
+      if (w->freepos != 0)
+      {
+	 BDD last = w->freepos;
+
+	 while (bddnodes[last].next != 0)
+	    last = bddnodes[last].next;
+	 
+	 bddnodes[last].next = bddfreepos;
+	 bddfreepos = w->freepos;
+	 bddfreenum += w->freenum;
+	 w->freepos = 0;
+	 w->freenum = 0;
+      }
+
+      bddproduced += w->produced;
+      w->produced = 0;
+   }
+}
+
+
+   /* Move the nodes from the open addressing table into the hash chains
+      and clear the table again */
+static void par_linknodes(void)
+{
+   bddhashval mask = paropensize - 1;
+   int n;
+
+   for (n=0 ; n<bddthreadnum ; n++)
+   {
+      BddWorker *w = &parworkers[n];
+
+      while (w->newnodes != 0)
+      {
+	 BDD res = w->newnodes;
+	 BddNode *node = &bddnodes[res];
+	 bddhashval hash = NODEHASH(LEVELp(node), LOWp(node), HIGHp(node));
+	 bddhashval pos = OPENHASH(LEVELp(node), LOWp(node), HIGHp(node));
+
+	 w->newnodes = node->next;
+	 node->next = HASH(hash);
+	 HASH(hash) = res;
+
+	 for ( ; paropen[pos] != res ; pos=(pos+1) & mask)
+	    ;
+	 paropen[pos] = 0;
+      }
+   }
+}
+
+
+   /* Make sure the open addressing table can hold all free nodes at a
+      load factor below one half */
+static int par_openalloc(void)
+{
+   bddhashval size = 2;
+   int shift = 8*sizeof(bddhashval) - 1;
+
+   while (size < 2*(bddhashval)bddnodesize)
+   {
+      size <<= 1;
+      shift--;
+   }
+
+   if (size <= paropensize)
+      return 0;
+
+   free(paropen);
+   paropensize = 0;
+   if ((paropen=(BDD*)calloc(size, sizeof(BDD))) == NULL)
+      return -1;
+   paropensize = size;
+   paropenshift = shift;
+
+   return 0;
+}
+
+
+/* Run the task function fn(a,b,c) on the thread pool. Returns the result
+   or -1 if the node table ran full twice. */
+BDD bdd_par_run(BddTaskFunc fn, BDD a, BDD b, BDD c)
+{
+   BddTask root;
+   int tasksize = 4*bddvarnum + 64;
+   int n, tries;
+   BDD res;
+
+   for (n=0 ; n<bddthreadnum ; n++)
+   {
+      BddWorker *w = &parworkers[n];
+
+      if (w->tasksize < tasksize)
+      {
+	 free(w->tasks);
+	 w->tasksize = 0;
+	 if ((w->tasks=NEW(BddTask*,tasksize)) == NULL)
+	    return -1;
+	 w->tasksize = tasksize;
+      }
+   }
+
+   if (parunique == BDD_UNIQUE_OPEN  &&  par_openalloc() < 0)
+      return -1;
+   
+   for (tries=0 ; tries<2 ; tries++)
+   {
+      bddparabort = 0;
+      paridle = 0;
+      for (n=0 ; n<bddthreadnum ; n++)
+	 parworkers[n].top = parworkers[n].base = 0;
+      paractive = 1;
+      
+      pthread_mutex_lock(&parlock);
+      parjob++;
+      pthread_cond_broadcast(&parcond);
+      pthread_mutex_unlock(&parlock);
+      
+      root.a = a;
+      root.b = b;
+      root.c = c;
+      res = fn(&parworkers[0], &root);
+
+      paractive = 0;
+      while (paridle < bddthreadnum-1)
+	 sched_yield();
+      if (parunique == BDD_UNIQUE_OPEN)
+	 par_linknodes();
+      par_returnnodes();
+
+      if (!bddparabort)
+	 return res;
+
+	 /* Out of free nodes. The operators stop writing to the caches
+	    once the abort is seen, but the caches are emptied anyway
+	    before the next try and before the caller falls back to the
+	    sequential version, whatever the cache mode is. */
+      bdd_operator_reset();
+      if (tries == 0)
+      {
+	 INITREF;
+	 bdd_gbc_resize();
+      }
+   }
+   
+   return -1;
+}
+
+
+/*************************************************************************
+  Task deques
+*************************************************************************/
+
+void bdd_par_spawn(BddWorker *w, BddTask *t)
+{
+   if (w->top >= w->tasksize)
+   {
+      t->done = -1;
+      return;
+   }
+
+   t->done = 0;
+   w->tasks[w->top] = t;
+   FENCE();
+   w->top++;
+}
+
+
+   /* Pop the newest task. Returns NULL if it has been stolen. */
+static BddTask *par_pop(BddWorker *w)
+{
+   int t = w->top - 1;
+
+   w->top = t;
+   FENCE();
+   
+   if (w->base > t)
+   {
+      pthread_mutex_lock(&w->lock);
+      if (w->base > t)
+      {
+	    /* Stolen - and so is everything below it */
+	 w->base = t;
+	 pthread_mutex_unlock(&w->lock);
+	 return NULL;
+      }
+      pthread_mutex_unlock(&w->lock);
+   }
+
+   return w->tasks[t];
+}
+
+
+   /* Steal the oldest task from v for w. Returns NULL if there is none.
+      The thief is recorded under the lock, so the owner sees it once
+      par_pop has found the task stolen. */
+static BddTask *par_steal(BddWorker *v, BddWorker *w)
+{
+   BddTask *t = NULL;
+   int b;
+
+   if (v->base >= v->top)
+      return NULL;
+   
+   pthread_mutex_lock(&v->lock);
+   b = v->base;
+   v->base = b+1;
+   FENCE();
+   if (b+1 > v->top)
+      v->base = b;
+   else
+   {
+      t = v->tasks[b];
+      t->thief = w;
+   }
+   pthread_mutex_unlock(&v->lock);
+
+   return t;
+}
+
+
+static int par_steal_run(BddWorker *w)
+{
+   BddWorker *v = &parworkers[rand_r(&w->seed) % bddthreadnum];
+   BddTask *t;
+
+   if (v == w  ||  (t=par_steal(v, w)) == NULL)
+      return 0;
+
+   par_runtask(w, t);
+   return 1;
+}
+
+
+static void par_runtask(BddWorker *w, BddTask *t)
+{
+   t->res = t->fn(w, t);
+   FENCE();
+   t->done = 1;
+}
+
+
+/* Wait for a task spawned by bdd_par_spawn and return its result. The task
+   is calculated here unless it has been stolen - in which case we help
+   the thief with its tasks until it is done (leapfrogging). The thief's
+   deque was empty when it stole the task, so everything on it is part of
+   the stolen calculation. Helping with tasks from other threads instead
+   could nest unrelated calculations on the stack without bound. */
+BDD bdd_par_sync(BddWorker *w, BddTask *t)
+{
+   BddTask *s;
+   
+   if (t->done < 0  ||  par_pop(w) != NULL)
+      return t->fn(w, t);
+   
+   while (!t->done)
+   {
+      if ((s=par_steal(t->thief, w)) != NULL)
+	 par_runtask(w, s);
+      else
+	 sched_yield();
+   }
+   FENCE();
+   
+   return t->res;
+}
+
+
+/*************************************************************************
+  Visited bitmaps
+*************************************************************************/
+
+/* Clears the visited bitmaps of all threads, which then cover the whole
+   node table. Traversals that would otherwise use the mark bit in the
+   nodes let each thread mark the nodes in its own bitmap instead. A node
+   may be visited by more than one thread, but there is no sharing and
+   no locking. Returns 0 or -1 if out of memory. */
+int bdd_par_visitclear(void)
+{
+   int size = bddnodesize/32 + 1;
+   int n;
+
+   for (n=0 ; n<bddthreadnum ; n++)
+   {
+      BddWorker *w = &parworkers[n];
+
+      if (w->visitedsize != size)
+      {
+	 free(w->visited);
+	 w->visitedsize = 0;
+	 if ((w->visited=NEW(unsigned int,size)) == NULL)
+	    return -1;
+	 w->visitedsize = size;
+      }
+      memset(w->visited, 0, sizeof(unsigned int)*size);
+   }
+
+   return 0;
+}
+
+
+/* Merges the visited bitmaps of all threads into the one of the first
+   thread and returns it */
+unsigned int *bdd_par_visitunion(void)
+{
+   unsigned int *res = parworkers[0].visited;
+   int size = parworkers[0].visitedsize;
+   int n, i;
+
+   for (n=1 ; n<bddthreadnum ; n++)
+   {
+      unsigned int *visited = parworkers[n].visited;
+      for (i=0 ; i<size ; i++)
+	 res[i] |= visited[i];
+   }
+
+   return res;
+}
+
+
+/*************************************************************************
+  Node creation
+*************************************************************************/
+
+   /* Move a chunk of the global free list to w */
+static int par_getnodes(BddWorker *w)
+{
+   int n;
+   BDD last;
+
+   pthread_mutex_lock(&parfreelock);
+
+   if (bddfreepos == 0)
+   {
+      pthread_mutex_unlock(&parfreelock);
+      return 0;
+   }
+   
+   w->freepos = last = bddfreepos;
+   for (n=1 ; n<PARCHUNK  &&  bddnodes[last].next != 0 ; n++)
+      last = bddnodes[last].next;
+   
+   bddfreepos = bddnodes[last].next;
+   bddnodes[last].next = 0;
+   bddfreenum -= n;
+   w->freenum = n;
+   
+   pthread_mutex_unlock(&parfreelock);
+   return n;
+}
+
+
+   /* Insert a new node into the open addressing table. The node is
+      initialized before it is published by a compare-and-swap on an empty
+      slot, so the slots can be read without locking. */
+static BDD par_makenode_open(BddWorker *w, unsigned int level,
+			     BDD low, BDD high)
+{
+   bddhashval mask = paropensize - 1;
+   bddhashval pos = OPENHASH(level, low, high);
+   BddNode *node;
+   BDD res = 0;
+   BDD n;
+   int probes;
+
+   for (probes=0 ; probes<PARPROBES ; probes++, pos=(pos+1) & mask)
+   {
+      if ((n=VOLATILE(paropen[pos])) == 0)
+      {
+	 if (res == 0)
+	 {
+	    if (w->freepos == 0  &&  par_getnodes(w) == 0)
+	       break;
+	    
+	    res = w->freepos;
+	    w->freepos = bddnodes[res].next;
+	    w->freenum--;
+	 
+	    node = &bddnodes[res];
+	    LEVELp(node) = level;
+	    LOWp(node) = low;
+	    HIGHp(node) = high;
+	 }
+
+	 if (__sync_bool_compare_and_swap(&paropen[pos], 0, res))
+	 {
+	    bddnodes[res].next = w->newnodes;
+	    w->newnodes = res;
+	    w->produced++;
+	    return EDGE(res);
+	 }
+	 
+	 n = VOLATILE(paropen[pos]);
+      }
+
+      node = &bddnodes[n];
+      if (LEVELp(node) == level  &&  LOWp(node) == low  &&  HIGHp(node) == high)
+      {
+	 if (res != 0)
+	 {
+	    LOWp(&bddnodes[res]) = -1;
+	    bddnodes[res].next = w->freepos;
+	    w->freepos = res;
+	    w->freenum++;
+	 }
+	 return EDGE(n);
+      }
+   }
+
+      /* Out of free nodes or too many collisions */
+   if (res != 0)
+   {
+      LOWp(&bddnodes[res]) = -1;
+      bddnodes[res].next = w->freepos;
+      w->freepos = res;
+      w->freenum++;
+   }
+   bddparabort = 1;
+   return 0;
+}
+
+
+/* Thread safe version of bdd_makenode. The hash chains are only extended
+   at the head with completely initialized nodes, so lookups are done
+   without locking. Insertion is done under the lock of the hash stripe
+   after checking the nodes inserted since the first lookup. With the
+   open addressing table the chains are only read and new nodes go into
+   the table. */
+BDD bdd_par_makenode(BddWorker *w, unsigned int level, BDD low, BDD high)
+{
+   register BddNode *node;
+   register bddhashval hash;
+   register BDD res;
+   pthread_mutex_t *lock;
+   BDD first;
+
+#ifdef COMPLEMENT_EDGES
+   if (ISCOMPL(low))
+      return NOT(bdd_par_makenode(w, level, NOT(low), NOT(high)));
+#endif
+
+   if (low == high)
+      return low;
+
+   hash = NODEHASH(level, low, high);
+   first = VOLATILE(HASH(hash));
+
+   for (res=first ; res != 0 ; res=bddnodes[res].next)
+   {
+      node = &bddnodes[res];
+      if (LEVELp(node) == level  &&  LOWp(node) == low  &&  HIGHp(node) == high)
+	 return EDGE(res);
+   }
+
+   if (parunique == BDD_UNIQUE_OPEN)
+      return par_makenode_open(w, level, low, high);
+   
+   if (w->freepos == 0  &&  par_getnodes(w) == 0)
+   {
+      bddparabort = 1;
+      return 0;
+   }
+
+   lock = &parstripes[hash % PARSTRIPES];
+   pthread_mutex_lock(lock);
+
+   for (res=HASH(hash) ; res != first ; res=bddnodes[res].next)
+   {
+      node = &bddnodes[res];
+      if (LEVELp(node) == level  &&  LOWp(node) == low  &&  HIGHp(node) == high)
+      {
+	 pthread_mutex_unlock(lock);
+	 return EDGE(res);
+      }
+   }
+
+   res = w->freepos;
+   w->freepos = bddnodes[res].next;
+   w->freenum--;
+   w->produced++;
+   
+   node = &bddnodes[res];
+   LEVELp(node) = level;
+   LOWp(node) = low;
+   HIGHp(node) = high;
+   node->next = HASH(hash);
+   FENCE();
+   VOLATILE(HASH(hash)) = res;
+   
+   pthread_mutex_unlock(lock);
+   return EDGE(res);
+}
+
+#endif /* BDD_THREADS */
+
+
+/*************************************************************************
+  Thread settings
+*************************************************************************/
+
+int bdd_setthreads(int num)
+{
+   int old = bddthreadnum;
+
+   if (num < 1)
+      return bdd_error(BDD_RANGE);
+
+#ifdef BDD_THREADS
+   if (num != old)
+   {
+      int err;
+      
+      par_stop();
+      if (num > 1  &&  (err=par_start(num)) < 0)
+	 return err;
+   }
+#endif
+   
+   return old;
+}
+
+
+int bdd_setuniquetable(int kind)
+{
+   int old = parunique;
+
+   if (kind != BDD_UNIQUE_CHAINED  &&  kind != BDD_UNIQUE_OPEN)
+      return bdd_error(BDD_RANGE);
+
+   parunique = kind;
+   return old;
+}
+
+
+void bdd_par_done(void)
+{
+#ifdef BDD_THREADS
+   par_stop();
+#endif
+   parunique = BDD_UNIQUE_CHAINED;
+}
+
+
+/* EOF */
@@ -0,0 +1,99 @@
+/*========================================================================
+              Copyright (C) 2026 by the BuDDy contributors
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  $Header$
+  FILE:  parallel.h
+  DESCR: Work-stealing thread pool for parallel bdd operators
+  DATE:  (C) 2026
+*************************************************************************/
+
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+#ifdef BDD_THREADS
+
+#include <pthread.h>
+
+   /* Number of locks protecting the unique table */
+#define PARSTRIPES 1024
+
+struct s_BddWorker;
+
+   /* A spawned sub-calculation. The arguments a,b,c are interpreted by
+      the task function fn which also calculates the result res. */
+typedef struct s_BddTask
+{
+   BDD (*fn)(struct s_BddWorker *, struct s_BddTask *);
+   BDD a, b, c;
+   volatile int done;    /* -1: not spawned, 0: pending, 1: done */
+   volatile BDD res;
+   struct s_BddWorker *thief; /* Worker that stole the task */
+} BddTask;
+
+typedef BDD (*BddTaskFunc)(struct s_BddWorker *, BddTask *);
+
+   /* Per thread state */
+typedef struct s_BddWorker
+{
+   BddTask **tasks;      /* Deque of spawned tasks */
+   int tasksize;         /* Allocated size of the deque */
+   volatile int top;     /* Owner end of the deque */
+   volatile int base;    /* Thief end of the deque */
+   pthread_mutex_t lock; /* Taken by thieves (and the owner on conflicts) */
+   BDD freepos;          /* Private list of free nodes */
+   BDD freenum;          /* Number of nodes in the private list */
+   struct s_BddManager *manager; /* Manager of the thread pool */
+   BDD newnodes;         /* Nodes in the open addressing table */
+   long int produced;    /* Number of nodes produced by this thread */
+   unsigned int seed;    /* Seed for choosing victims */
+   unsigned int *visited; /* Bitmap of the nodes visited by this thread */
+   int visitedsize;      /* Number of words in the bitmap */
+} BddWorker;
+
+extern BDD  bdd_par_run(BddTaskFunc, BDD, BDD, BDD);
+extern void bdd_par_spawn(BddWorker *, BddTask *);
+extern BDD  bdd_par_sync(BddWorker *, BddTask *);
+extern BDD  bdd_par_makenode(BddWorker *, unsigned int, BDD, BDD);
+extern int  bdd_par_visitclear(void);
+extern unsigned int *bdd_par_visitunion(void);
+
+   /* Marks node n as visited by w. Returns zero if it was already. */
+#define PARVISIT(w,n) \
+   (((w)->visited[(n) >> 5] & (1U << ((n) & 31))) ? 0 : \
+    ((w)->visited[(n) >> 5] |= 1U << ((n) & 31), 1))
+
+#endif /* BDD_THREADS */
+
+extern void bdd_par_done(void);
+
+#endif /* _PARALLEL_H */
+
+
+/* EOF */
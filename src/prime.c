@@ -43,7 +43,7 @@
 #define Random(i) ( (lrand48() % (i)) + 1 )
 #define isEven(src) (!((src) & 0x1))
 #define hasFactor(src,n) ( (((src)!=(n)) && ((src)%(n) == 0)) )
-#define BitIsSet(src,b) ( ((src) & (1<<(b))) != 0 )
+#define BitIsSet(src,b) ( ((src) & ((bddprime)1<<(b))) != 0 )
 
 #define CHECKTIMES 20
 
@@ -128,7 +128,26 @@ static unsigned int u64_mod(UINT64 dividend, unsigned int divisor)
 }
 #endif /* BUILTIN64 */
 
-#ifdef BUILTIN64
+#if defined(BDD_INDEX64)
+   /* The product of two 64 bit numbers does not fit in 64 bits, so
+      multiply by repeated doubling modulo c instead */
+static bddprime u64_mulmod64(bddprime a, bddprime b, bddprime c)
+{
+  bddprime res = 0;
+
+  a %= c;
+  for ( ; b != 0 ; b >>= 1)
+  {
+    if (b & 0x1)
+      res = (res >= c-a) ? res-(c-a) : res+a;
+    a = (a >= c-a) ? a-(c-a) : a+a;
+  }
+
+  return res;
+}
+
+#define u64_mulmod(a,b,c) u64_mulmod64((a),(b),(c));
+#elif defined(BUILTIN64)
 #define u64_mulmod(a,b,c) ((unsigned int)( ((UINT64)a*(UINT64)b)%(UINT64)c ));
 #else
 #define u64_mulmod(a,b,c) u64_mod( u64_mul((a),(b)), (c) );
@@ -139,14 +158,14 @@ static unsigned int u64_mod(UINT64 dividend, unsigned int divisor)
   Miller Rabin check
 *************************************************************************/
 
-static unsigned int numberOfBits(unsigned int src)
+static unsigned int numberOfBits(bddprime src)
 {
   unsigned int b;
 
   if (src == 0)
     return 0;
   
-  for (b=(sizeof(unsigned int)*8)-1 ; b>0 ; --b)
+  for (b=(sizeof(bddprime)*8)-1 ; b>0 ; --b)
     if (BitIsSet(src,b))
       return b+1;
 
@@ -155,15 +174,15 @@ static unsigned int numberOfBits(unsigned int src)
 
 
 
-static int isWitness(unsigned int witness, unsigned int src)
+static int isWitness(bddprime witness, bddprime src)
 {
   unsigned int bitNum = numberOfBits(src-1)-1;
-  unsigned int d = 1;
+  bddprime d = 1;
   int i;
 
   for (i=bitNum ; i>=0 ; --i)
   {
-    unsigned int x = d;
+    bddprime x = d;
 
     d = u64_mulmod(d,d,src);
     
@@ -178,13 +197,13 @@ static int isWitness(unsigned int witness, unsigned int src)
 }
 
 
-static int isMillerRabinPrime(unsigned int src)
+static int isMillerRabinPrime(bddprime src)
 {
   int n;
 
   for (n=0 ; n<CHECKTIMES ; ++n)
   {
-    unsigned int witness = Random(src-1);
+    bddprime witness = Random(src-1);
 
     if (isWitness(witness,src))
       return 0;
@@ -198,7 +217,7 @@ static int isMillerRabinPrime(unsigned int src)
   Basic prime searching stuff
 *************************************************************************/
 
-static int hasEasyFactors(unsigned int src)
+static int hasEasyFactors(bddprime src)
 {
   return hasFactor(src, 3)
       || hasFactor(src, 5)
@@ -208,7 +227,7 @@ static int hasEasyFactors(unsigned int src)
 }
 
 
-static int isPrime(unsigned int src)
+static int isPrime(bddprime src)
 {
   if (hasEasyFactors(src))
     return 0;
@@ -221,7 +240,7 @@ static int isPrime(unsigned int src)
   External interface
 *************************************************************************/
 
-unsigned int bdd_prime_gte(unsigned int src)
+bddprime bdd_prime_gte(bddprime src)
 {
   if (isEven(src))
     ++src;
@@ -233,7 +252,7 @@ unsigned int bdd_prime_gte(unsigned int src)
 }
 
 
-unsigned int bdd_prime_lte(unsigned int src)
+bddprime bdd_prime_lte(bddprime src)
 {
   if (isEven(src))
      --src;
@@ -38,8 +38,17 @@
 #ifndef _PRIME_H
 #define _PRIME_H
 
-unsigned int bdd_prime_gte(unsigned int src);
-unsigned int bdd_prime_lte(unsigned int src);
+#include "bddconfig.h"
+
+   /* Node table sizes may exceed 32 bits with 64 bit node indices */
+#ifdef BDD_INDEX64
+typedef unsigned long long bddprime;
+#else
+typedef unsigned int bddprime;
+#endif
+
+bddprime bdd_prime_gte(bddprime src);
+bddprime bdd_prime_lte(bddprime src);
 
 
 #endif /* _PRIME_H */
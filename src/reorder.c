@@ -53,7 +53,7 @@
  */
 
    /* Change macros to reflect the above idea */
-#define VAR(n) (bddnodes[n].level)
+#define VAR(n) (bddnodes[NODE(n)].level)
 #define VARp(p) (p->level)
 
    /* Avoid these - they are misleading! */
@@ -64,61 +64,57 @@
 #define __USERESIZE /* FIXME */
 
    /* Current auto reord. method and number of automatic reorderings left */
-static int bddreordermethod;
-static int bddreordertimes;
+#define bddreordermethod (bddmanager->bddreordermethod)
+#define bddreordertimes  (bddmanager->bddreordertimes)
 
    /* Flag for disabling reordering temporarily */
-static int reorderdisabled;
+#define reorderdisabled  (bddmanager->reorderdisabled)
 
    /* Store for the variable relationships */
-static BddTree *vartree;
-static int blockid;
+#define vartree          (bddmanager->vartree)
+#define blockid          (bddmanager->blockid)
 
    /* Store for the ref.cou. of the external roots */
-static int *extroots;
-static int extrootsize;
+#define extroots         (bddmanager->extroots)
+#define extrootsize      (bddmanager->extrootsize)
 
 /* Level data */
 typedef struct _levelData
 {
-   int start;    /* Start of this sub-table (entry in "bddnodes") */
-   int size;     /* Size of this sub-table */
-   int maxsize;  /* Max. allowed size of sub-table */
-   int nodenum;  /* Number of nodes in this level */
+   BDD start;    /* Start of this sub-table (entry in "bddnodes") */
+   BDD size;     /* Size of this sub-table */
+   BDD maxsize;  /* Max. allowed size of sub-table */
+   BDD nodenum;  /* Number of nodes in this level */
 } levelData;
 
-static levelData *levels; /* Indexed by variable! */
+#define levels              (bddmanager->levels) /* Indexed by variable! */
 
    /* Interaction matrix */
-static imatrix *iactmtx;
+#define iactmtx             (bddmanager->iactmtx)
 
    /* Reordering information for the user */
-static int verbose;
-static bddinthandler reorder_handler;
-static bddfilehandler reorder_filehandler;
-static bddsizehandler reorder_nodenum;
+#define verbose             (bddmanager->verbose)
+#define reorder_handler     (bddmanager->reorder_handler)
+#define reorder_filehandler (bddmanager->reorder_filehandler)
+#define reorder_nodenum     (bddmanager->reorder_nodenum)
+#define reorderclock        (bddmanager->reorderclock)
 
    /* Number of live nodes before and after a reordering session */
-static int usednum_before;
-static int usednum_after;
-	    
-   /* Kernel variables needed for reordering */
-extern int bddfreepos;
-extern int bddfreenum;
-extern int bddproduced;
+#define usednum_before      (bddmanager->usednum_before)
+#define usednum_after       (bddmanager->usednum_after)
 
    /* Flag telling us when a node table resize is done */
-static int resizedInMakenode;
+#define resizedInMakenode   (bddmanager->resizedInMakenode)
 
    /* New node hashing function for use with reordering */
 #define NODEHASH(var,l,h) ((PAIR((l),(h))%levels[var].size)+levels[var].start)
 
    /* Reordering prototypes */
 static void blockdown(BddTree *);
-static void addref_rec(int, char *);
+static void addref_rec(BDD, char *);
 static void reorder_gbc();
 static void reorder_setLevellookup(void);
-static int  reorder_makenode(int, int, int);
+static BDD  reorder_makenode(int, BDD, BDD);
 static int  reorder_varup(int);
 static int  reorder_vardown(int);
 static int  reorder_init(void);
@@ -129,7 +125,7 @@ static void reorder_done(void);
    /* For sorting the blocks according to some specific size value */
 typedef struct s_sizePair
 {
-   int val;
+   BDD val;
    BddTree *block;
 } sizePair;
 
@@ -175,12 +171,12 @@ static BddTree *reorder_win2(BddTree *t)
       return t;
 
    if (verbose > 1)
-      printf("Win2 start: %d nodes\n", reorder_nodenum());
+      printf("Win2 start: %" PRIbdd " nodes\n", reorder_nodenum());
    fflush(stdout);
 
    while (this->next != NULL)
    {
-      int best = reorder_nodenum();
+      BDD best = reorder_nodenum();
       blockdown(this);
       
       if (best < reorder_nodenum())
@@ -200,7 +196,7 @@ static BddTree *reorder_win2(BddTree *t)
    }
    
    if (verbose > 1)
-      printf("\nWin2 end: %d nodes\n", reorder_nodenum());
+      printf("\nWin2 end: %" PRIbdd " nodes\n", reorder_nodenum());
    fflush(stdout);
 
    return first;
@@ -210,14 +206,14 @@ static BddTree *reorder_win2(BddTree *t)
 static BddTree *reorder_win2ite(BddTree *t)
 {
    BddTree *this, *first=t;
-   int lastsize;
+   BDD lastsize;
    int c=1;
    
    if (t == NULL)
       return t;
    
    if (verbose > 1)
-      printf("Win2ite start: %d nodes\n", reorder_nodenum());
+      printf("Win2ite start: %" PRIbdd " nodes\n", reorder_nodenum());
 
    do
    {
@@ -226,7 +222,7 @@ static BddTree *reorder_win2ite(BddTree *t)
       this = t;
       while (this->next != NULL)
       {
-	 int best = reorder_nodenum();
+	 BDD best = reorder_nodenum();
 
 	 blockdown(this);
 
@@ -246,7 +242,7 @@ static BddTree *reorder_win2ite(BddTree *t)
       }
 
       if (verbose > 1)
-	 printf(" %d nodes\n", reorder_nodenum());
+	 printf(" %" PRIbdd " nodes\n", reorder_nodenum());
       c++;
    }
    while (reorder_nodenum() != lastsize);
@@ -262,7 +258,7 @@ static BddTree *reorder_swapwin3(BddTree *this, BddTree **first)
 {
    int setfirst = (this->prev == NULL ? 1 : 0);
    BddTree *next = this;
-   int best = reorder_nodenum();
+   BDD best = reorder_nodenum();
    
    if (this->next->next == NULL) /* Only two blocks left -> win2 swap */
    {
@@ -400,7 +396,7 @@ static BddTree *reorder_win3(BddTree *t)
       return t;
 
    if (verbose > 1)
-      printf("Win3 start: %d nodes\n", reorder_nodenum());
+      printf("Win3 start: %" PRIbdd " nodes\n", reorder_nodenum());
    fflush(stdout);
 
    while (this->next != NULL)
@@ -415,7 +411,7 @@ static BddTree *reorder_win3(BddTree *t)
    }
    
    if (verbose > 1)
-      printf("\nWin3 end: %d nodes\n", reorder_nodenum());
+      printf("\nWin3 end: %" PRIbdd " nodes\n", reorder_nodenum());
    fflush(stdout);
 
    return first;
@@ -425,13 +421,13 @@ static BddTree *reorder_win3(BddTree *t)
 static BddTree *reorder_win3ite(BddTree *t)
 {
    BddTree *this=t, *first=t;
-   int lastsize;
+   BDD lastsize;
    
    if (t == NULL)
       return t;
    
    if (verbose > 1)
-      printf("Win3ite start: %d nodes\n", reorder_nodenum());
+      printf("Win3ite start: %" PRIbdd " nodes\n", reorder_nodenum());
 
    do
    {
@@ -450,12 +446,12 @@ static BddTree *reorder_win3ite(BddTree *t)
       }
 
       if (verbose > 1)
-	 printf(" %d nodes\n", reorder_nodenum());
+	 printf(" %" PRIbdd " nodes\n", reorder_nodenum());
    }
    while (reorder_nodenum() != lastsize);
 
    if (verbose > 1)
-      printf("Win3ite end: %d nodes\n", reorder_nodenum());
+      printf("Win3ite end: %" PRIbdd " nodes\n", reorder_nodenum());
    
    return first;
 }
@@ -468,8 +464,8 @@ static BddTree *reorder_win3ite(BddTree *t)
 */
 static void reorder_sift_bestpos(BddTree *blk, int middlePos)
 {
-   int best = reorder_nodenum();
-   int maxAllowed;
+   BDD best = reorder_nodenum();
+   BDD maxAllowed;
    int bestpos = 0;
    int dirIsUp = 1;
    int n;
@@ -596,7 +592,7 @@ static BddTree *reorder_sift_seq(BddTree *t, BddTree **seq, int num)
       reorder_sift_bestpos(seq[n], num/2);
 
       if (verbose > 1)
-	 printf("\n> %d nodes", reorder_nodenum());
+	 printf("\n> %" PRIbdd " nodes", reorder_nodenum());
 
       c2 = clock();
       if (verbose > 1)
@@ -679,7 +675,7 @@ static BddTree *reorder_sift(BddTree *t)
 static BddTree *reorder_siftite(BddTree *t)
 {
    BddTree *first=t;
-   int lastsize;
+   BDD lastsize;
    int c=1;
    
    if (t == NULL)
@@ -730,7 +726,7 @@ static BddTree *reorder_random(BddTree *t)
    free(seq);
 
    if (verbose)
-      printf("Random order: %d nodes\n", reorder_nodenum());
+      printf("Random order: %" PRIbdd " nodes\n", reorder_nodenum());
    return this;
 }
 
@@ -808,12 +804,12 @@ static void blockdown(BddTree *left)
 
 /* Note: Node may be marked
  */
-static void addref_rec(int r, char *dep)
+static void addref_rec(BDD r, char *dep)
 {
    if (r < 2)
       return;
    
-   if (bddnodes[r].refcou == 0 || MARKED(r))
+   if (bddnodes[NODE(r)].refcou == 0 || MARKED(r))
    {
       bddfreenum--;
 
@@ -865,7 +861,7 @@ static void addDependencies(char *dep)
 static int mark_roots(void)
 {
    char *dep = NEW(char,bddvarnum);
-   int n;
+   BDD n;
 
    for (n=2,extrootsize=0 ; n<bddnodesize ; n++)
    {
@@ -875,12 +871,12 @@ static int mark_roots(void)
       
       if (bddnodes[n].refcou > 0)
       {
-	 SETMARK(n);
+	 SETMARK(EDGE(n));
 	 extrootsize++;
       }
    }
    
-   if ((extroots=(int*)(malloc(sizeof(int)*extrootsize))) == NULL)
+   if ((extroots=NEW(BDD,extrootsize)) == NULL)
    {
       free(dep);
       return bdd_error(BDD_MEMORY);
@@ -909,11 +905,11 @@ static int mark_roots(void)
 
       /* Make sure the hash field is empty. This saves a loop in the
 	 initial GBC */
-      node->hash = 0;
+      HASH(n) = 0;
    }
 
-   bddnodes[0].hash = 0;
-   bddnodes[1].hash = 0;
+   HASH(0) = 0;
+   HASH(1) = 0;
 
    free(dep);
    return 0;
@@ -926,7 +922,7 @@ static int mark_roots(void)
 */
 static void reorder_gbc(void)
 {
-   int n;
+   BDD n;
 
    bddfreepos = 0;
    bddfreenum = 0;
@@ -939,11 +935,11 @@ static void reorder_gbc(void)
 
       if (node->refcou > 0)
       {
-	 register unsigned int hash;
+	 register bddhashval hash;
 	 
 	 hash = NODEHASH(VARp(node), LOWp(node), HIGHp(node));
-	 node->next = bddnodes[hash].hash;
-	 bddnodes[hash].hash = n;
+	 node->next = HASH(hash);
+	 HASH(hash) = n;
 
       }
       else
@@ -986,13 +982,13 @@ static void reorder_setLevellookup(void)
 
 static void reorder_rehashAll(void)
 {
-   int n;
+   BDD n;
 
    reorder_setLevellookup();
    bddfreepos = 0;
 
    for (n=bddnodesize-1 ; n>=0 ; n--)
-      bddnodes[n].hash = 0;
+      HASH(n) = 0;
    
    for (n=bddnodesize-1 ; n>=2 ; n--)
    {
@@ -1000,11 +996,11 @@ static void reorder_rehashAll(void)
 
       if (node->refcou > 0)
       {
-	 register unsigned int hash;
+	 register bddhashval hash;
 	 
 	 hash = NODEHASH(VARp(node), LOWp(node), HIGHp(node));
-	 node->next = bddnodes[hash].hash;
-	 bddnodes[hash].hash = n;
+	 node->next = HASH(hash);
+	 HASH(hash) = n;
       }
       else
       {
@@ -1020,12 +1016,18 @@ static void reorder_rehashAll(void)
 /* Note: rehashing must not take place during a makenode call. It is okay
    to resize the table, but *not* to rehash it.
  */
-static int reorder_makenode(int var, int low, int high)
+static BDD reorder_makenode(int var, BDD low, BDD high)
 {
    register BddNode *node;
-   register unsigned int hash;
-   register int res;
+   register bddhashval hash;
+   register BDD res;
 
+#ifdef COMPLEMENT_EDGES
+      /* Keep the low edge regular by moving the negation to the result */
+   if (ISCOMPL(low))
+      return NOT(reorder_makenode(var, NOT(low), NOT(high)));
+#endif
+   
 #ifdef CACHESTATS
    bddcachestats.uniqueAccess++;
 #endif
@@ -1042,17 +1044,18 @@ static int reorder_makenode(int var, int low, int high)
 
       /* Try to find an existing node of this kind */
    hash = NODEHASH(var, low, high);
-   res = bddnodes[hash].hash;
+   res = HASH(hash);
       
    while(res != 0)
    {
-      if (LOW(res) == low  &&  HIGH(res) == high)
+      node = &bddnodes[res];
+      if (LOWp(node) == low  &&  HIGHp(node) == high)
       {
 #ifdef CACHESTATS
 	 bddcachestats.uniqueHit++;
 #endif
-	 INCREF(res);
-	 return res;
+	 INCREFp(node);
+	 return EDGE(res);
       }
       res = bddnodes[res].next;
       
@@ -1101,15 +1104,15 @@ static int reorder_makenode(int var, int low, int high)
    HIGHp(node) = high;
 
       /* Insert node in hash chain */
-   node->next = bddnodes[hash].hash;
-   bddnodes[hash].hash = res;
+   node->next = HASH(hash);
+   HASH(hash) = res;
 
       /* Make sure it is reference counted */
    node->refcou = 1;
    INCREF(LOWp(node));
    INCREF(HIGHp(node));
    
-   return res;
+   return EDGE(res);
 }
 
 
@@ -1118,33 +1121,33 @@ static int reorder_makenode(int var, int low, int high)
 /* Go through var 0 nodes. Move nodes that depends on var 1 to a separate
  * chain (toBeProcessed) and let the rest stay in the table.
  */
-static int reorder_downSimple(int var0)
+static BDD reorder_downSimple(int var0)
 {
-   int toBeProcessed = 0;
+   BDD toBeProcessed = 0;
    int var1 = bddlevel2var[bddvar2level[var0]+1];
-   int vl0 = levels[var0].start;
-   int size0 = levels[var0].size;
-   int n;
+   BDD vl0 = levels[var0].start;
+   BDD size0 = levels[var0].size;
+   BDD n;
 
    levels[var0].nodenum = 0;
    
    for (n=0 ; n<size0 ; n++)
    {
-      int r;
+      BDD r;
 
-      r = bddnodes[n + vl0].hash;
-      bddnodes[n + vl0].hash = 0;
+      r = HASH(n + vl0);
+      HASH(n + vl0) = 0;
 
       while (r != 0)
       {
 	 BddNode *node = &bddnodes[r];
-	 int next = node->next;
+	 BDD next = node->next;
 
 	 if (VAR(LOWp(node)) != var1  &&  VAR(HIGHp(node)) != var1)
 	 {
  	       /* Node does not depend on next var, let it stay in the chain */
-	    node->next = bddnodes[n+vl0].hash;
-	    bddnodes[n+vl0].hash = r;
+	    node->next = HASH(n+vl0);
+	    HASH(n+vl0) = r;
 	    levels[var0].nodenum++;
 	 }
 	 else
@@ -1171,17 +1174,18 @@ static int reorder_downSimple(int var0)
  * It is extremely important that no rehashing is done inside the makenode
  * calls, since this would destroy the toBeProcessed chain.
  */
-static void reorder_swap(int toBeProcessed, int var0)
+static void reorder_swap(BDD toBeProcessed, int var0)
 {
    int var1 = bddlevel2var[bddvar2level[var0]+1];
    
    while (toBeProcessed)
    {
       BddNode *node = &bddnodes[toBeProcessed];
-      int next = node->next;
-      int f0 = LOWp(node);
-      int f1 = HIGHp(node);
-      int f00, f01, f10, f11, hash;
+      BDD next = node->next;
+      BDD f0 = LOWp(node);
+      BDD f1 = HIGHp(node);
+      BDD f00, f01, f10, f11;
+      bddhashval hash;
       
          /* Find the cofactors for the new nodes */
       if (VAR(f0) == var1)
@@ -1223,8 +1227,8 @@ static void reorder_swap(int toBeProcessed, int var0)
       
          /* Rehash the node since it got new childs */
       hash = NODEHASH(VARp(node), LOWp(node), HIGHp(node));
-      node->next = bddnodes[hash].hash;
-      bddnodes[hash].hash = toBeProcessed;
+      node->next = HASH(hash);
+      HASH(hash) = toBeProcessed;
 
       toBeProcessed = next;
    }
@@ -1238,25 +1242,25 @@ static void reorder_swap(int toBeProcessed, int var0)
 static void reorder_localGbc(int var0)
 {
    int var1 = bddlevel2var[bddvar2level[var0]+1];
-   int vl1 = levels[var1].start;
-   int size1 = levels[var1].size;
-   int n;
+   BDD vl1 = levels[var1].start;
+   BDD size1 = levels[var1].size;
+   BDD n;
 
    for (n=0 ; n<size1 ; n++)
    {
-      int hash = n+vl1;
-      int r = bddnodes[hash].hash;
-      bddnodes[hash].hash = 0;
+      BDD hash = n+vl1;
+      BDD r = HASH(hash);
+      HASH(hash) = 0;
 
       while (r)
       {
 	 BddNode *node = &bddnodes[r];
-	 int next = node->next;
+	 BDD next = node->next;
 
 	 if (node->refcou > 0)
 	 {
-	    node->next = bddnodes[hash].hash;
-	    bddnodes[hash].hash = r;
+	    node->next = HASH(hash);
+	    HASH(hash) = r;
 	 }
 	 else
 	 {
@@ -1280,17 +1284,17 @@ static void reorder_localGbc(int var0)
 
 #ifdef USERESIZE
 
-static void reorder_swapResize(int toBeProcessed, int var0)
+static void reorder_swapResize(BDD toBeProcessed, int var0)
 {
    int var1 = bddlevel2var[bddvar2level[var0]+1];
    
    while (toBeProcessed)
    {
       BddNode *node = &bddnodes[toBeProcessed];
-      int next = node->next;
-      int f0 = LOWp(node);
-      int f1 = HIGHp(node);
-      int f00, f01, f10, f11;
+      BDD next = node->next;
+      BDD f0 = LOWp(node);
+      BDD f1 = HIGHp(node);
+      BDD f00, f01, f10, f11;
       
          /* Find the cofactors for the new nodes */
       if (VAR(f0) == var1)
@@ -1337,23 +1341,23 @@ static void reorder_swapResize(int toBeProcessed, int var0)
 }
 
 
-static void reorder_localGbcResize(int toBeProcessed, int var0)
+static void reorder_localGbcResize(BDD toBeProcessed, int var0)
 {
    int var1 = bddlevel2var[bddvar2level[var0]+1];
-   int vl1 = levels[var1].start;
-   int size1 = levels[var1].size;
-   int n;
+   BDD vl1 = levels[var1].start;
+   BDD size1 = levels[var1].size;
+   BDD n;
 
    for (n=0 ; n<size1 ; n++)
    {
-      int hash = n+vl1;
-      int r = bddnodes[hash].hash;
-      bddnodes[hash].hash = 0;
+      BDD hash = n+vl1;
+      BDD r = HASH(hash);
+      HASH(hash) = 0;
 
       while (r)
       {
 	 BddNode *node = &bddnodes[r];
-	 int next = node->next;
+	 BDD next = node->next;
 
 	 if (node->refcou > 0)
 	 {
@@ -1389,11 +1393,11 @@ static void reorder_localGbcResize(int toBeProcessed, int var0)
    while (toBeProcessed)
    {
       BddNode *node = &bddnodes[toBeProcessed];
-      int next = node->next;
-      int hash = NODEHASH(VARp(node), LOWp(node), HIGHp(node));
+      BDD next = node->next;
+      bddhashval hash = NODEHASH(VARp(node), LOWp(node), HIGHp(node));
 	 
-      node->next = bddnodes[hash].hash;
-      bddnodes[hash].hash = toBeProcessed;
+      node->next = HASH(hash);
+      HASH(hash) = toBeProcessed;
 
       toBeProcessed = next;
    }   
@@ -1424,7 +1428,7 @@ static void sanitycheck(void)
       
       for (n=0 ; n<levels[v].size ; n++)
       {
-	 r = bddnodes[n+levels[v].start].hash;
+	 r = HASH(n+levels[v].start);
 	 
 	 while (r)
 	 {
@@ -1465,7 +1469,7 @@ static int reorder_vardown(int var)
    
    if (imatrixDepends(iactmtx, var, bddlevel2var[level+1]))
    {
-      int toBeProcessed = reorder_downSimple(var);
+      BDD toBeProcessed = reorder_downSimple(var);
 #ifdef USERESIZE
       levelData *l = &levels[var];
       
@@ -1553,20 +1557,20 @@ int bdd_swapvar(int v1, int v2)
 
 void bdd_default_reohandler(int prestate)
 {
-   static long c1;
-
    if (verbose > 0)
    {
       if (prestate)
       {
 	 printf("Start reordering\n");
-	 c1 = clock();
+	 reorderclock = clock();
       }
       else
       {
 	 long c2 = clock();
-	 printf("End reordering. Went from %d to %d nodes (%.1f sec)\n",
-		usednum_before, usednum_after, (float)(c2-c1)/CLOCKS_PER_SEC);
+	 printf("End reordering. Went from %" PRIbdd " to %" PRIbdd
+		" nodes (%.1f sec)\n",
+		usednum_before, usednum_after,
+		(float)(c2-reorderclock)/CLOCKS_PER_SEC);
       }
    }
 }
@@ -1640,14 +1644,14 @@ static int reorder_init(void)
 
 static void reorder_done(void)
 {
-   int n;
+   BDD n;
    
    for (n=0 ; n<extrootsize ; n++)
-      SETMARK(extroots[n]);
+      SETMARK(EDGE(extroots[n]));
    for (n=2 ; n<bddnodesize ; n++)
    {
-      if (MARKED(n))
-	 UNMARK(n);
+      if (MARKED(EDGE(n)))
+	 UNMARK(EDGE(n));
       else
 	 bddnodes[n].refcou = 0;
 
@@ -1671,6 +1675,10 @@ static void reorder_done(void)
    free(levels);
    imatrixDelete(iactmtx);
    bdd_gbc();
+
+      /* The gbc may keep cache entries (see bdd_setcachemode), but the
+	 levels have changed */
+   bdd_operator_reset();
 }
 
 
@@ -1771,7 +1779,7 @@ int bdd_reorder_gain(void)
    if (usednum_before == 0)
       return 0;
    
-   return (100*(usednum_before - usednum_after)) / usednum_before;
+   return (int)((100*(usednum_before - usednum_after)) / usednum_before);
 }
 
 
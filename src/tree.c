@@ -36,6 +36,7 @@
 *************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
+#include "config.h"
 #include "kernel.h"
 #include "bddtree.h"
 